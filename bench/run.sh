@@ -0,0 +1,336 @@
+#!/bin/sh
+# Benchmarks for MyCLC. Each case generates its input with a fixed-seed
+# generator, so every run and every build sees the same lines, and times
+# the binary over it: the best wall time of RUNS runs and the peak resident
+# size of any. A second binary, if given, is timed on the same inputs beside
+# the first, for before and after numbers.
+#
+# usage: sh bench/run.sh MYCLC [BASE]
+#   RUNS=N     runs per case (default 3)
+#   BENCH=re   only the cases whose names match the extended regex re
+
+DIR=$(dirname "$0")
+MYCLC=$1
+BASE=$2
+RUNS=${RUNS:-3}
+TIMEIT=${TIMEIT:-$DIR/timeit}
+
+if [ -z "$MYCLC" ]; then
+    echo "usage: sh bench/run.sh MYCLC [BASE]" >&2
+    exit 2
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# Park-Miller generator, exact in awk's doubles; rnd(n) is in [0, n)
+RAND='function rnd(n) { seed = (seed * 16807) % 2147483647; return seed % n }'
+
+# Times each binary on the input gen writes, passing them the flags after it
+bench() {
+    name=$1
+    gen=$2
+    shift 2
+    echo "$name" | grep -Eq -- "${BENCH:-.}" || return 0
+    [ -f "$WORK/$gen" ] || $gen > "$WORK/$gen"
+
+    printf '%-16s %-22s %s' "$name" "$*" "$("$TIMEIT" "$RUNS" "$WORK/$gen" "$MYCLC" "$@")"
+    [ -n "$BASE" ] && printf '   %s' "$("$TIMEIT" "$RUNS" "$WORK/$gen" "$BASE" "$@")"
+    echo
+}
+
+# 200 lines each summing 2000 small integers
+gen_small_sums() {
+    awk "$RAND"' BEGIN {
+        seed = 2
+        for (l = 0; l < 200; l++) {
+            s = "(+"
+            for (i = 0; i < 2000; i++) { s = s " " rnd(1000) }
+            print s ")"
+        }
+    }'
+}
+
+# 2000 lines of small integer arithmetic nested 60 deep
+gen_small_nested() {
+    awk "$RAND"' BEGIN {
+        seed = 3
+        split("+ - *", ops, " ")
+        for (l = 0; l < 2000; l++) {
+            s = ""
+            for (d = 0; d < 60; d++) { s = s "(" ops[rnd(3) + 1] " " rnd(10) " " }
+            s = s rnd(10)
+            for (d = 0; d < 60; d++) { s = s ")" }
+            print s
+        }
+    }'
+}
+
+# A million tail calls of small integer arithmetic, the whole run on one line
+gen_small_loop() {
+    printf '%s\n' '(def loop (\ (n acc) (if (== n 0) acc (loop (- n 1) (+ acc (* 3 n))))))' '(loop 1000000 0)'
+}
+
+# One line adding N small integers; the two sizes differ tenfold, so linear
+# evaluation shows as a tenfold time and quadratic as a hundredfold
+gen_wide() {
+    awk "$RAND"' BEGIN {
+        seed = 5
+        printf "(+"
+        for (i = 0; i < '"$1"'; i++) { printf " %d", rnd(1000) }
+        print ")"
+    }'
+}
+gen_wide_100k() { gen_wide 100000; }
+gen_wide_1m()   { gen_wide 1000000; }
+
+# 200 lines each reducing 5000 numbers, cycling through +, * (of units, so
+# the product stays small), sum and max of a Vector, and + over floats
+gen_wide_ops() {
+    awk "$RAND"' BEGIN {
+        seed = 6
+        for (l = 0; l < 200; l++) {
+            k = l % 5
+            if (k == 0) { printf "(+" } else if (k == 1) { printf "(*" }
+            else if (k == 2) { printf "(sum [" } else if (k == 3) { printf "(max [" } else { printf "(+" }
+            for (i = 0; i < 5000; i++) {
+                if (k == 1) { printf " %d", rnd(2) ? 1 : -1 }
+                else if (k == 4) { printf " %d.%d", rnd(1000), rnd(1000) }
+                else { printf " %d", rnd(2000000) - 1000000 }
+            }
+            print (k == 2 || k == 3) ? "])" : ")"
+        }
+    }'
+}
+
+# 2000 lines of about 60 tokens each: signed integers and decimals in
+# sexprs three levels deep, so the reader's share of the time is large
+gen_read() {
+    awk "$RAND"' BEGIN {
+        seed = 9
+        split("+ - * / %", ops, " ")
+        for (l = 0; l < 2000; l++) {
+            s = "(+"
+            for (a = 0; a < 4; a++) {
+                s = s " (" ops[rnd(4) + 1]
+                for (b = 0; b < 3; b++) {
+                    s = s " (* " (rnd(2) ? "-" : "") (rnd(100000) + 1)
+                    for (c = 0; c < 3; c++) { s = s " " (rnd(3) ? rnd(1000) + 1 : rnd(1000) "." rnd(1000)) }
+                    s = s ")"
+                }
+                s = s ")"
+            }
+            print s ")"
+        }
+    }'
+}
+
+# 100000 lines around the int64_t limit: sums and products that overflow
+# into bignums, and 40-digit literals multiplied by the schoolbook path
+gen_bigint() {
+    awk "$RAND"' BEGIN {
+        seed = 12
+        for (l = 0; l < 100000; l++) {
+            k = l % 3
+            if (k == 0) { printf "(- (+ 9223372036854775807 %d) %d)\n", rnd(1000), rnd(1000) }
+            else if (k == 1) { printf "(* %d %d %d)\n", rnd(2000000000), rnd(2000000000), rnd(2000000000) }
+            else {
+                a = ""; b = ""
+                for (i = 0; i < 40; i++) { a = a (rnd(9) + 1); b = b rnd(10) }
+                print "(* " a " " b ")"
+            }
+        }
+    }'
+}
+
+# A few products of operands up to a million digits long, for the
+# Karatsuba and Toom-3 paths; only a residue is printed
+gen_bigint_huge() {
+    awk 'BEGIN {
+        for (n = 1; n <= 8; n++) {
+            printf "(%% (* (^ 3 %d) (^ 7 %d)) 1000000007)\n", 250000 * n, 200000 * n
+        }
+    }'
+}
+
+# 20000 lines of float arithmetic, run as doubles and as wider bigfloats
+gen_float_ops() {
+    awk "$RAND"' BEGIN {
+        seed = 13
+        for (l = 0; l < 20000; l++) {
+            printf "(+ (* %d.%d %d.%d) (/ %d.%d %d.%d) (- %d.%d %d.%d) (^ 1.%d 7))\n", \
+                rnd(1000), rnd(1000), rnd(1000), rnd(1000), rnd(1000), rnd(1000), rnd(999) + 1, rnd(1000), \
+                rnd(1000), rnd(1000), rnd(1000), rnd(1000), rnd(1000)
+        }
+    }'
+}
+
+# One line reducing an N x N matrix product to a scalar between a row and a
+# column of ones, or with OP "+" the same line doing O(N^2) work instead,
+# which times the reading and printing around the product
+gen_matmul() {
+    awk "$RAND"' BEGIN {
+        seed = 14
+        n = '"$1"'
+        ones = "["
+        for (j = 0; j < n; j++) { ones = ones " 1" }
+        printf "(matmul %s;] (%s", ones, "'"$2"'"
+        for (m = 0; m < 2; m++) {
+            printf " ["
+            for (i = 0; i < n; i++) {
+                for (j = 0; j < n; j++) { printf " %d", rnd(10) }
+                printf ";"
+            }
+            printf "]"
+        }
+        printf ") ["
+        for (j = 0; j < n; j++) { printf " 1;" }
+        print "])"
+    }'
+}
+
+# 200 lines each scaling a Vector of 5000 floats, so a million floats are
+# printed, most of them needing 16 or 17 digits
+gen_floats() {
+    awk "$RAND"' BEGIN {
+        seed = 8
+        for (l = 0; l < 200; l++) {
+            printf "(* ["
+            for (i = 0; i < 5000; i++) { printf " %d.%de%d", rnd(9) + 1, rnd(1000000), rnd(80) - 40 }
+            print "] 1.1)"
+        }
+    }'
+}
+
+# One line of N additions, each nested inside the next, closed only at
+# the end; the reader, evaluator, printer and free all go N levels deep
+gen_deep() {
+    awk 'BEGIN {
+        for (i = 0; i < '"$1"'; i++) { printf "(+ 1 " }
+        printf "0"
+        for (i = 0; i < '"$1"'; i++) { printf ")" }
+        print ""
+    }'
+}
+gen_deep_100k() { gen_deep 100000; }
+gen_deep_1m()   { gen_deep 1000000; }
+
+# 50000 lines cycling through 50 expressions of depth 6, as a job that
+# recomputes the same formulas line after line would
+gen_repeat() {
+    awk "$RAND"' BEGIN {
+        seed = 7
+        split("+ - *", ops, " ")
+        for (k = 0; k < 50; k++) {
+            s = ""
+            for (d = 0; d < 6; d++) { s = s "(" ops[rnd(3) + 1] " " rnd(100) " " }
+            s = s rnd(100)
+            for (d = 0; d < 6; d++) { s = s ")" }
+            lines[k] = s
+        }
+        for (l = 0; l < 50000; l++) { print lines[l % 50] }
+    }'
+}
+
+# A doubly recursive function, called about 2.7 million times
+gen_fib() {
+    printf '%s\n' '(def fib (\ (n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2))))))' '(fib 30)'
+}
+
+# A million tail calls split over 5000 pmap values, then as many again in
+# the function preduce folds with, which adds its two arguments and a term
+# that always comes to zero, so it stays associative
+gen_parallel() {
+    printf '%s\n' '(def work (\ (n acc) (if (== n 0) acc (work (- n 1) (+ acc n)))))' \
+        '(sum (pmap (\ (x) (work 200 x)) (range 5000)))' \
+        '(preduce (\ (a b) (+ a b (- (work 100 b) (work 100 b)))) (range 5000))'
+}
+
+# Times a case with 1, 2, 4 ... threads and then one per CPU, for how far
+# the pool scales
+bench_threads() {
+    name=$1
+    gen=$2
+    cpus=$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1)
+    t=1
+    while [ "$t" -lt "$cpus" ]; do
+        bench "$name" "$gen" --threads="$t"
+        t=$((t * 2))
+    done
+    bench "$name" "$gen" --threads="$cpus"
+}
+
+# GFLOP/s of one binary's N x N matrix product, from two inputs written by
+# gen_matmul: the time with the product less the time without it
+gflops() {
+    with=$("$TIMEIT" "$RUNS" "$3.mul" "$1" | awk '{ print $1 }')
+    without=$("$TIMEIT" "$RUNS" "$3.add" "$1" | awk '{ print $1 }')
+    awk -v n="$2" -v t1="$with" -v t0="$without" 'BEGIN {
+        if (t1 > t0) { printf "%13.2f GFLOP/s", 2 * n * n * n / (t1 - t0) / 1e9 } else { printf "%22s", "-" }
+    }'
+}
+
+bench_matmul() {
+    name=$1
+    echo "$name" | grep -Eq -- "${BENCH:-.}" || return 0
+    gen_matmul "$2" matmul > "$WORK/$name.mul"
+    gen_matmul "$2" + > "$WORK/$name.add"
+
+    printf '%-16s %-22s %s' "$name" "" "$(gflops "$MYCLC" "$2" "$WORK/$name")"
+    [ -n "$BASE" ] && printf '   %s' "$(gflops "$BASE" "$2" "$WORK/$name")"
+    echo
+    rm -f "$WORK/$name.mul" "$WORK/$name.add"
+}
+
+printf '%-16s %-22s %22s' "case" "flags" "$MYCLC"
+[ -n "$BASE" ] && printf '   %22s' "$BASE"
+echo
+
+# Small integers, carried in the lval pointer rather than the arena
+bench small_sums     gen_small_sums
+bench small_nested   gen_small_nested
+bench small_loop     gen_small_loop
+
+# Wide S-Expressions, whose arguments are consumed by index
+bench wide_100k      gen_wide_100k
+bench wide_1m        gen_wide_1m
+bench wide_ops       gen_wide_ops
+
+# Integers past int64_t
+bench bigint         gen_bigint
+bench bigint_huge    gen_bigint_huge
+
+# Float printing
+bench floats         gen_floats
+
+# Multi-precision floats against doubles
+bench float_ops      gen_float_ops    --precision=53
+bench float_ops      gen_float_ops    --precision=128
+bench float_ops      gen_float_ops    --precision=1024
+
+# Matrix products, cache-blocked and spread over the worker pool
+bench_matmul matmul_256   256
+bench_matmul matmul_1024  1024
+bench_matmul matmul_2048  2048
+bench_matmul matmul_4096  4096
+
+# pmap and preduce on the work-stealing pool, from one thread to all of them
+bench_threads parallel     gen_parallel
+
+# The hand-written reader against the two mpc readers
+bench read           gen_read         --reader=native
+bench read           gen_read         --reader=fold
+bench read           gen_read         --reader=ast
+
+# Deep nesting, walked with explicit work stacks rather than the C stack
+bench deep_100k      gen_deep_100k
+bench deep_1m        gen_deep_1m
+bench deep_1m        gen_deep_1m      --engine=vm
+
+# The tree walker against the bytecode VM
+bench repeat         gen_repeat       --engine=tree
+bench repeat         gen_repeat       --engine=vm
+bench small_loop     gen_small_loop   --engine=tree
+bench small_loop     gen_small_loop   --engine=vm
+bench fib            gen_fib          --engine=tree
+bench fib            gen_fib          --engine=vm
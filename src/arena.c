@@ -0,0 +1,208 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+// Every allocation is rounded up to this alignment
+#define ARENA_ALIGN 16
+
+// Each thread switches arenas on its own; all start on the default one
+static arena default_arena;
+static __thread arena* current = &default_arena;
+
+arena* arena_use(arena* a) {
+    arena* prev = current;
+    current = a;
+    return prev;
+}
+
+#ifdef MYCLC_MALLOC
+
+void* arena_alloc(size_t size) { return malloc(size); }
+
+void* arena_realloc(void* p, size_t old_size, size_t new_size) {
+    (void)old_size;
+    return realloc(p, new_size);
+}
+
+void arena_free(void* p, size_t size) {
+    (void)size;
+    free(p);
+}
+
+char* arena_strdup(const char* s) {
+    char* c = malloc(strlen(s) + 1);
+    strcpy(c, s);
+    return c;
+}
+
+void arena_strfree(char* s) { free(s); }
+
+void arena_reset(void) {}
+
+#else
+
+// Size class k holds objects of up to (ARENA_ALIGN << k) bytes, -1 if too big
+static int arena_class(size_t size) {
+    size_t n = ARENA_ALIGN;
+    for (int k = 0; k < ARENA_CLASSES; k++, n <<= 1) {
+        if (size <= n) { return k; }
+    }
+    return -1;
+}
+
+static arena_chunk* arena_chunk_new(size_t size) {
+    arena_chunk* c = malloc(sizeof(arena_chunk) + size);
+    if (c == NULL) { abort(); }
+    c->next = NULL;
+    c->size = size;
+    return c;
+}
+
+// Bump size bytes out of the current chunk, moving on to the next retained
+// chunk (or a fresh one) when it runs out
+static void* arena_bump(size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    // Oversized requests get their own block, freed wholesale on reset
+    if (size > ARENA_CHUNK_SIZE / 4) {
+        arena_chunk* c = arena_chunk_new(size);
+        c->next = current->large;
+        current->large = c;
+        return c->data;
+    }
+
+    if ((size_t)(current->end - current->ptr) < size) {
+        arena_chunk* c;
+        if (current->chunk == NULL) {
+            c = current->first = arena_chunk_new(ARENA_CHUNK_SIZE);
+        } else if (current->chunk->next != NULL) {
+            c = current->chunk->next;
+        } else {
+            c = current->chunk->next = arena_chunk_new(ARENA_CHUNK_SIZE);
+        }
+        current->chunk = c;
+        current->ptr   = c->data;
+        current->end   = c->data + c->size;
+    }
+
+    void* p = current->ptr;
+    current->ptr += size;
+    return p;
+}
+
+static void arena_lock(arena* a) {
+    while (__atomic_test_and_set(&a->lock, __ATOMIC_ACQUIRE)) {}
+}
+
+static void arena_unlock(arena* a) { __atomic_clear(&a->lock, __ATOMIC_RELEASE); }
+
+static void arena_block_link(arena_block* b) {
+    arena* a = b->owner;
+    arena_lock(a);
+    b->prev = NULL;
+    b->next = a->blocks;
+    if (a->blocks != NULL) { a->blocks->prev = b; }
+    a->blocks = b;
+    arena_unlock(a);
+}
+
+static void arena_block_unlink(arena_block* b) {
+    arena* a = b->owner;
+    arena_lock(a);
+    if (b->prev != NULL) { b->prev->next = b->next; } else { a->blocks = b->next; }
+    if (b->next != NULL) { b->next->prev = b->prev; }
+    arena_unlock(a);
+}
+
+// A block too big for any size class, owned by the current arena
+static void* arena_block_new(size_t size) {
+    arena_block* b = malloc(sizeof(arena_block) + size);
+    if (b == NULL) { abort(); }
+    b->owner = current;
+    b->size = size;
+    arena_block_link(b);
+    return b + 1;
+}
+
+void* arena_alloc(size_t size) {
+    int k = arena_class(size);
+    if (k < 0) { return arena_block_new(size); }
+
+    // Reuse a freed object of the same class before bumping a new one
+    void* p = current->free_list[k];
+    if (p != NULL) {
+        current->free_list[k] = *(void**)p;
+        return p;
+    }
+    return arena_bump((size_t)ARENA_ALIGN << k);
+}
+
+void* arena_realloc(void* p, size_t old_size, size_t new_size) {
+    if (p == NULL) { return arena_alloc(new_size); }
+
+    // Growing within the same class is free
+    int k = arena_class(old_size);
+    if (k >= 0 && k == arena_class(new_size)) { return p; }
+
+    // As is moving a block that stays too big for the classes, with realloc
+    if (k < 0 && arena_class(new_size) < 0) {
+        arena_block* b = (arena_block*)p - 1;
+        arena_block_unlink(b);
+        b = realloc(b, sizeof(arena_block) + new_size);
+        if (b == NULL) { abort(); }
+        b->size = new_size;
+        arena_block_link(b);
+        return b + 1;
+    }
+
+    void* q = arena_alloc(new_size);
+    memcpy(q, p, old_size < new_size ? old_size : new_size);
+    arena_free(p, old_size);
+    return q;
+}
+
+void arena_free(void* p, size_t size) {
+    if (p == NULL) { return; }
+    int k = arena_class(size);
+    if (k < 0) {
+        arena_block* b = (arena_block*)p - 1;
+        arena_block_unlink(b);
+        free(b);
+        return;
+    }
+    *(void**)p = current->free_list[k];
+    current->free_list[k] = p;
+}
+
+char* arena_strdup(const char* s) {
+    size_t n = strlen(s) + 1;
+    char* c = arena_bump(n);
+    memcpy(c, s, n);
+    return c;
+}
+
+void arena_strfree(char* s) { (void)s; }
+
+void arena_reset(void) {
+    // Large blocks are rare; the chunk list itself is kept for reuse
+    while (current->large != NULL) {
+        arena_chunk* c = current->large;
+        current->large = c->next;
+        free(c);
+    }
+    while (current->blocks != NULL) {
+        arena_block* b = current->blocks;
+        current->blocks = b->next;
+        free(b);
+    }
+
+    current->chunk = current->first;
+    if (current->first != NULL) {
+        current->ptr = current->first->data;
+        current->end = current->first->data + current->first->size;
+    }
+    memset(current->free_list, 0, sizeof(current->free_list));
+}
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef MYCLC_ARENA_H
+#define MYCLC_ARENA_H
+
+#include <stddef.h>
+
+// Evaluation arena. Fixed-size objects (lvals, cell arrays) come from
+// size-classed slabs and are recycled through per-class free lists, while
+// strings are bumped out of the current chunk. Blocks too big for any class
+// come straight from malloc and go straight back on arena_free, so a loop
+// that keeps replacing a large Vector runs in constant memory. arena_reset()
+// drops everything without walking a result tree, so the REPL never frees
+// results one lval at a time.
+//
+// Build with -DMYCLC_MALLOC to route everything through plain malloc/free,
+// which keeps valgrind and ASan useful when debugging.
+
+#define ARENA_CHUNK_SIZE (64 * 1024)
+#define ARENA_CLASSES    12
+
+typedef struct arena_chunk {
+    struct arena_chunk* next;
+    size_t size;
+    char data[];
+} arena_chunk;
+
+// Header of a block too big for any size class, listed in the arena that
+// made it while it is live. Another thread may free it, so the list is
+// guarded by the arena's lock.
+typedef struct arena_block {
+    struct arena_block* prev;
+    struct arena_block* next;
+    struct arena* owner;
+    size_t size;
+} arena_block;
+
+typedef struct arena {
+    arena_chunk* first;
+    arena_chunk* chunk;
+    char* ptr;
+    char* end;
+    arena_chunk* large;
+    arena_block* blocks;
+    char lock;
+    void* free_list[ARENA_CLASSES];
+} arena;
+
+// Switch the arena the calling thread uses for the calls below, returning
+// the previous one
+arena* arena_use(arena* a);
+
+// Size-classed allocation; objects may be handed back with arena_free
+void* arena_alloc(size_t size);
+void* arena_realloc(void* p, size_t old_size, size_t new_size);
+void  arena_free(void* p, size_t size);
+
+// Bump allocation for strings; only released by arena_reset
+char* arena_strdup(const char* s);
+void  arena_strfree(char* s);
+
+// Release everything allocated from the current arena. Slab and string
+// memory is rewound without visiting the objects in it; only the blocks too
+// big for a size class are walked, each freed back to malloc.
+void arena_reset(void);
+
+#endif
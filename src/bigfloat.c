@@ -0,0 +1,498 @@
+#include <ctype.h>
+#include <math.h>
+#include <string.h>
+
+#include "arena.h"
+#include "bigfloat.h"
+#include "dtoa.h"
+
+// Largest decimal exponent a literal may have, inside BIGFLOAT_EXP_MAX
+#define BIGFLOAT_EXP10_MAX 1000000
+
+// Largest exact power bigfloat_pow builds before squaring instead, in bits
+#define BIGFLOAT_POW_EXACT (1 << 20)
+
+int bigfloat_prec = BIGFLOAT_PREC_DOUBLE;
+
+void bigfloat_free(bigfloat* x) {
+    bigint_free(&x->m);
+}
+
+// m * 2^e rounded half to even to prec bits, taking over m. sticky says
+// non-zero bits below m were already dropped; callers that set it leave at
+// least two bits below the rounding point, so it only ever breaks ties.
+static bigfloat bf_round(bigint m, int64_t e, int sticky, int prec) {
+    int neg = m.neg;
+    m.neg = 0;
+
+    int bits = bigint_bits(&m);
+    if (bits > prec) {
+        int shift = bits - prec;
+        int half = bigint_bit(&m, shift - 1);
+        int rest = sticky || bigint_ctz(&m) < shift - 1;
+        bigint_shr(&m, shift);
+        e += shift;
+        if (half && (rest || bigint_bit(&m, 0))) {
+            uint64_t limb;
+            bigint one = bigint_view_i64(1, &limb);
+            bigint t = bigint_add(&m, &one);
+            bigint_free(&m);
+            m = t;
+        }
+    }
+
+    // Rounding up may have carried into a new power of two; the strip folds
+    // it back to prec bits
+    int tz = bigint_ctz(&m);
+    bigint_shr(&m, tz);
+    e += tz;
+    if (m.len == 0) { e = 0; }
+    m.neg = neg && m.len > 0;
+
+    bigfloat r = { m, e, prec };
+    return r;
+}
+
+// Whether x lies within the exponent range; frees it if not
+static int bf_check(bigfloat* x) {
+    int64_t top = x->e + bigint_bits(&x->m);
+    if (x->m.len == 0 || (top <= BIGFLOAT_EXP_MAX && top >= -BIGFLOAT_EXP_MAX)) { return 1; }
+    bigfloat_free(x);
+    return 0;
+}
+
+// a / b * 2^e, with enough quotient bits below the rounding point for the
+// remainder to act as a sticky bit
+static bigfloat bf_quotient(const bigint* a, const bigint* b, int64_t e) {
+    int k = bigfloat_prec + 2 + bigint_bits(b) - bigint_bits(a);
+    if (k < 0) { k = 0; }
+
+    bigint n = bigint_shl(a, k), r;
+    bigint q = bigint_div(&n, b, &r);
+    int sticky = r.len > 0;
+    bigint_free(&n);
+    bigint_free(&r);
+    return bf_round(q, e - k, sticky, bigfloat_prec);
+}
+
+int bigfloat_from_big(const bigint* x, bigfloat* out) {
+    *out = bf_round(bigint_copy(x), 0, 0, bigfloat_prec);
+    return bf_check(out);
+}
+
+int bigfloat_from_rat(const bigint* num, const bigint* den, bigfloat* out) {
+    *out = bf_quotient(num, den, 0);
+    return bf_check(out);
+}
+
+int bigfloat_from_double(double x, bigfloat* out) {
+    if (!isfinite(x)) { return 0; }
+
+    // Every double is a 53-bit integer times a power of two
+    int exp;
+    double f = frexp(x, &exp);
+    *out = bf_round(bigint_from_i128((int64_t)ldexp(f, 53)), (int64_t)exp - 53, 0, bigfloat_prec);
+    return 1;
+}
+
+int bigfloat_parse(const char* s, int len, bigfloat* out) {
+    const char* end = s + len;
+    int neg = *s == '-';
+    if (neg) { s++; }
+
+    // The digits with the point taken out, and the power of ten they need
+    char* digits = arena_alloc(len + 1);
+    int n = 0;
+    long exp10 = 0;
+    while (s < end && isdigit((unsigned char)*s)) { digits[n++] = *s++; }
+    if (s < end && *s == '.') {
+        for (s++; s < end && isdigit((unsigned char)*s); s++) {
+            digits[n++] = *s;
+            exp10--;
+        }
+    }
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        int exp_neg = *++s == '-';
+        if (*s == '-' || *s == '+') { s++; }
+        long x = 0;
+        for (; s < end; s++) {
+            if (x < 100000000) { x = x * 10 + (*s - '0'); }
+        }
+        exp10 += exp_neg ? -x : x;
+    }
+
+    // Terminated, as bigint_parse looks for a radix prefix
+    digits[n] = '\0';
+    bigint d = bigint_parse(digits, n);
+    arena_free(digits, len + 1);
+    d.neg = neg && d.len > 0;
+    if (d.len == 0) {
+        *out = bf_round(d, 0, 0, bigfloat_prec);
+        return 1;
+    }
+    if (exp10 > BIGFLOAT_EXP10_MAX || exp10 < -BIGFLOAT_EXP10_MAX) {
+        bigint_free(&d);
+        return 0;
+    }
+
+    // Exact scaling up, or one correctly rounded division
+    uint64_t limb;
+    bigint ten = bigint_view_i64(10, &limb);
+    bigint p = bigint_pow(&ten, exp10 < 0 ? -exp10 : exp10);
+    if (exp10 >= 0) {
+        *out = bf_round(bigint_mul(&d, &p), 0, 0, bigfloat_prec);
+    } else {
+        *out = bf_quotient(&d, &p, 0);
+    }
+    bigint_free(&p);
+    bigint_free(&d);
+    return bf_check(out);
+}
+
+double bigfloat_to_double(const bigfloat* x) {
+    // Rounded to 53 bits first, the mantissa converts exactly
+    bigfloat r = bf_round(bigint_copy(&x->m), x->e, 0, 53);
+    int64_t m;
+    bigint_to_i64(&r.m, &m);
+    int64_t e = r.e < -4096 ? -4096 : r.e > 4096 ? 4096 : r.e;
+    bigfloat_free(&r);
+    return ldexp((double)m, (int)e);
+}
+
+bigfloat bigfloat_neg(const bigfloat* x) {
+    return bf_round(bigint_neg(&x->m), x->e, 0, bigfloat_prec);
+}
+
+bigfloat bigfloat_add(const bigfloat* a, const bigfloat* b) {
+    if (b->m.len == 0) { return bf_round(bigint_copy(&a->m), a->e, 0, bigfloat_prec); }
+    if (a->m.len == 0) { return bf_round(bigint_copy(&b->m), b->e, 0, bigfloat_prec); }
+
+    // x is the operand reaching the higher bit
+    const bigfloat* x = a;
+    const bigfloat* y = b;
+    if (b->e + bigint_bits(&b->m) > a->e + bigint_bits(&a->m)) {
+        x = b;
+        y = a;
+    }
+
+    // Widened to three bits past the rounding point, x has a lowest bit of
+    // 2^low. A y entirely below that can only tip x off a tie or an exact
+    // value, which a half unit of the same sign at 2^(low - 1) does alike,
+    // so a far smaller y never has to be lined up bit for bit.
+    int s = bigfloat_prec + 3 - bigint_bits(&x->m);
+    if (s < 0) { s = 0; }
+    int64_t low = x->e - s;
+    if (y->e + bigint_bits(&y->m) <= low) {
+        uint64_t limb;
+        bigint half = bigint_view_i64(y->m.neg ? -1 : 1, &limb);
+        bigint t = bigint_shl(&x->m, s + 1);
+        bigint r = bigint_add(&t, &half);
+        bigint_free(&t);
+        return bf_round(r, low - 1, 0, bigfloat_prec);
+    }
+
+    // Otherwise the two overlap closely enough to add exactly
+    int64_t e = a->e < b->e ? a->e : b->e;
+    bigint ta = bigint_shl(&a->m, (int)(a->e - e));
+    bigint tb = bigint_shl(&b->m, (int)(b->e - e));
+    bigint r = bigint_add(&ta, &tb);
+    bigint_free(&ta);
+    bigint_free(&tb);
+    return bf_round(r, e, 0, bigfloat_prec);
+}
+
+bigfloat bigfloat_sub(const bigfloat* a, const bigfloat* b) {
+    // b negated as a view of its limbs
+    bigfloat nb = *b;
+    nb.m.cap = 0;
+    nb.m.neg = b->m.len > 0 && !b->m.neg;
+    return bigfloat_add(a, &nb);
+}
+
+int bigfloat_mul(const bigfloat* a, const bigfloat* b, bigfloat* out) {
+    *out = bf_round(bigint_mul(&a->m, &b->m), a->e + b->e, 0, bigfloat_prec);
+    return bf_check(out);
+}
+
+int bigfloat_div(const bigfloat* a, const bigfloat* b, bigfloat* out) {
+    *out = bf_quotient(&a->m, &b->m, a->e - b->e);
+    return bf_check(out);
+}
+
+int bigfloat_mod(const bigfloat* a, const bigfloat* b, bigfloat* out) {
+    bigint r, q;
+    int64_t e;
+    if (a->e >= b->e) {
+        // |a| may be vastly larger than |b|: the power of two in
+        // a = ma * 2^(ea - eb) * 2^eb is reduced mod mb before multiplying
+        uint64_t limb;
+        bigint two = bigint_view_i64(2, &limb);
+        bigint d = bigint_from_i128(a->e - b->e);
+        bigint p = bigint_powmod(&two, &d, &b->m);
+        bigint t = bigint_mul(&a->m, &p);
+        q = bigint_div(&t, &b->m, &r);
+        bigint_free(&d);
+        bigint_free(&p);
+        bigint_free(&t);
+        e = b->e;
+    } else if (a->e + bigint_bits(&a->m) < b->e + bigint_bits(&b->m)) {
+        // |a| < |b|
+        r = bigint_copy(&a->m);
+        q = bigint_from_i128(0);
+        e = a->e;
+    } else {
+        // Lining b up on a's exponent shifts it by less than a's length
+        bigint tb = bigint_shl(&b->m, (int)(b->e - a->e));
+        q = bigint_div(&a->m, &tb, &r);
+        bigint_free(&tb);
+        e = a->e;
+    }
+    bigint_free(&q);
+    *out = bf_round(r, e, 0, bigfloat_prec);
+    return bf_check(out);
+}
+
+int bigfloat_pow(const bigfloat* x, uint64_t n, int negative, bigfloat* out) {
+    // 2^lg <= |x| < 2^(lg + 1), so |x^n| is between 2^(lg n) and 2^((lg + 1) n)
+    uint64_t bits = bigint_bits(&x->m), total;
+    int64_t lg = (int64_t)bits - 1 + x->e, lo, hi, e;
+    if (x->m.len > 0 && n > 0 &&
+        (n > INT64_MAX || __builtin_mul_overflow(lg, (int64_t)n, &lo) ||
+         __builtin_mul_overflow(lg + 1, (int64_t)n, &hi) ||
+         lo > BIGFLOAT_EXP_MAX || hi < -BIGFLOAT_EXP_MAX)) {
+        return 0;
+    }
+
+    // The exact power of the mantissa, then a single rounding
+    if (bits <= 1 || (!__builtin_mul_overflow(bits - 1, n, &total) && total <= BIGFLOAT_POW_EXACT)) {
+        if (__builtin_mul_overflow(x->e, (int64_t)n, &e)) { return 0; }
+        bigint p = bigint_pow(&x->m, n);
+        if (!negative) {
+            *out = bf_round(p, e, 0, bigfloat_prec);
+        } else {
+            uint64_t limb;
+            bigint one = bigint_view_i64(1, &limb);
+            *out = bf_quotient(&one, &p, -e);
+            bigint_free(&p);
+        }
+        return bf_check(out);
+    }
+
+    // Squaring at a raised precision. Each product is off by at most half a
+    // unit of the extended mantissa, and n multiplications add up to less
+    // than 2^64 of those.
+    int prec = bigfloat_prec;
+    bigfloat_prec = prec + 72;
+    bigfloat acc = bf_round(bigint_from_i128(1), 0, 0, bigfloat_prec);
+    bigfloat sq  = bf_round(bigint_copy(&x->m), x->e, 0, bigfloat_prec);
+    int ok = 1;
+    for (uint64_t k = n; ok; ) {
+        bigfloat t;
+        if (k & 1) {
+            ok = bigfloat_mul(&acc, &sq, &t);
+            bigfloat_free(&acc);
+            acc = t;
+            if (!ok) { break; }
+        }
+        if ((k >>= 1) == 0) { break; }
+        ok = bigfloat_mul(&sq, &sq, &t);
+        bigfloat_free(&sq);
+        sq = t;
+    }
+    if (ok && negative) {
+        bigfloat one = bf_round(bigint_from_i128(1), 0, 0, bigfloat_prec), t;
+        ok = bigfloat_div(&one, &acc, &t);
+        bigfloat_free(&one);
+        bigfloat_free(&acc);
+        acc = t;
+    }
+    bigfloat_free(&sq);
+    bigfloat_prec = prec;
+    if (!ok) { return 0; }
+
+    *out = bf_round(acc.m, acc.e, 0, prec);
+    return 1;
+}
+
+// Most digits the shortest form can need at prec bits
+static int bf_digits_max(int prec) {
+    return (int)(prec * 0.30102999566398120) + 3;
+}
+
+int bigfloat_format_size(const bigfloat* x) {
+    // Sign, then dtoa_layout's overhead, then the NUL
+    return bf_digits_max(x->prec) + 26;
+}
+
+// x * k, for k that fits an int64
+static bigint bf_times(const bigint* x, int64_t k) {
+    uint64_t limb;
+    bigint v = bigint_view_i64(k, &limb);
+    return bigint_mul(x, &v);
+}
+
+// *x = *x * k
+static void bf_scale(bigint* x, int64_t k) {
+    bigint t = bf_times(x, k);
+    bigint_free(x);
+    *x = t;
+}
+
+int bigfloat_format(const bigfloat* x, char* buffer) {
+    char* p = buffer;
+    if (x->m.len == 0) {
+        strcpy(p, "0.0");
+        return 3;
+    }
+    if (x->m.neg) { *p++ = '-'; }
+
+    // Free-format shortest output (Steele and White's Dragon4 as refined by
+    // Burger and Dybvig): v = r / s, and the values halfway to the
+    // neighbouring floats are (r - mm) / s and (r + mp) / s. Digits are
+    // generated until the number so far is inside that interval. The
+    // mantissa is widened to exactly prec bits to find the neighbours.
+    bigint f = x->m;
+    f.cap = 0;
+    f.neg = 0;
+    int shift = x->prec - bigint_bits(&f);
+    int64_t e = x->e - shift;
+    int pow2 = bigint_bits(&f) == 1;
+    int even = shift > 0 || !bigint_bit(&f, 0);
+
+    uint64_t limb;
+    bigint one = bigint_view_i64(1, &limb);
+    bigint r, s, mp, mm;
+    if (e >= 0) {
+        r  = bigint_shl(&f, (int)(shift + e + (pow2 ? 2 : 1)));
+        s  = bigint_from_i128(pow2 ? 4 : 2);
+        mp = bigint_shl(&one, (int)(e + (pow2 ? 1 : 0)));
+        mm = bigint_shl(&one, (int)e);
+    } else {
+        r  = bigint_shl(&f, shift + (pow2 ? 2 : 1));
+        s  = bigint_shl(&one, (int)((pow2 ? 2 : 1) - e));
+        mp = bigint_from_i128(pow2 ? 2 : 1);
+        mm = bigint_from_i128(1);
+    }
+
+    // v < 10^k, from an estimate that can only come out one short
+    int k = (int)ceil((double)(x->e + bigint_bits(&f) - 1) * 0.30102999566398120 - 1e-9);
+    bigint ten = bigint_view_i64(10, &limb);
+    bigint tk = bigint_pow(&ten, k < 0 ? -k : k);
+    if (k >= 0) {
+        bigint t = bigint_mul(&s, &tk);
+        bigint_free(&s);
+        s = t;
+    } else {
+        bigint t = bigint_mul(&r, &tk);
+        bigint_free(&r);
+        r = t;
+        t = bigint_mul(&mp, &tk);
+        bigint_free(&mp);
+        mp = t;
+        t = bigint_mul(&mm, &tk);
+        bigint_free(&mm);
+        mm = t;
+    }
+    bigint_free(&tk);
+
+    while (1) {
+        bigint t = bigint_add(&r, &mp);
+        int c = bigint_cmp(&t, &s);
+        bigint_free(&t);
+        if (even ? c < 0 : c <= 0) { break; }
+        bf_scale(&s, 10);
+        k++;
+    }
+
+    char* digits = arena_alloc(bf_digits_max(x->prec) + 1);
+    int n = 0;
+
+    // Up to eighteen digits per division while the end is not among them
+    // (shortest forms rarely come in more than four digits short of the
+    // maximum). Each stopping condition, once met, stays met for every later
+    // digit, so a block that ends short of both never passed through either.
+    int blocks_end = bf_digits_max(x->prec) - 4;
+    while (blocks_end - n >= 2) {
+        int b = blocks_end - n < 18 ? blocks_end - n : 18;
+        int64_t scale = 1;
+        for (int i = 0; i < b; i++) { scale *= 10; }
+
+        bigint r2 = bf_times(&r, scale);
+        bigint mp2 = bf_times(&mp, scale);
+        bigint mm2 = bf_times(&mm, scale);
+        bigint rem;
+        bigint q = bigint_div(&r2, &s, &rem);
+        bigint_free(&r2);
+
+        bigint t = bigint_add(&rem, &mp2);
+        int stop = bigint_cmp(&rem, &mm2) <= 0 || bigint_cmp(&t, &s) >= 0;
+        bigint_free(&t);
+        uint64_t block = q.len > 0 ? q.d[0] : 0;
+        bigint_free(&q);
+        if (stop) {
+            bigint_free(&rem);
+            bigint_free(&mp2);
+            bigint_free(&mm2);
+            break;
+        }
+
+        for (int i = b - 1; i >= 0; i--) {
+            digits[n + i] = (char)('0' + block % 10);
+            block /= 10;
+        }
+        n += b;
+        bigint_free(&r);
+        bigint_free(&mp);
+        bigint_free(&mm);
+        r = rem;
+        mp = mp2;
+        mm = mm2;
+    }
+
+    while (1) {
+        bf_scale(&r, 10);
+        bf_scale(&mp, 10);
+        bf_scale(&mm, 10);
+
+        bigint rem;
+        bigint q = bigint_div(&r, &s, &rem);
+        int d = q.len > 0 ? (int)q.d[0] : 0;
+        bigint_free(&q);
+        bigint_free(&r);
+        r = rem;
+
+        int cl = bigint_cmp(&r, &mm);
+        bigint t = bigint_add(&r, &mp);
+        int ch = bigint_cmp(&t, &s);
+        bigint_free(&t);
+        int low  = even ? cl <= 0 : cl < 0;
+        int high = even ? ch >= 0 : ch > 0;
+
+        if (!low && !high && n < bf_digits_max(x->prec)) {
+            digits[n++] = (char)('0' + d);
+            continue;
+        }
+
+        // Last digit: round up when only that stays inside, or when it is
+        // the nearer of the two (ties to even)
+        if (low && high) {
+            bigint r2 = bigint_add(&r, &r);
+            int c = bigint_cmp(&r2, &s);
+            bigint_free(&r2);
+            if (c > 0 || (c == 0 && (d & 1))) { d++; }
+        } else if (high) {
+            d++;
+        }
+        digits[n++] = (char)('0' + d);
+        break;
+    }
+    bigint_free(&r);
+    bigint_free(&s);
+    bigint_free(&mp);
+    bigint_free(&mm);
+
+    p += dtoa_layout(digits, n, k - n, p);
+    *p = '\0';
+    arena_free(digits, bf_digits_max(x->prec) + 1);
+    return (int)(p - buffer);
+}
@@ -0,0 +1,59 @@
+#ifndef MYCLC_BIGFLOAT_H
+#define MYCLC_BIGFLOAT_H
+
+#include "bigint.h"
+
+// Multi-precision binary floats: m * 2^e, with m rounded half to even to the
+// working precision and stripped of trailing zero bits, so each value has a
+// single representation. prec remembers the precision a value was rounded
+// to, which decides how many digits it prints with.
+
+// At the default precision float literals are read as plain doubles
+#define BIGFLOAT_PREC_DOUBLE 53
+#define BIGFLOAT_PREC_MIN    2
+#define BIGFLOAT_PREC_MAX    65536
+
+// Magnitudes stay within 2^-BIGFLOAT_EXP_MAX .. 2^BIGFLOAT_EXP_MAX, about
+// 10^+-1.26 million, which keeps printing them affordable. The functions
+// returning int fail with 0 on results outside it (and on non-finite
+// doubles).
+#define BIGFLOAT_EXP_MAX     (1 << 22)
+
+typedef struct bigfloat {
+    bigint m;
+    int64_t e;
+    int prec;
+} bigfloat;
+
+// Working precision, in bits, of everything below
+extern int bigfloat_prec;
+
+void   bigfloat_free(bigfloat* x);
+
+// Conversions round once; den must not be zero
+int    bigfloat_from_big(const bigint* x, bigfloat* out);
+int    bigfloat_from_rat(const bigint* num, const bigint* den, bigfloat* out);
+int    bigfloat_from_double(double x, bigfloat* out);
+int    bigfloat_parse(const char* s, int len, bigfloat* out);
+double bigfloat_to_double(const bigfloat* x);
+
+// Correctly rounded arithmetic. b must not be zero for div and mod, where
+// mod is the truncated remainder (exact, like fmod).
+bigfloat bigfloat_neg(const bigfloat* x);
+bigfloat bigfloat_add(const bigfloat* a, const bigfloat* b);
+bigfloat bigfloat_sub(const bigfloat* a, const bigfloat* b);
+int      bigfloat_mul(const bigfloat* a, const bigfloat* b, bigfloat* out);
+int      bigfloat_div(const bigfloat* a, const bigfloat* b, bigfloat* out);
+int      bigfloat_mod(const bigfloat* a, const bigfloat* b, bigfloat* out);
+
+// x^n, or x^-n if negative (x then non-zero). Rounded once while the exact
+// power of the mantissa stays small; past that, by squaring with 72 guard
+// bits, which only misrounds results within 2^-8 units of a tie.
+int      bigfloat_pow(const bigfloat* x, uint64_t n, int negative, bigfloat* out);
+
+// Shortest text that reads back as x at its precision, laid out like a
+// double. bigfloat_format_size is an upper bound including the NUL.
+int      bigfloat_format_size(const bigfloat* x);
+int      bigfloat_format(const bigfloat* x, char* buffer);
+
+#endif
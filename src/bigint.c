@@ -0,0 +1,751 @@
+#include <math.h>
+#include <string.h>
+
+#include "arena.h"
+#include "bigint.h"
+#include "intlit.h"
+
+typedef unsigned __int128 u128;
+
+// Operand sizes, in limbs, at which multiplication moves on to the next
+// algorithm, from timing products of random operands at -O2
+#define BIGINT_KARATSUBA 32
+#define BIGINT_TOOM3     256
+
+static uint64_t* limbs_alloc(int n) {
+    return arena_alloc(sizeof(uint64_t) * n);
+}
+
+static void limbs_free(uint64_t* d, int n) {
+    arena_free(d, sizeof(uint64_t) * n);
+}
+
+static bigint bigint_alloc(int cap) {
+    if (cap < 1) { cap = 1; }
+    bigint r = { 0, 0, cap, limbs_alloc(cap) };
+    return r;
+}
+
+// Drops leading zero limbs; zero is never negative
+static void bigint_trim(bigint* x) {
+    while (x->len > 0 && x->d[x->len - 1] == 0) { x->len--; }
+    if (x->len == 0) { x->neg = 0; }
+}
+
+// Views (cap 0) borrow their limbs and are never freed
+void bigint_free(bigint* x) {
+    if (x->cap > 0) { limbs_free(x->d, x->cap); }
+    x->d   = NULL;
+    x->len = x->cap = 0;
+}
+
+bigint bigint_from_i128(__int128 x) {
+    u128 m = x < 0 ? -(u128)x : (u128)x;
+    bigint r = bigint_alloc(2);
+    r.neg  = x < 0;
+    r.d[0] = (uint64_t)m;
+    r.d[1] = (uint64_t)(m >> 64);
+    r.len  = 2;
+    bigint_trim(&r);
+    return r;
+}
+
+bigint bigint_copy(const bigint* x) {
+    bigint r = bigint_alloc(x->len);
+    memcpy(r.d, x->d, sizeof(uint64_t) * x->len);
+    r.neg = x->neg;
+    r.len = x->len;
+    return r;
+}
+
+bigint bigint_view_i64(int64_t x, uint64_t* limb) {
+    *limb = x < 0 ? -(uint64_t)x : (uint64_t)x;
+    bigint r = { x < 0, *limb != 0, 0, limb };
+    return r;
+}
+
+// Limbs [from, from + n) of a, clipped to its length, as a non-negative view
+static bigint bigint_slice(const uint64_t* a, int an, int from, int n) {
+    if (from + n > an) { n = an - from; }
+    bigint r = { 0, n > 0 ? n : 0, 0, (uint64_t*)a + from };
+    bigint_trim(&r);
+    return r;
+}
+
+int bigint_to_i64(const bigint* x, int64_t* out) {
+    if (x->len == 0) { *out = 0; return 1; }
+    if (x->len > 1) { return 0; }
+    if (!x->neg && x->d[0] <= (uint64_t)INT64_MAX) { *out = (int64_t)x->d[0]; return 1; }
+    if (x->neg && x->d[0] <= (uint64_t)INT64_MAX + 1) { *out = (int64_t)-x->d[0]; return 1; }
+    return 0;
+}
+
+int bigint_to_i128(const bigint* x, __int128* out) {
+    if (x->len > 2) { return 0; }
+    u128 m = x->len > 0 ? x->d[0] : 0;
+    if (x->len > 1) { m |= (u128)x->d[1] << 64; }
+
+    u128 limit = (u128)1 << 127;
+    if (m > limit || (m == limit && !x->neg)) { return 0; }
+    *out = x->neg ? (__int128)(0 - m) : (__int128)m;
+    return 1;
+}
+
+double bigint_to_double(const bigint* x) {
+    if (x->len == 0) { return 0.0; }
+
+    // The top 64 bits, with everything below folded into a sticky low bit,
+    // round to 53 bits exactly as the whole value would
+    int top = x->len - 1;
+    int s = __builtin_clzll(x->d[top]);
+    uint64_t lo = top > 0 ? x->d[top - 1] : 0;
+    uint64_t hi = x->d[top] << s;
+    if (s > 0) { hi |= lo >> (64 - s); }
+    int sticky = (lo << s) != 0;
+    for (int i = top - 2; i >= 0 && !sticky; i--) { sticky = x->d[i] != 0; }
+
+    double v = ldexp((double)(hi | sticky), top * 64 - s);
+    return x->neg ? -v : v;
+}
+
+static int mag_cmp(const uint64_t* a, int an, const uint64_t* b, int bn) {
+    if (an != bn) { return an < bn ? -1 : 1; }
+    for (int i = an - 1; i >= 0; i--) {
+        if (a[i] != b[i]) { return a[i] < b[i] ? -1 : 1; }
+    }
+    return 0;
+}
+
+int bigint_cmp(const bigint* a, const bigint* b) {
+    if (a->neg != b->neg) { return a->neg ? -1 : 1; }
+    int c = mag_cmp(a->d, a->len, b->d, b->len);
+    return a->neg ? -c : c;
+}
+
+// r[0..an) = a + b for an >= bn, returning the carry out
+static uint64_t mag_add(uint64_t* r, const uint64_t* a, int an, const uint64_t* b, int bn) {
+    uint64_t carry = 0;
+    int i = 0;
+    for (; i < bn; i++) {
+        u128 t = (u128)a[i] + b[i] + carry;
+        r[i]  = (uint64_t)t;
+        carry = (uint64_t)(t >> 64);
+    }
+    for (; i < an; i++) {
+        u128 t = (u128)a[i] + carry;
+        r[i]  = (uint64_t)t;
+        carry = (uint64_t)(t >> 64);
+    }
+    return carry;
+}
+
+// r[0..an) = a - b for a >= b
+static void mag_sub(uint64_t* r, const uint64_t* a, int an, const uint64_t* b, int bn) {
+    uint64_t borrow = 0;
+    for (int i = 0; i < an; i++) {
+        uint64_t y = i < bn ? b[i] : 0;
+        uint64_t t = a[i] - y - borrow;
+        borrow = a[i] < y || a[i] - y < borrow;
+        r[i] = t;
+    }
+}
+
+// r[0..rn) += a[0..an), where the sum is known to fit
+static void mag_add_into(uint64_t* r, int rn, const uint64_t* a, int an) {
+    uint64_t carry = mag_add(r, r, an, a, an);
+    for (int i = an; carry && i < rn; i++) { carry = ++r[i] == 0; }
+}
+
+// r[0..rn) -= a[0..an), where r >= a
+static void mag_sub_from(uint64_t* r, int rn, const uint64_t* a, int an) {
+    uint64_t borrow = 0;
+    for (int i = 0; i < an; i++) {
+        uint64_t t = r[i] - a[i] - borrow;
+        borrow = r[i] < a[i] || r[i] - a[i] < borrow;
+        r[i] = t;
+    }
+    for (int i = an; borrow && i < rn; i++) { borrow = r[i]-- == 0; }
+}
+
+// q[0..n) = a / d for a single limb d, returning the remainder; q may be a
+static uint64_t mag_divmod_small(uint64_t* q, const uint64_t* a, int n, uint64_t d) {
+    uint64_t rem = 0;
+    for (int i = n - 1; i >= 0; i--) {
+        u128 cur = ((u128)rem << 64) | a[i];
+        q[i] = (uint64_t)(cur / d);
+        rem  = (uint64_t)(cur % d);
+    }
+    return rem;
+}
+
+// a + b, or a - b when negate is set
+static bigint bigint_add_signed(const bigint* a, const bigint* b, int negate) {
+    int bneg = b->len > 0 && (b->neg ^ negate);
+    bigint r;
+
+    if (a->neg == bneg || a->len == 0) {
+        const bigint* x = a->len >= b->len ? a : b;
+        const bigint* y = a->len >= b->len ? b : a;
+        r = bigint_alloc(x->len + 1);
+        r.d[x->len] = mag_add(r.d, x->d, x->len, y->d, y->len);
+        r.len = x->len + 1;
+        r.neg = a->len > 0 ? a->neg : bneg;
+    } else if (mag_cmp(a->d, a->len, b->d, b->len) >= 0) {
+        r = bigint_alloc(a->len);
+        mag_sub(r.d, a->d, a->len, b->d, b->len);
+        r.len = a->len;
+        r.neg = a->neg;
+    } else {
+        r = bigint_alloc(b->len);
+        mag_sub(r.d, b->d, b->len, a->d, a->len);
+        r.len = b->len;
+        r.neg = bneg;
+    }
+
+    bigint_trim(&r);
+    return r;
+}
+
+bigint bigint_add(const bigint* a, const bigint* b) { return bigint_add_signed(a, b, 0); }
+bigint bigint_sub(const bigint* a, const bigint* b) { return bigint_add_signed(a, b, 1); }
+
+bigint bigint_neg(const bigint* x) {
+    bigint r = bigint_copy(x);
+    r.neg = x->len > 0 && !x->neg;
+    return r;
+}
+
+// x /= d in place, for a d that is known to divide x
+static void bigint_divexact_small(bigint* x, uint64_t d) {
+    mag_divmod_small(x->d, x->d, x->len, d);
+    bigint_trim(x);
+}
+
+static void mag_mul(uint64_t* r, const uint64_t* a, int an, const uint64_t* b, int bn);
+
+// r[0..an+bn) = a * b
+static void mag_mul_basecase(uint64_t* r, const uint64_t* a, int an, const uint64_t* b, int bn) {
+    memset(r, 0, sizeof(uint64_t) * (an + bn));
+    for (int j = 0; j < bn; j++) {
+        uint64_t carry = 0;
+        for (int i = 0; i < an; i++) {
+            u128 t = (u128)a[i] * b[j] + r[i + j] + carry;
+            r[i + j] = (uint64_t)t;
+            carry    = (uint64_t)(t >> 64);
+        }
+        r[an + j] = carry;
+    }
+}
+
+// For an well beyond bn: multiplies b by bn-limb pieces of a, so every
+// product the faster algorithms see is balanced
+static void mag_mul_unbalanced(uint64_t* r, const uint64_t* a, int an, const uint64_t* b, int bn) {
+    uint64_t* t = limbs_alloc(2 * bn);
+    memset(r, 0, sizeof(uint64_t) * (an + bn));
+    for (int i = 0; i < an; i += bn) {
+        int n = an - i < bn ? an - i : bn;
+        mag_mul(t, b, bn, a + i, n);
+        mag_add_into(r + i, an + bn - i, t, bn + n);
+    }
+    limbs_free(t, 2 * bn);
+}
+
+// a = a1 B^k + a0, b = b1 B^k + b0:
+// a b = a1 b1 B^2k + ((a0 + a1)(b0 + b1) - a0 b0 - a1 b1) B^k + a0 b0
+static void mag_mul_karatsuba(uint64_t* r, const uint64_t* a, int an, const uint64_t* b, int bn) {
+    int k = (an + 1) / 2;
+    if (bn <= k) {
+        mag_mul_unbalanced(r, a, an, b, bn);
+        return;
+    }
+    int a1n = an - k, b1n = bn - k;
+
+    uint64_t* sa = limbs_alloc(4 * k + 4);
+    uint64_t* sb = sa + k + 1;
+    uint64_t* z1 = sb + k + 1;
+    sa[k] = mag_add(sa, a, k, a + k, a1n);
+    sb[k] = mag_add(sb, b, k, b + k, b1n);
+
+    // a0 b0 and a1 b1 go straight into their places in r
+    mag_mul(r, a, k, b, k);
+    mag_mul(r + 2 * k, a + k, a1n, b + k, b1n);
+    mag_mul(z1, sa, k + 1, sb, k + 1);
+    mag_sub_from(z1, 2 * k + 2, r, 2 * k);
+    mag_sub_from(z1, 2 * k + 2, r + 2 * k, a1n + b1n);
+
+    int z1n = 2 * k + 2;
+    while (z1n > 0 && z1[z1n - 1] == 0) { z1n--; }
+    mag_add_into(r + k, an + bn - k, z1, z1n);
+
+    limbs_free(sa, 4 * k + 4);
+}
+
+// Adds the non-negative x, shifted up by shift limbs, into r[0..rn)
+static void mag_add_shifted(uint64_t* r, int rn, const bigint* x, int shift) {
+    if (x->len > 0) { mag_add_into(r + shift, rn - shift, x->d, x->len); }
+}
+
+// Three-way split, evaluated at 0, 1, -1, -2 and infinity, with Bodrato's
+// interpolation sequence. The intermediate values can go negative, so this
+// works on signed bigints rather than raw limbs.
+static void mag_mul_toom3(uint64_t* r, const uint64_t* a, int an, const uint64_t* b, int bn) {
+    int k = (an + 2) / 3;
+    bigint a0 = bigint_slice(a, an, 0, k), a1 = bigint_slice(a, an, k, k), a2 = bigint_slice(a, an, 2 * k, k);
+    bigint b0 = bigint_slice(b, bn, 0, k), b1 = bigint_slice(b, bn, k, k), b2 = bigint_slice(b, bn, 2 * k, k);
+    bigint t, u;
+
+    t = bigint_add(&a0, &a2);
+    bigint ap1 = bigint_add(&t, &a1);
+    bigint am1 = bigint_sub(&t, &a1);
+    bigint_free(&t);
+    t = bigint_add(&am1, &a2);
+    u = bigint_add(&t, &t);
+    bigint am2 = bigint_sub(&u, &a0);
+    bigint_free(&t);
+    bigint_free(&u);
+
+    t = bigint_add(&b0, &b2);
+    bigint bp1 = bigint_add(&t, &b1);
+    bigint bm1 = bigint_sub(&t, &b1);
+    bigint_free(&t);
+    t = bigint_add(&bm1, &b2);
+    u = bigint_add(&t, &t);
+    bigint bm2 = bigint_sub(&u, &b0);
+    bigint_free(&t);
+    bigint_free(&u);
+
+    bigint r0   = bigint_mul(&a0, &b0);
+    bigint r1   = bigint_mul(&ap1, &bp1);
+    bigint rm1  = bigint_mul(&am1, &bm1);
+    bigint rm2  = bigint_mul(&am2, &bm2);
+    bigint rinf = bigint_mul(&a2, &b2);
+    bigint_free(&ap1);
+    bigint_free(&am1);
+    bigint_free(&am2);
+    bigint_free(&bp1);
+    bigint_free(&bm1);
+    bigint_free(&bm2);
+
+    // r3 = (rm2 - r1) / 3
+    bigint r3 = bigint_sub(&rm2, &r1);
+    bigint_divexact_small(&r3, 3);
+
+    // r1 = (r1 - rm1) / 2
+    t = bigint_sub(&r1, &rm1);
+    bigint_divexact_small(&t, 2);
+    bigint_free(&r1);
+    r1 = t;
+
+    // r2 = rm1 - r0
+    bigint r2 = bigint_sub(&rm1, &r0);
+
+    // r3 = (r2 - r3) / 2 + 2 rinf
+    t = bigint_sub(&r2, &r3);
+    bigint_divexact_small(&t, 2);
+    u = bigint_add(&rinf, &rinf);
+    bigint_free(&r3);
+    r3 = bigint_add(&t, &u);
+    bigint_free(&t);
+    bigint_free(&u);
+
+    // r2 = r2 + r1 - rinf
+    t = bigint_add(&r2, &r1);
+    bigint_free(&r2);
+    r2 = bigint_sub(&t, &rinf);
+    bigint_free(&t);
+
+    // r1 = r1 - r3
+    t = bigint_sub(&r1, &r3);
+    bigint_free(&r1);
+    r1 = t;
+
+    // Every coefficient of the product is non-negative again by now
+    int rn = an + bn;
+    memset(r, 0, sizeof(uint64_t) * rn);
+    mag_add_shifted(r, rn, &r0, 0);
+    mag_add_shifted(r, rn, &r1, k);
+    mag_add_shifted(r, rn, &r2, 2 * k);
+    mag_add_shifted(r, rn, &r3, 3 * k);
+    mag_add_shifted(r, rn, &rinf, 4 * k);
+
+    bigint_free(&r0);
+    bigint_free(&r1);
+    bigint_free(&r2);
+    bigint_free(&r3);
+    bigint_free(&rm1);
+    bigint_free(&rm2);
+    bigint_free(&rinf);
+}
+
+// r[0..an+bn) = a * b, picking the algorithm by the smaller operand
+static void mag_mul(uint64_t* r, const uint64_t* a, int an, const uint64_t* b, int bn) {
+    if (an < bn) {
+        const uint64_t* t = a; a = b; b = t;
+        int n = an; an = bn; bn = n;
+    }
+
+    if (bn < BIGINT_KARATSUBA) {
+        mag_mul_basecase(r, a, an, b, bn);
+    } else if (an >= 2 * bn) {
+        mag_mul_unbalanced(r, a, an, b, bn);
+    } else if (bn < BIGINT_TOOM3) {
+        mag_mul_karatsuba(r, a, an, b, bn);
+    } else {
+        mag_mul_toom3(r, a, an, b, bn);
+    }
+}
+
+bigint bigint_mul(const bigint* a, const bigint* b) {
+    if (a->len == 0 || b->len == 0) { return bigint_alloc(0); }
+
+    bigint r = bigint_alloc(a->len + b->len);
+    mag_mul(r.d, a->d, a->len, b->d, b->len);
+    r.len = a->len + b->len;
+    r.neg = a->neg ^ b->neg;
+    bigint_trim(&r);
+    return r;
+}
+
+// q[0..un-vn] = u / v for vn >= 2 and u >= v (Knuth, TAOCP 4.3.1, algorithm
+// D), and r[0..vn) = u % v unless r is NULL
+static void mag_div_knuth(uint64_t* q, uint64_t* r, const uint64_t* u, int un, const uint64_t* v, int vn) {
+    uint64_t* vs = limbs_alloc(vn + un + 1);
+    uint64_t* us = vs + vn;
+
+    // Shift both so the divisor's top bit is set; qhat is then at most two
+    // too large
+    int s = __builtin_clzll(v[vn - 1]);
+    for (int i = vn - 1; i > 0; i--) { vs[i] = (v[i] << s) | (s ? v[i - 1] >> (64 - s) : 0); }
+    vs[0] = v[0] << s;
+    us[un] = s ? u[un - 1] >> (64 - s) : 0;
+    for (int i = un - 1; i > 0; i--) { us[i] = (u[i] << s) | (s ? u[i - 1] >> (64 - s) : 0); }
+    us[0] = u[0] << s;
+
+    for (int j = un - vn; j >= 0; j--) {
+        u128 num  = ((u128)us[j + vn] << 64) | us[j + vn - 1];
+        u128 qhat = num / vs[vn - 1];
+        u128 rhat = num % vs[vn - 1];
+        while ((qhat >> 64) != 0 || qhat * vs[vn - 2] > ((rhat << 64) | us[j + vn - 2])) {
+            qhat--;
+            rhat += vs[vn - 1];
+            if ((rhat >> 64) != 0) { break; }
+        }
+
+        // Multiply and subtract
+        uint64_t carry = 0, borrow = 0;
+        for (int i = 0; i < vn; i++) {
+            u128 p = (u128)(uint64_t)qhat * vs[i] + carry;
+            uint64_t pl = (uint64_t)p;
+            uint64_t t  = us[i + j] - pl - borrow;
+            borrow = us[i + j] < pl || us[i + j] - pl < borrow;
+            carry  = (uint64_t)(p >> 64);
+            us[i + j] = t;
+        }
+        int negative = us[j + vn] < carry + borrow;
+        us[j + vn] -= carry + borrow;
+        q[j] = (uint64_t)qhat;
+
+        // qhat was one too large: add the divisor back
+        if (negative) {
+            q[j]--;
+            us[j + vn] += mag_add(us + j, us + j, vn, vs, vn);
+        }
+    }
+
+    // What is left of u is the remainder, still shifted
+    for (int i = 0; r != NULL && i < vn; i++) {
+        r[i] = (us[i] >> s) | (s ? us[i + 1] << (64 - s) : 0);
+    }
+
+    limbs_free(vs, vn + un + 1);
+}
+
+bigint bigint_div(const bigint* a, const bigint* b, bigint* rem) {
+    if (mag_cmp(a->d, a->len, b->d, b->len) < 0) {
+        if (rem != NULL) { *rem = bigint_copy(a); }
+        return bigint_alloc(0);
+    }
+
+    bigint q = bigint_alloc(a->len);
+    if (rem != NULL) { *rem = bigint_alloc(b->len); }
+    if (b->len == 1) {
+        uint64_t r = mag_divmod_small(q.d, a->d, a->len, b->d[0]);
+        if (rem != NULL) { rem->d[0] = r; }
+    } else {
+        mag_div_knuth(q.d, rem != NULL ? rem->d : NULL, a->d, a->len, b->d, b->len);
+    }
+    q.len = a->len - b->len + 1;
+    q.neg = a->neg ^ b->neg;
+    bigint_trim(&q);
+
+    // The remainder takes the sign of the dividend
+    if (rem != NULL) {
+        rem->len = b->len;
+        rem->neg = a->neg;
+        bigint_trim(rem);
+    }
+    return q;
+}
+
+static uint64_t gcd_u64(uint64_t u, uint64_t v) {
+    if (u == 0) { return v; }
+    if (v == 0) { return u; }
+
+    int shift = __builtin_ctzll(u | v);
+    u >>= __builtin_ctzll(u);
+    do {
+        v >>= __builtin_ctzll(v);
+        if (u > v) { uint64_t t = u; u = v; v = t; }
+        v -= u;
+    } while (v != 0);
+    return u << shift;
+}
+
+// Trailing zero bits of a non-zero magnitude
+static int mag_ctz(const uint64_t* a) {
+    int i = 0;
+    while (a[i] == 0) { i++; }
+    return i * 64 + __builtin_ctzll(a[i]);
+}
+
+void bigint_shr(bigint* x, int bits) {
+    int limbs = bits / 64, s = bits % 64;
+    if (limbs >= x->len) {
+        x->len = 0;
+        bigint_trim(x);
+        return;
+    }
+    for (int i = 0; i + limbs < x->len; i++) {
+        uint64_t hi = i + limbs + 1 < x->len ? x->d[i + limbs + 1] : 0;
+        x->d[i] = (x->d[i + limbs] >> s) | (s ? hi << (64 - s) : 0);
+    }
+    x->len -= limbs;
+    bigint_trim(x);
+}
+
+bigint bigint_gcd(const bigint* a, const bigint* b) {
+    if (a->len == 0 || b->len == 0) {
+        bigint r = bigint_copy(a->len == 0 ? b : a);
+        r.neg = 0;
+        return r;
+    }
+
+    // Binary (Stein) GCD: strip the common factors of two, then subtract the
+    // smaller odd value from the larger until they meet. Once both fit in a
+    // limb it finishes on plain integers.
+    bigint u = bigint_copy(a), v = bigint_copy(b);
+    u.neg = v.neg = 0;
+    int ua = mag_ctz(u.d), va = mag_ctz(v.d);
+    int shift = ua < va ? ua : va;
+    bigint_shr(&u, ua);
+    bigint_shr(&v, va);
+
+    while (v.len > 0 && (u.len > 1 || v.len > 1)) {
+        if (mag_cmp(u.d, u.len, v.d, v.len) > 0) { bigint t = u; u = v; v = t; }
+        mag_sub(v.d, v.d, v.len, u.d, u.len);
+        bigint_trim(&v);
+        if (v.len > 0) { bigint_shr(&v, mag_ctz(v.d)); }
+    }
+    if (v.len > 0) {
+        u.d[0] = gcd_u64(u.d[0], v.d[0]);
+        u.len = 1;
+    }
+    bigint_free(&v);
+
+    // Put the common twos back
+    bigint r = bigint_alloc(u.len + shift / 64 + 1);
+    memset(r.d, 0, sizeof(uint64_t) * r.cap);
+    int limbs = shift / 64, s = shift % 64;
+    for (int i = 0; i < u.len; i++) {
+        r.d[i + limbs] |= u.d[i] << s;
+        if (s) { r.d[i + limbs + 1] = u.d[i] >> (64 - s); }
+    }
+    r.len = r.cap;
+    bigint_trim(&r);
+    bigint_free(&u);
+    return r;
+}
+
+int bigint_ctz(const bigint* x) {
+    return x->len > 0 ? mag_ctz(x->d) : 0;
+}
+
+int bigint_bit(const bigint* x, int i) {
+    return i / 64 < x->len && ((x->d[i / 64] >> (i % 64)) & 1);
+}
+
+bigint bigint_shl(const bigint* x, int bits) {
+    int limbs = bits / 64, s = bits % 64;
+    bigint r = bigint_alloc(x->len + limbs + 1);
+    memset(r.d, 0, sizeof(uint64_t) * limbs);
+    r.d[x->len + limbs] = 0;
+    for (int i = x->len - 1; i >= 0; i--) {
+        r.d[i + limbs + 1] |= s ? x->d[i] >> (64 - s) : 0;
+        r.d[i + limbs] = x->d[i] << s;
+    }
+    r.len = x->len + limbs + 1;
+    r.neg = x->neg;
+    bigint_trim(&r);
+    return r;
+}
+
+int bigint_bits(const bigint* x) {
+    if (x->len == 0) { return 0; }
+    return x->len * 64 - __builtin_clzll(x->d[x->len - 1]);
+}
+
+bigint bigint_pow(const bigint* x, uint64_t e) {
+    bigint r = bigint_from_i128(1);
+    if (e == 0) { return r; }
+
+    // From the top bit down, so every multiply is by x rather than by a
+    // growing square
+    for (int bit = 63 - __builtin_clzll(e); bit >= 0; bit--) {
+        bigint t = bigint_mul(&r, &r);
+        bigint_free(&r);
+        r = t;
+        if ((e >> bit) & 1) {
+            t = bigint_mul(&r, x);
+            bigint_free(&r);
+            r = t;
+        }
+    }
+    return r;
+}
+
+// a * b mod m for a, b < m
+static uint64_t mulmod_u64(uint64_t a, uint64_t b, uint64_t m) {
+#if defined(__x86_64__) && defined(__GNUC__)
+    // The high half of the product is below m, so a single divq cannot
+    // overflow, which saves the libgcc call a 128-bit % would make
+    uint64_t q, r;
+    __asm__("mulq %3\n\tdivq %4" : "=a"(q), "=&d"(r) : "a"(a), "rm"(b), "rm"(m) : "cc");
+    (void)q;
+    return r;
+#else
+    return (uint64_t)((u128)a * b % m);
+#endif
+}
+
+// a * b mod m, all non-negative
+static bigint bigint_mulmod(const bigint* a, const bigint* b, const bigint* m) {
+    bigint p = bigint_mul(a, b), r;
+    bigint q = bigint_div(&p, m, &r);
+    bigint_free(&q);
+    bigint_free(&p);
+    return r;
+}
+
+bigint bigint_powmod(const bigint* b, const bigint* e, const bigint* m) {
+    bigint mod = *m;
+    mod.cap = 0;
+    mod.neg = 0;
+
+    // The base, brought into [0, m)
+    bigint x;
+    bigint q = bigint_div(b, &mod, &x);
+    bigint_free(&q);
+    if (x.neg) {
+        bigint t = bigint_add(&x, &mod);
+        bigint_free(&x);
+        x = t;
+    }
+
+    if (mod.len == 1) {
+        // Right to left over the exponent's bits
+        uint64_t n = mod.d[0], base = x.len > 0 ? x.d[0] : 0, r = 1 % n;
+        for (int i = 0; i < e->len; i++) {
+            uint64_t bits = e->d[i];
+            for (int j = 0; j < 64 && (bits != 0 || i < e->len - 1); j++) {
+                if (bits & 1) { r = mulmod_u64(r, base, n); }
+                base = mulmod_u64(base, base, n);
+                bits >>= 1;
+            }
+        }
+        bigint_free(&x);
+        return bigint_from_i128(r);
+    }
+
+    // Left to right, so the multiplies are by the reduced base
+    bigint r = bigint_from_i128(1);
+    for (int bit = bigint_bits(e) - 1; bit >= 0; bit--) {
+        bigint t = bigint_mulmod(&r, &r, &mod);
+        bigint_free(&r);
+        r = t;
+        if ((e->d[bit / 64] >> (bit % 64)) & 1) {
+            t = bigint_mulmod(&r, &x, &mod);
+            bigint_free(&r);
+            r = t;
+        }
+    }
+    bigint_free(&x);
+    return r;
+}
+
+bigint bigint_parse(const char* s, int len) {
+    int neg = len > 0 && s[0] == '-';
+    if (neg) { s++; len--; }
+    int skip;
+    int radix = intlit_radix(s, &skip);
+    s   += skip;
+    len -= skip;
+
+    // Digits are taken in chunks of as many as fit in a limb, so every limb
+    // holds at least one chunk
+    int per_chunk = radix == 10 ? 19 : radix == 16 ? 15 : radix == 8 ? 21 : 63;
+    bigint r = bigint_alloc(len / per_chunk + 1);
+    for (int i = 0; i < len; ) {
+        uint64_t chunk = 0, scale = 1;
+        for (int end = i + per_chunk < len ? i + per_chunk : len; i < end; i++) {
+            int c = s[i];
+            chunk = chunk * radix + (uint64_t)(c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+            scale *= radix;
+        }
+
+        for (int j = 0; j < r.len; j++) {
+            u128 t = (u128)r.d[j] * scale + chunk;
+            r.d[j] = (uint64_t)t;
+            chunk  = (uint64_t)(t >> 64);
+        }
+        if (chunk != 0) { r.d[r.len++] = chunk; }
+    }
+
+    r.neg = neg;
+    bigint_trim(&r);
+    return r;
+}
+
+int bigint_format_size(const bigint* x) {
+    // 20 digits cover a limb, plus the sign and the NUL
+    return x->len * 20 + 2;
+}
+
+int bigint_format(const bigint* x, char* buffer) {
+    if (x->len == 0) {
+        strcpy(buffer, "0");
+        return 1;
+    }
+
+    // Peel 19 digits at a time off the bottom, filling the buffer backwards
+    uint64_t* t = limbs_alloc(x->len);
+    memcpy(t, x->d, sizeof(uint64_t) * x->len);
+    int n = x->len;
+    char* end = buffer + bigint_format_size(x) - 1;
+    char* p = end;
+
+    while (n > 0) {
+        uint64_t chunk = mag_divmod_small(t, t, n, 10000000000000000000ull);
+        while (n > 0 && t[n - 1] == 0) { n--; }
+        for (int i = 0; i < 19 && (n > 0 || chunk != 0); i++) {
+            *--p = (char)('0' + chunk % 10);
+            chunk /= 10;
+        }
+    }
+    if (x->neg) { *--p = '-'; }
+    limbs_free(t, x->len);
+
+    int len = (int)(end - p);
+    memmove(buffer, p, len);
+    buffer[len] = '\0';
+    return len;
+}
@@ -0,0 +1,72 @@
+#ifndef MYCLC_BIGINT_H
+#define MYCLC_BIGINT_H
+
+#include <stdint.h>
+
+// Arbitrary-precision integers, for results that no longer fit in an int64.
+// The magnitude is little-endian 64-bit limbs with no leading zero limbs, so
+// zero has len 0 and is never negative. Limbs come from the evaluation arena.
+typedef struct bigint {
+    int neg;
+    int len;
+    int cap;
+    uint64_t* d;
+} bigint;
+
+bigint bigint_from_i128(__int128 x);
+bigint bigint_copy(const bigint* x);
+void   bigint_free(bigint* x);
+
+// A bigint over a single limb of caller storage, for mixing with int64s
+bigint bigint_view_i64(int64_t x, uint64_t* limb);
+
+// Returns 1 and sets *out if x fits in an int64
+int    bigint_to_i64(const bigint* x, int64_t* out);
+
+// Returns 1 and sets *out if x fits in an __int128
+int    bigint_to_i128(const bigint* x, __int128* out);
+
+// Correctly rounded; inf once past the double range
+double bigint_to_double(const bigint* x);
+
+int    bigint_cmp(const bigint* a, const bigint* b);
+bigint bigint_neg(const bigint* x);
+bigint bigint_add(const bigint* a, const bigint* b);
+bigint bigint_sub(const bigint* a, const bigint* b);
+
+// Schoolbook, Karatsuba or Toom-3 depending on the operand sizes
+bigint bigint_mul(const bigint* a, const bigint* b);
+
+// Quotient truncated toward zero, like C's /; b must not be zero. The
+// remainder, signed like a, goes to rem unless it is NULL.
+bigint bigint_div(const bigint* a, const bigint* b, bigint* rem);
+
+// Non-negative greatest common divisor, by binary GCD
+bigint bigint_gcd(const bigint* a, const bigint* b);
+
+// Significant bits of |x|; 0 for zero
+int    bigint_bits(const bigint* x);
+
+// Trailing zero bits of |x|, and bit i of |x|
+int    bigint_ctz(const bigint* x);
+int    bigint_bit(const bigint* x, int i);
+
+// x * 2^bits, and |x| >>= bits in place (truncating the magnitude)
+bigint bigint_shl(const bigint* x, int bits);
+void   bigint_shr(bigint* x, int bits);
+
+// x^e by squaring
+bigint bigint_pow(const bigint* x, uint64_t e);
+
+// b^e mod m in [0, |m|), for e >= 0 and m non-zero. Moduli that fit in a
+// limb stay on 128-bit products throughout.
+bigint bigint_powmod(const bigint* b, const bigint* e, const bigint* m);
+
+// Parses len bytes of any integer literal intlit_parse accepts
+bigint bigint_parse(const char* s, int len);
+
+// Upper bound on the text bigint_format writes, including the NUL
+int    bigint_format_size(const bigint* x);
+int    bigint_format(const bigint* x, char* buffer);
+
+#endif
@@ -0,0 +1,231 @@
+#include <string.h>
+
+#include "decimal.h"
+
+typedef unsigned __int128 u128;
+
+#define DEC_MAX ((__int128)(~(u128)0 >> 1))
+#define DEC_MIN (-DEC_MAX - 1)
+
+int dec_scale = DEC_SCALE_DEFAULT;
+int dec_round = ROUND_HALF_EVEN;
+
+static const char* round_names[] = {
+    "half-even", "half-up", "half-down", "down", "up", "floor", "ceiling"
+};
+
+int dec_round_mode(const char* name) {
+    for (int i = 0; i < (int)(sizeof(round_names) / sizeof(round_names[0])); i++) {
+        if (strcmp(name, round_names[i]) == 0) { return i; }
+    }
+    return -1;
+}
+
+// One unit of the last decimal place, as a scaled integer
+static __int128 dec_unit(void) {
+    __int128 u = 1;
+    for (int i = 0; i < dec_scale; i++) { u *= 10; }
+    return u;
+}
+
+// Whether a truncated result moves one unit away from zero, given how the
+// dropped part compares with half a unit (cmp), the sign of the exact result
+// and the parity of the truncated one
+static int dec_round_away(int cmp, int neg, int odd) {
+    switch (dec_round)
+    {
+        case ROUND_HALF_UP:   return cmp >= 0;
+        case ROUND_HALF_DOWN: return cmp > 0;
+        case ROUND_DOWN:      return 0;
+        case ROUND_UP:        return 1;
+        case ROUND_FLOOR:     return neg;
+        case ROUND_CEILING:   return !neg;
+        default:              return cmp > 0 || (cmp == 0 && odd);
+    }
+}
+
+// n / d rounded, for any n and d other than DEC_MIN / -1
+static __int128 dec_quotient(__int128 n, __int128 d) {
+    __int128 q = n / d, r = n % d;
+    if (r == 0) { return q; }
+
+    // |r| against |d| - |r|, as 2|r| could overflow
+    u128 ur = r < 0 ? -(u128)r : (u128)r;
+    u128 ud = d < 0 ? -(u128)d : (u128)d;
+    int cmp = ur < ud - ur ? -1 : ur > ud - ur;
+    int neg = (n < 0) != (d < 0);
+    if (dec_round_away(cmp, neg, (int)(q & 1))) { q += neg ? -1 : 1; }
+    return q;
+}
+
+// n / d rounded, on bigints, for whatever does not fit in 128 bits
+static int dec_quotient_big(const bigint* n, const bigint* d, __int128* out) {
+    bigint r;
+    bigint q = bigint_div(n, d, &r);
+
+    if (r.len > 0) {
+        bigint r2 = bigint_add(&r, &r);
+        bigint rm = r2, dm = *d;
+        rm.neg = dm.neg = 0;
+        int neg = n->neg ^ d->neg;
+        if (dec_round_away(bigint_cmp(&rm, &dm), neg, q.len > 0 && (q.d[0] & 1))) {
+            uint64_t limb;
+            bigint one = bigint_view_i64(neg ? -1 : 1, &limb);
+            bigint t = bigint_add(&q, &one);
+            bigint_free(&q);
+            q = t;
+        }
+        bigint_free(&r2);
+    }
+    bigint_free(&r);
+
+    int ok = bigint_to_i128(&q, out);
+    bigint_free(&q);
+    return ok;
+}
+
+__int128 dec_from_i64(int64_t x) {
+    // |x| 10^18 is still well inside 128 bits
+    return (__int128)x * dec_unit();
+}
+
+int dec_from_big(const bigint* x, __int128* out) {
+    bigint unit = bigint_from_i128(dec_unit());
+    bigint n = bigint_mul(x, &unit);
+    int ok = bigint_to_i128(&n, out);
+    bigint_free(&unit);
+    bigint_free(&n);
+    return ok;
+}
+
+int dec_from_rat(const bigint* num, const bigint* den, __int128* out) {
+    bigint unit = bigint_from_i128(dec_unit());
+    bigint n = bigint_mul(num, &unit);
+    int ok = dec_quotient_big(&n, den, out);
+    bigint_free(&unit);
+    bigint_free(&n);
+    return ok;
+}
+
+int dec_mul(__int128 a, __int128 b, __int128* out) {
+    __int128 p;
+    if (!__builtin_mul_overflow(a, b, &p)) {
+        *out = dec_quotient(p, dec_unit());
+        return 1;
+    }
+
+    bigint x = bigint_from_i128(a), y = bigint_from_i128(b);
+    bigint d = bigint_from_i128(dec_unit());
+    bigint n = bigint_mul(&x, &y);
+    int ok = dec_quotient_big(&n, &d, out);
+    bigint_free(&x);
+    bigint_free(&y);
+    bigint_free(&d);
+    bigint_free(&n);
+    return ok;
+}
+
+int dec_div(__int128 a, __int128 b, __int128* out) {
+    __int128 n;
+    if (!__builtin_mul_overflow(a, dec_unit(), &n) && !(n == DEC_MIN && b == -1)) {
+        *out = dec_quotient(n, b);
+        return 1;
+    }
+
+    bigint x = bigint_from_i128(a), unit = bigint_from_i128(dec_unit());
+    bigint d = bigint_from_i128(b);
+    bigint m = bigint_mul(&x, &unit);
+    int ok = dec_quotient_big(&m, &d, out);
+    bigint_free(&x);
+    bigint_free(&unit);
+    bigint_free(&d);
+    bigint_free(&m);
+    return ok;
+}
+
+double dec_to_double(__int128 x) {
+    return (double)x / (double)dec_unit();
+}
+
+int dec_parse(const char* s, int len, __int128* out) {
+    const char* end = s + len;
+    if (end > s && end[-1] == 'm') { end--; }
+    int neg = *s == '-';
+    if (neg) { s++; }
+
+    // Integer and fraction digits, read as one run with the point after
+    // int_len of them, then moved by the exponent
+    const char* int_digits = s;
+    int int_len = 0;
+    while (s < end && *s >= '0' && *s <= '9') { s++; int_len++; }
+    const char* frac_digits = s;
+    int frac_len = 0;
+    if (s < end && *s == '.') {
+        frac_digits = ++s;
+        while (s < end && *s >= '0' && *s <= '9') { s++; frac_len++; }
+    }
+    long exp = 0;
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        int exp_neg = *++s == '-';
+        if (*s == '-' || *s == '+') { s++; }
+        for (; s < end; s++) {
+            if (exp < 100000) { exp = exp * 10 + (*s - '0'); }
+        }
+        if (exp_neg) { exp = -exp; }
+    }
+
+    int total = int_len + frac_len;
+    #define DEC_DIGIT(i) ((i) < int_len ? int_digits[i] - '0' : frac_digits[(i) - int_len] - '0')
+
+    // Digits before keep land in the scaled integer; the rest are rounded off
+    long keep = int_len + exp + dec_scale;
+    __int128 v = 0;
+    for (long i = 0; i < keep; i++) {
+        if (i >= total && v == 0) { break; }
+        int d = i < total ? DEC_DIGIT(i) : 0;
+        if (__builtin_mul_overflow(v, 10, &v) || __builtin_add_overflow(v, d, &v)) { return 0; }
+    }
+
+    // Past keep, leading zeros are implied when keep is negative
+    int first = keep >= 0 && keep < total ? DEC_DIGIT(keep) : 0;
+    int rest = 0;
+    for (long i = keep >= 0 ? keep + 1 : 0; i < total && !rest; i++) { rest = DEC_DIGIT(i) != 0; }
+    #undef DEC_DIGIT
+
+    if (first != 0 || rest) {
+        int cmp = first > 5 ? 1 : first < 5 ? -1 : rest;
+        if (dec_round_away(cmp, neg, (int)(v & 1)) && __builtin_add_overflow(v, 1, &v)) { return 0; }
+    }
+
+    *out = neg ? -v : v;
+    return 1;
+}
+
+int dec_format(__int128 x, char* buffer) {
+    u128 m = x < 0 ? -(u128)x : (u128)x;
+
+    // Digits, least significant first. Splitting at 10^19 leaves two halves
+    // that each fit in a uint64_t, off 128-bit division.
+    char digits[DEC_BUFFER_SIZE];
+    int n = 0;
+    uint64_t lo = (uint64_t)(m % 10000000000000000000ull);
+    uint64_t hi = (uint64_t)(m / 10000000000000000000ull);
+    while (lo != 0 || (hi != 0 && n < 19)) {
+        digits[n++] = (char)('0' + lo % 10);
+        lo /= 10;
+    }
+    while (hi != 0) {
+        digits[n++] = (char)('0' + hi % 10);
+        hi /= 10;
+    }
+    while (n <= dec_scale) { digits[n++] = '0'; }
+
+    char* p = buffer;
+    if (x < 0) { *p++ = '-'; }
+    for (int i = n - 1; i >= 0; i--) {
+        *p++ = digits[i];
+        if (i == dec_scale && i > 0) { *p++ = '.'; }
+    }
+    *p = '\0';
+    return (int)(p - buffer);
+}
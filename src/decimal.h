@@ -0,0 +1,42 @@
+#ifndef MYCLC_DECIMAL_H
+#define MYCLC_DECIMAL_H
+
+#include "bigint.h"
+
+// Fixed-point decimals for money: an __int128 holding the value times
+// 10^dec_scale, so sums are exact and products and quotients are rounded
+// once, to the scale, by the chosen rounding mode. Literals end in 'm'
+// (12.50m). Every decimal shares the process-wide scale and mode.
+
+#define DEC_SCALE_DEFAULT 2
+#define DEC_SCALE_MAX     18
+
+// Sign, 39 digits, point and NUL, with room to spare
+#define DEC_BUFFER_SIZE   48
+
+enum {
+    ROUND_HALF_EVEN, ROUND_HALF_UP, ROUND_HALF_DOWN,
+    ROUND_DOWN, ROUND_UP, ROUND_FLOOR, ROUND_CEILING
+};
+
+extern int dec_scale;
+extern int dec_round;
+
+// Rounding mode for a --round= name, or -1
+int dec_round_mode(const char* name);
+
+__int128 dec_from_i64(int64_t x);
+
+// Each returns 0 if the result does not fit
+int dec_parse(const char* s, int len, __int128* out);
+int dec_from_big(const bigint* x, __int128* out);
+int dec_from_rat(const bigint* num, const bigint* den, __int128* out);
+int dec_mul(__int128 a, __int128 b, __int128* out);
+
+// b must not be zero
+int dec_div(__int128 a, __int128 b, __int128* out);
+
+double dec_to_double(__int128 x);
+int    dec_format(__int128 x, char* buffer);
+
+#endif
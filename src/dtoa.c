@@ -0,0 +1,435 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "dtoa.h"
+
+// Grisu3 (Loitsch, "Printing Floating-Point Numbers Quickly and Accurately
+// with Integers", PLDI 2010), at a small multiple of the cost of an itoa.
+// For the roughly 0.5% of inputs where it cannot prove its digits shortest
+// it gives up, and dtoa_exact works them out with bignums instead.
+
+#define DTOA_HIDDEN_BIT   (1ull << 52)
+#define DTOA_MANTISSA     (DTOA_HIDDEN_BIT - 1)
+
+typedef struct { uint64_t f; int e; } diy_fp;
+
+// Every power of ten that fits in 64 bits; digit_gen can produce up to 19
+// fractional digits, and grisu_round needs 10^kappa for each
+static const uint64_t pow10_64[20] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+    10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull
+};
+
+// Normalized 64-bit approximations of 10^-348, 10^-340, ..., 10^340
+#define DTOA_CACHED_COUNT 87
+// Filled by dtoa_init, before any pool thread can print
+static diy_fp cached[DTOA_CACHED_COUNT];
+
+// Just enough of a bignum to derive the cached powers exactly at startup,
+// rather than pasting a table of magic constants into the source
+#define DTOA_LIMBS 48
+typedef struct { uint32_t d[DTOA_LIMBS]; int n; } dtoa_big;
+
+static void big_pow10(dtoa_big* b, int k) {
+    memset(b, 0, sizeof(*b));
+    b->d[0] = 1;
+    b->n = 1;
+    for (; k > 0; k--) {
+        uint64_t carry = 0;
+        for (int i = 0; i < b->n; i++) {
+            uint64_t x = (uint64_t)b->d[i] * 10 + carry;
+            b->d[i] = (uint32_t)x;
+            carry = x >> 32;
+        }
+        if (carry) { b->d[b->n++] = (uint32_t)carry; }
+    }
+}
+
+static int big_bitlen(const dtoa_big* b) {
+    return (b->n - 1) * 32 + (32 - __builtin_clz(b->d[b->n - 1]));
+}
+
+static int big_bit(const dtoa_big* b, int i) {
+    return (b->d[i / 32] >> (i % 32)) & 1;
+}
+
+static int big_cmp(const dtoa_big* a, const dtoa_big* b) {
+    if (a->n != b->n) { return a->n < b->n ? -1 : 1; }
+    for (int i = a->n - 1; i >= 0; i--) {
+        if (a->d[i] != b->d[i]) { return a->d[i] < b->d[i] ? -1 : 1; }
+    }
+    return 0;
+}
+
+static void big_set(dtoa_big* b, uint64_t x) {
+    memset(b, 0, sizeof(*b));
+    b->d[0] = (uint32_t)x;
+    b->d[1] = (uint32_t)(x >> 32);
+    b->n = b->d[1] ? 2 : 1;
+}
+
+// b <<= n
+static void big_shl(dtoa_big* b, int n) {
+    int limbs = n / 32, bits = n % 32;
+    for (int i = b->n - 1; i >= 0; i--) { b->d[i + limbs] = b->d[i]; }
+    for (int i = 0; i < limbs; i++) { b->d[i] = 0; }
+    b->n += limbs;
+    if (bits) {
+        uint32_t carry = 0;
+        for (int i = limbs; i < b->n; i++) {
+            uint32_t next = b->d[i] >> (32 - bits);
+            b->d[i] = (b->d[i] << bits) | carry;
+            carry = next;
+        }
+        if (carry) { b->d[b->n++] = carry; }
+    }
+}
+
+// b *= m
+static void big_mul_small(dtoa_big* b, uint32_t m) {
+    uint64_t carry = 0;
+    for (int i = 0; i < b->n; i++) {
+        uint64_t x = (uint64_t)b->d[i] * m + carry;
+        b->d[i] = (uint32_t)x;
+        carry = x >> 32;
+    }
+    if (carry) { b->d[b->n++] = (uint32_t)carry; }
+}
+
+// t = a + b
+static void big_add_to(dtoa_big* t, const dtoa_big* a, const dtoa_big* b) {
+    int n = a->n > b->n ? a->n : b->n;
+    uint64_t carry = 0;
+    for (int i = 0; i < n; i++) {
+        uint64_t x = (uint64_t)(i < a->n ? a->d[i] : 0) + (i < b->n ? b->d[i] : 0) + carry;
+        t->d[i] = (uint32_t)x;
+        carry = x >> 32;
+    }
+    t->n = n;
+    if (carry) { t->d[t->n++] = (uint32_t)carry; }
+}
+
+// a = 2a + bit
+static void big_shl1(dtoa_big* a, int bit) {
+    uint32_t carry = bit;
+    for (int i = 0; i < a->n; i++) {
+        uint32_t next = a->d[i] >> 31;
+        a->d[i] = (a->d[i] << 1) | carry;
+        carry = next;
+    }
+    if (carry) { a->d[a->n++] = carry; }
+}
+
+// a -= b, for a >= b
+static void big_sub(dtoa_big* a, const dtoa_big* b) {
+    int64_t borrow = 0;
+    for (int i = 0; i < a->n; i++) {
+        int64_t x = (int64_t)a->d[i] - (i < b->n ? b->d[i] : 0) - borrow;
+        borrow = x < 0;
+        a->d[i] = (uint32_t)(x + (borrow << 32));
+    }
+    while (a->n > 1 && a->d[a->n - 1] == 0) { a->n--; }
+}
+
+// Round-to-nearest 64-bit significand of 10^k
+static diy_fp cached_power(int k) {
+    dtoa_big p;
+    big_pow10(&p, k < 0 ? -k : k);
+    int len = big_bitlen(&p);
+
+    if (k >= 0) {
+        if (len <= 64) {
+            uint64_t f = p.d[0] | (p.n > 1 ? (uint64_t)p.d[1] << 32 : 0);
+            return (diy_fp){ f << (64 - len), len - 64 };
+        }
+        uint64_t f = 0;
+        for (int i = len - 1; i >= len - 64; i--) { f = (f << 1) | big_bit(&p, i); }
+        int e = len - 64;
+        if (big_bit(&p, len - 65) && ++f == 0) { f = 1ull << 63; e++; }
+        return (diy_fp){ f, e };
+    }
+
+    // 10^k = 2^-b * (2^b / 10^-k), with b chosen to leave a 64-bit quotient
+    int b = len + 63;
+    dtoa_big r;
+    memset(&r, 0, sizeof(r));
+    r.n = 1;
+    uint64_t q = 0;
+    for (int i = b; i >= 0; i--) {
+        big_shl1(&r, i == b);
+        q <<= 1;
+        if (big_cmp(&r, &p) >= 0) {
+            big_sub(&r, &p);
+            q |= 1;
+        }
+    }
+    big_shl1(&r, 0);
+    if (big_cmp(&r, &p) >= 0 && ++q == 0) { q = 1ull << 63; b--; }
+    return (diy_fp){ q, -b };
+}
+
+void dtoa_init(void) {
+    for (int i = 0; i < DTOA_CACHED_COUNT; i++) { cached[i] = cached_power(-348 + 8 * i); }
+}
+
+static diy_fp diy_mul(diy_fp x, diy_fp y) {
+    unsigned __int128 p = (unsigned __int128)x.f * y.f;
+    uint64_t h = (uint64_t)(p >> 64);
+    if ((uint64_t)p & (1ull << 63)) { h++; }
+    return (diy_fp){ h, x.e + y.e + 64 };
+}
+
+static diy_fp diy_normalize(diy_fp x) {
+    int s = __builtin_clzll(x.f);
+    return (diy_fp){ x.f << s, x.e - s };
+}
+
+// Cached power c such that the product with a number of binary exponent e
+// lands in [-60, -32]; *k receives its negated decimal exponent
+static diy_fp cached_for(int e, int* k) {
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int ki = (int)dk;
+    if (dk - ki > 0.0) { ki++; }
+    int index = (ki >> 3) + 1;
+    *k = -(-348 + index * 8);
+    return cached[index];
+}
+
+// Grisu3's weeding step. Moves the last digit down while that brings it
+// closer to w, then reports whether the digits are provably the shortest
+// and closest: w and the boundaries are only known to within unit, so the
+// answer is 0 when either could change within that error.
+static int round_weed(char* buffer, int len, uint64_t distance_too_high_w, uint64_t unsafe_interval,
+                      uint64_t rest, uint64_t ten_kappa, uint64_t unit) {
+    uint64_t small_distance = distance_too_high_w - unit;
+    uint64_t big_distance = distance_too_high_w + unit;
+
+    while (rest < small_distance && unsafe_interval - rest >= ten_kappa &&
+           (rest + ten_kappa < small_distance ||
+            small_distance - rest >= rest + ten_kappa - small_distance)) {
+        buffer[len - 1]--;
+        rest += ten_kappa;
+    }
+
+    if (rest < big_distance && unsafe_interval - rest >= ten_kappa &&
+        (rest + ten_kappa < big_distance ||
+         big_distance - rest > rest + ten_kappa - big_distance)) {
+        return 0;
+    }
+    return 2 * unit <= rest && rest <= unsafe_interval - 4 * unit;
+}
+
+static int count_digits(uint32_t n) {
+    int d = 1;
+    while (d < 10 && n >= pow10_64[d]) { d++; }
+    return d;
+}
+
+// Generates the shortest digits of w that stay inside (low, high), widened
+// by the one unit of error the products carry. Returns the digit count, or
+// 0 if round_weed cannot vouch for them.
+static int digit_gen(diy_fp low, diy_fp w, diy_fp high, char* buffer, int* k) {
+    uint64_t unit = 1;
+    diy_fp too_low = { low.f - unit, low.e };
+    diy_fp too_high = { high.f + unit, high.e };
+    uint64_t unsafe_interval = too_high.f - too_low.f;
+    diy_fp one = { 1ull << -w.e, w.e };
+    uint32_t integrals = (uint32_t)(too_high.f >> -one.e);
+    uint64_t fractionals = too_high.f & (one.f - 1);
+    int kappa = count_digits(integrals);
+    int len = 0;
+
+    while (kappa > 0) {
+        uint64_t divisor = pow10_64[kappa - 1];
+        buffer[len++] = (char)('0' + integrals / divisor);
+        integrals %= divisor;
+        kappa--;
+
+        uint64_t rest = ((uint64_t)integrals << -one.e) + fractionals;
+        if (rest < unsafe_interval) {
+            *k += kappa;
+            return round_weed(buffer, len, too_high.f - w.f, unsafe_interval, rest,
+                              divisor << -one.e, unit) ? len : 0;
+        }
+    }
+
+    while (1) {
+        fractionals *= 10;
+        unit *= 10;
+        unsafe_interval *= 10;
+        buffer[len++] = (char)('0' + (fractionals >> -one.e));
+        fractionals &= one.f - 1;
+        kappa--;
+
+        if (fractionals < unsafe_interval) {
+            *k += kappa;
+            return round_weed(buffer, len, (too_high.f - w.f) * unit, unsafe_interval, fractionals,
+                              one.f, unit) ? len : 0;
+        }
+    }
+}
+
+// Shortest digits of f * 2^e, closest to it among those, by exact bignum
+// arithmetic (Steele and White's free-format algorithm, as refined by
+// Burger and Dybvig). Used only when Grisu3 gives up. r / s is the value,
+// and mp / s and mm / s are the distances to the boundaries halfway to the
+// neighbouring doubles; a boundary itself reads back as v when f is even.
+static int dtoa_exact(uint64_t f, int e, int lower_closer, char* buffer, int* k) {
+    int even = (f & 1) == 0;
+    dtoa_big r, s, mp, mm, t;
+
+    big_set(&r, f);
+    big_set(&s, 1);
+    big_set(&mp, 1);
+    big_set(&mm, 1);
+    if (e >= 0) {
+        big_shl(&r, e + 1 + lower_closer);
+        big_shl(&s, 1 + lower_closer);
+        big_shl(&mp, e + lower_closer);
+        big_shl(&mm, e);
+    } else {
+        big_shl(&r, 1 + lower_closer);
+        big_shl(&s, 1 + lower_closer - e);
+        big_shl(&mp, lower_closer);
+    }
+
+    // Divide by 10^est, with est at most log10(v) to start with, then raise
+    // est until the upper boundary is below 1: v = 0.ddd * 10^est
+    int bits = 64 - __builtin_clzll(f) + e;
+    int est = (int)((bits - 1) * 0.30102999566398114) - (bits <= 0);
+    for (int i = 0; i < est; i++) { big_mul_small(&s, 10); }
+    for (int i = 0; i > est; i--) {
+        big_mul_small(&r, 10);
+        big_mul_small(&mp, 10);
+        big_mul_small(&mm, 10);
+    }
+    while (1) {
+        big_add_to(&t, &r, &mp);
+        int c = big_cmp(&t, &s);
+        if (even ? c < 0 : c <= 0) { break; }
+        big_mul_small(&s, 10);
+        est++;
+    }
+
+    int len = 0;
+    while (1) {
+        big_mul_small(&r, 10);
+        big_mul_small(&mp, 10);
+        big_mul_small(&mm, 10);
+        int d = 0;
+        while (big_cmp(&r, &s) >= 0) { big_sub(&r, &s); d++; }
+
+        int c = big_cmp(&r, &mm);
+        int low = even ? c <= 0 : c < 0;
+        big_add_to(&t, &r, &mp);
+        c = big_cmp(&t, &s);
+        int high = even ? c >= 0 : c > 0;
+
+        if (low && high) {
+            big_add_to(&t, &r, &r);
+            c = big_cmp(&t, &s);
+            if (c > 0 || (c == 0 && (d & 1))) { d++; }
+        } else if (high) {
+            d++;
+        }
+        buffer[len++] = (char)('0' + d);
+        if (low || high) { break; }
+    }
+
+    *k = est - len;
+    return len;
+}
+
+// Shortest digits of the positive, finite v; v == digits * 10^*k
+static int grisu3(double v, char* buffer, int* k) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    int be = (int)((bits >> 52) & 0x7FF);
+    uint64_t f = bits & DTOA_MANTISSA;
+    int e;
+    if (be != 0) { f += DTOA_HIDDEN_BIT; e = be - 1075; } else { e = -1074; }
+
+    // Boundaries halfway to the neighbouring doubles, on w's exponent
+    int lower_closer = f == DTOA_HIDDEN_BIT && be > 1;
+    diy_fp w = diy_normalize((diy_fp){ f, e });
+    diy_fp plus = diy_normalize((diy_fp){ (f << 1) + 1, e - 1 });
+    diy_fp minus = lower_closer
+        ? (diy_fp){ (f << 2) - 1, e - 2 }
+        : (diy_fp){ (f << 1) - 1, e - 1 };
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    diy_fp c = cached_for(plus.e, k);
+    int len = digit_gen(diy_mul(minus, c), diy_mul(w, c), diy_mul(plus, c), buffer, k);
+    if (len == 0) { len = dtoa_exact(f, e, lower_closer, buffer, k); }
+    return len;
+}
+
+int dtoa_layout(const char* digits, int len, int k, char* out) {
+    int kk = len + k;
+    char* p = out;
+
+    if (kk > 0 && kk <= 21) {
+        if (len <= kk) {
+            memcpy(p, digits, len);
+            p += len;
+            for (int i = len; i < kk; i++) { *p++ = '0'; }
+            *p++ = '.';
+            *p++ = '0';
+        } else {
+            memcpy(p, digits, kk);
+            p += kk;
+            *p++ = '.';
+            memcpy(p, digits + kk, len - kk);
+            p += len - kk;
+        }
+    } else if (kk > -6 && kk <= 0) {
+        *p++ = '0';
+        *p++ = '.';
+        for (int i = kk; i < 0; i++) { *p++ = '0'; }
+        memcpy(p, digits, len);
+        p += len;
+    } else {
+        *p++ = digits[0];
+        if (len > 1) {
+            *p++ = '.';
+            memcpy(p, digits + 1, len - 1);
+            p += len - 1;
+        }
+        *p++ = 'e';
+        int x = kk - 1;
+        if (x < 0) { *p++ = '-'; x = -x; }
+        char exp[12];
+        int n = 0;
+        do { exp[n++] = (char)('0' + x % 10); x /= 10; } while (x != 0);
+        while (n > 0) { *p++ = exp[--n]; }
+    }
+
+    return (int)(p - out);
+}
+
+int dtoa_shortest(double v, char* buffer) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    char* p = buffer;
+
+    if ((bits & 0x7FF0000000000000ull) == 0x7FF0000000000000ull && (bits & DTOA_MANTISSA)) {
+        strcpy(p, "nan");
+        return 3;
+    }
+    if (bits >> 63) { *p++ = '-'; bits &= ~(1ull << 63); memcpy(&v, &bits, sizeof(v)); }
+
+    if (bits == 0x7FF0000000000000ull) {
+        strcpy(p, "inf");
+    } else if (bits == 0) {
+        strcpy(p, "0.0");
+    } else {
+        char digits[20];
+        int k;
+        int len = grisu3(v, digits, &k);
+        p[dtoa_layout(digits, len, k, p)] = '\0';
+    }
+    return (int)strlen(buffer);
+}
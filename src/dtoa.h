@@ -0,0 +1,21 @@
+#ifndef MYCLC_DTOA_H
+#define MYCLC_DTOA_H
+
+// Longest text dtoa_shortest can produce, including the terminating NUL
+#define DTOA_BUFFER_SIZE 32
+
+// Derives the table of cached powers of ten. Call once from main, before
+// the worker pool starts.
+void dtoa_init(void);
+
+// Formats v with the fewest significant digits that read back as exactly v
+// (Grisu2), without going through printf. Values that print as integers get
+// a trailing ".0" so they read back as floats. Returns the length written.
+int dtoa_shortest(double v, char* buffer);
+
+// Lays out the len digits * 10^k the way dtoa_shortest does: plain decimal
+// where that stays short, otherwise d.ddde[-]x. Writes at most len + 24 bytes
+// and no NUL; returns the length written.
+int dtoa_layout(const char* digits, int len, int k, char* out);
+
+#endif
@@ -0,0 +1,82 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "intern.h"
+
+// Names of the builtins, indexed by their SYM_ ID
+static const char* builtin_names[SYM_BUILTIN_COUNT] = {
+    "+", "-", "*", "/", "%",
+    "^", "pow", "powmod", "precision",
+    "sum", "prod", "min", "max",
+    "matmul", "transpose",
+    "range", "iterate", "map", "filter", "reduce", "fold",
+    "pmap", "preduce",
+    "<", ">", "<=", ">=", "==", "!=",
+    "def", "\\", "lambda", "if",
+};
+
+// Open-addressing hash of ID + 1 (0 marks an empty slot), power-of-two sized
+static int* slots;
+static unsigned slot_mask;
+
+// ID -> name, in interning order
+static char** names;
+static int* name_lens;
+static int count;
+static int capacity;
+
+// FNV-1a
+static unsigned intern_hash(const char* s, int len) {
+    unsigned h = 2166136261u;
+    for (int i = 0; i < len; i++) {
+        h = (h ^ (unsigned char)s[i]) * 16777619u;
+    }
+    return h;
+}
+
+static void intern_rehash(unsigned size) {
+    free(slots);
+    slots = calloc(size, sizeof(int));
+    slot_mask = size - 1;
+    for (int id = 0; id < count; id++) {
+        unsigned i = intern_hash(names[id], name_lens[id]) & slot_mask;
+        while (slots[i] != 0) { i = (i + 1) & slot_mask; }
+        slots[i] = id + 1;
+    }
+}
+
+void intern_init(void) {
+    if (slots == NULL) { intern_rehash(64); }
+    for (int id = 0; id < SYM_BUILTIN_COUNT; id++) {
+        intern(builtin_names[id], strlen(builtin_names[id]));
+    }
+}
+
+int intern(const char* s, int len) {
+    unsigned i = intern_hash(s, len) & slot_mask;
+    while (slots[i] != 0) {
+        int id = slots[i] - 1;
+        if (name_lens[id] == len && memcmp(names[id], s, len) == 0) { return id; }
+        i = (i + 1) & slot_mask;
+    }
+
+    // New symbol: keep a private copy of its name
+    if (count == capacity) {
+        capacity  = capacity ? capacity * 2 : 64;
+        names     = realloc(names, sizeof(char*) * capacity);
+        name_lens = realloc(name_lens, sizeof(int) * capacity);
+    }
+    names[count] = malloc(len + 1);
+    memcpy(names[count], s, len);
+    names[count][len] = '\0';
+    name_lens[count] = len;
+    slots[i] = ++count;
+
+    // Keep the load factor at or under one half
+    if ((unsigned)count * 2 > slot_mask + 1) { intern_rehash((slot_mask + 1) * 2); }
+    return count - 1;
+}
+
+const char* intern_name(int id) {
+    return names[id];
+}
@@ -0,0 +1,32 @@
+#ifndef MYCLC_INTERN_H
+#define MYCLC_INTERN_H
+
+// Symbol intern table. Every distinct symbol name maps to a small integer ID
+// for the life of the process, so symbols compare and dispatch as ints.
+//
+// Builtins are interned first, in this order, so their IDs double as opcodes.
+// "^" and "pow", and "\" and "lambda", are two spellings of the same thing.
+// The special forms, which see their arguments before they are evaluated,
+// come last, from SYM_DEF on.
+enum {
+    SYM_ADD, SYM_SUB, SYM_MUL, SYM_DIV, SYM_MOD,
+    SYM_CARET, SYM_POW, SYM_POWMOD, SYM_PRECISION,
+    SYM_SUM, SYM_PROD, SYM_MIN, SYM_MAX,
+    SYM_MATMUL, SYM_TRANSPOSE,
+    SYM_RANGE, SYM_ITERATE, SYM_MAP, SYM_FILTER, SYM_REDUCE, SYM_FOLD,
+    SYM_PMAP, SYM_PREDUCE,
+    SYM_LT, SYM_GT, SYM_LE, SYM_GE, SYM_EQ, SYM_NE,
+    SYM_DEF, SYM_BACKSLASH, SYM_LAMBDA, SYM_IF,
+    SYM_BUILTIN_COUNT
+};
+
+// Intern the builtin names; call once before reading any input
+void intern_init(void);
+
+// ID of the symbol named s (len bytes), adding it if it is new
+int intern(const char* s, int len);
+
+// Name of an interned symbol
+const char* intern_name(int id);
+
+#endif
@@ -0,0 +1,89 @@
+#include <string.h>
+
+#include "intlit.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define INTLIT_SWAR
+#endif
+
+int intlit_radix(const char* s, int* skip) {
+    *skip = 2;
+    if (s[0] == '0' && s[1] == 'x') { return 16; }
+    if (s[0] == '0' && s[1] == 'b') { return 2; }
+    if (s[0] == '0' && s[1] == 'o') { return 8; }
+    *skip = 0;
+    return 10;
+}
+
+#ifdef INTLIT_SWAR
+// Value of eight ASCII digits, first digit in the lowest byte: pairs of
+// digits are combined, then pairs of pairs, then the two halves, each step a
+// single multiply across every lane
+static uint32_t intlit_swar8(const char* s) {
+    uint64_t v;
+    memcpy(&v, s, sizeof(v));
+    v -= 0x3030303030303030ull;
+    v = v * 10 + (v >> 8);
+    v = (((v & 0x000000FF000000FFull) * 0x000F424000000064ull) +
+         (((v >> 16) & 0x000000FF000000FFull) * 0x0000271000000001ull)) >> 32;
+    return (uint32_t)v;
+}
+#else
+static uint32_t intlit_swar8(const char* s) {
+    uint32_t v = 0;
+    for (int i = 0; i < 8; i++) { v = v * 10 + (uint32_t)(s[i] - '0'); }
+    return v;
+}
+#endif
+
+static int intlit_dec(const char* s, int len, uint64_t* out) {
+    uint64_t v = 0;
+    int i = 0;
+
+    // Nineteen digits always fit, so only longer literals pay for checks
+    if (len <= 19) {
+        for (; i + 8 <= len; i += 8) { v = v * 100000000 + intlit_swar8(s + i); }
+        for (; i < len; i++) { v = v * 10 + (uint64_t)(s[i] - '0'); }
+        *out = v;
+        return 1;
+    }
+
+    for (; i + 8 <= len; i += 8) {
+        if (__builtin_mul_overflow(v, 100000000, &v)) { return 0; }
+        if (__builtin_add_overflow(v, intlit_swar8(s + i), &v)) { return 0; }
+    }
+    for (; i < len; i++) {
+        if (__builtin_mul_overflow(v, 10, &v)) { return 0; }
+        if (__builtin_add_overflow(v, (uint64_t)(s[i] - '0'), &v)) { return 0; }
+    }
+    *out = v;
+    return 1;
+}
+
+// Hex, binary and octal shift whole digits in
+static int intlit_pow2(const char* s, int len, int bits, uint64_t* out) {
+    uint64_t v = 0;
+    for (int i = 0; i < len; i++) {
+        int c = s[i];
+        int d = c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+        if (v >> (64 - bits) != 0) { return 0; }
+        v = (v << bits) | (uint64_t)d;
+    }
+    *out = v;
+    return 1;
+}
+
+int intlit_parse(const char* s, int len, int64_t* out) {
+    int neg = s[0] == '-';
+    int skip;
+    int radix = intlit_radix(s + neg, &skip);
+    s   += neg + skip;
+    len -= neg + skip;
+
+    uint64_t m;
+    int ok = radix == 10 ? intlit_dec(s, len, &m)
+                         : intlit_pow2(s, len, radix == 16 ? 4 : radix == 8 ? 3 : 1, &m);
+    if (!ok || m > (uint64_t)INT64_MAX + neg) { return 0; }
+    *out = neg ? (int64_t)(0 - m) : (int64_t)m;
+    return 1;
+}
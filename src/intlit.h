@@ -0,0 +1,18 @@
+#ifndef MYCLC_INTLIT_H
+#define MYCLC_INTLIT_H
+
+#include <stdint.h>
+
+// Integer literals: -?[0-9]+, or -?0x, -?0b and -?0o followed by hex, binary
+// or octal digits. Decimal digits are converted eight at a time with SWAR
+// arithmetic rather than through strtol and errno.
+
+// Radix of a literal whose digits start at s (after any '-'), and the
+// length of its prefix in *skip
+int intlit_radix(const char* s, int* skip);
+
+// Parses the len bytes at s, which must already be a valid literal. Returns
+// 0 if the value does not fit in an int64_t.
+int intlit_parse(const char* s, int len, int64_t* out);
+
+#endif
@@ -0,0 +1,61 @@
+#include <stdlib.h>
+
+#include "lenv.h"
+
+// IDs are handed out in sequence, so spread them with a Fibonacci multiply
+static unsigned lenv_hash(int sym) {
+    unsigned h = (unsigned)sym * 2654435769u;
+    return h ^ (h >> 16);
+}
+
+// Slot holding sym, or the empty slot where it would go
+static unsigned lenv_slot(const lenv* e, int sym) {
+    unsigned i = lenv_hash(sym) & e->mask;
+    while (e->syms[i] != 0 && e->syms[i] != sym + 1) { i = (i + 1) & e->mask; }
+    return i;
+}
+
+static void lenv_rehash(lenv* e, unsigned size) {
+    int* syms = e->syms;
+    lval** vals = e->vals;
+    unsigned old_size = syms != NULL ? e->mask + 1 : 0;
+
+    // ID + 1 per slot, 0 when empty
+    e->syms = calloc(size, sizeof(int));
+    e->vals = malloc(size * sizeof(lval*));
+    if (e->syms == NULL || e->vals == NULL) { abort(); }
+    e->mask = size - 1;
+    for (unsigned j = 0; j < old_size; j++) {
+        if (syms[j] == 0) { continue; }
+        unsigned i = lenv_slot(e, syms[j] - 1);
+        e->syms[i] = syms[j];
+        e->vals[i] = vals[j];
+    }
+    free(syms);
+    free(vals);
+}
+
+lval* lenv_get(lenv* e, int sym) {
+    if (e->syms == NULL) { return NULL; }
+    unsigned i = lenv_slot(e, sym);
+    return e->syms[i] != 0 ? e->vals[i] : NULL;
+}
+
+void lenv_put(lenv* e, int sym, lval* v) {
+    if (e->syms == NULL) { lenv_rehash(e, 64); }
+    unsigned i = lenv_slot(e, sym);
+
+    arena* prev = arena_use(&e->arena);
+    lval* copy = lval_copy(v);
+    if (e->syms[i] != 0) {
+        lval_del(e->vals[i]);
+    } else {
+        e->syms[i] = sym + 1;
+        e->count++;
+    }
+    e->vals[i] = copy;
+    e->version++;
+    arena_use(prev);
+
+    if ((unsigned)e->count * 2 > e->mask + 1) { lenv_rehash(e, (e->mask + 1) * 2); }
+}
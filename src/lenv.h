@@ -0,0 +1,33 @@
+#ifndef MYCLC_LENV_H
+#define MYCLC_LENV_H
+
+#include "arena.h"
+#include "lval.h"
+
+// Environment of symbol bindings. Slots are an open-addressing hash of the
+// interned symbol ID, power-of-two sized and kept at most half full, so a
+// lookup costs a multiply, a mask and about one probe at any size. Values
+// are copies held in the environment's own arena, which lives on past the
+// evaluation arena's reset at the end of each line.
+
+typedef struct lenv {
+    int* syms;
+    lval** vals;
+    unsigned mask;
+    int count;
+    unsigned version;
+    arena arena;
+} lenv;
+
+// Global bindings made by def
+extern lenv globals;
+
+// Value bound to sym, or NULL if there is none. It still belongs to e.
+lval* lenv_get(lenv* e, int sym);
+
+// Binds sym to a copy of v, deleting any value it had before. Each call
+// bumps e->version, so a value borrowed from e is still good while the
+// version is unchanged.
+void  lenv_put(lenv* e, int sym, lval* v);
+
+#endif
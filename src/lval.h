@@ -0,0 +1,171 @@
+#ifndef MYCLC_LVAL_H
+#define MYCLC_LVAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bigfloat.h"
+#include "mat.h"
+#include "vec.h"
+
+// Create enum of lval typeS
+enum { LVAL_NUM, LVAL_BIG, LVAL_RAT, LVAL_DEC, LVAL_DBL, LVAL_MPF, LVAL_VEC, LVAL_MAT, LVAL_ERR, LVAL_SYM, LVAL_SEXPR, LVAL_FUN,
+       LVAL_SEQ };
+
+// A Function (lambda) holds three cells: its list of formal names, its body,
+// and the local bindings it closed over as a list of name, value pairs
+enum { LVAL_FUN_FORMALS, LVAL_FUN_BODY, LVAL_FUN_ENV };
+
+// A lazy Sequence is either the count integers start, start + step, ...
+// short of stop, or the first count values of x, (f x), (f (f x)) ... with
+// f and x held in cell[0] and cell[1]. A map or filter Sequence holds f in
+// cell[0] and the Sequence it draws from in cell[1]. Values are made as
+// they are asked for.
+enum { LSEQ_RANGE, LSEQ_ITERATE, LSEQ_MAP, LSEQ_FILTER };
+
+typedef struct lseq {
+    int kind;
+    int64_t start;
+    int64_t stop;
+    int64_t step;
+    uint64_t count;
+} lseq;
+
+// A Decimal's scaled value. Aligned to 8 rather than 16 bytes, so that it
+// does not push the payload union below to a 16-byte boundary and pad every
+// lval out to 80 bytes.
+typedef __int128 lval_dec_t __attribute__((aligned(8)));
+
+// Define lval (Lisp Value) struct. Only the payload of its type is live:
+// a Rational is big over den, an S-Expression or Function has count cells,
+// and a Sequence has both cells and seq.
+typedef struct lval {
+    int type;
+    union {
+        long num;
+        struct {
+            bigint big;
+            bigint den;
+        };
+        lval_dec_t dec;
+        double dbl;
+        bigfloat mpf;
+        vec vec;
+        mat mat;
+        char* err;
+        int sym;
+        struct {
+            int count;
+            int capacity;
+            struct lval** cell;
+            lseq seq;
+        };
+    };
+} lval;
+
+_Static_assert(sizeof(lval) == 64, "an lval should fill one 64-byte cache line");
+
+// Small integers are carried in the lval pointer itself: bit 0 set, value in
+// the upper bits. Real lvals are always at least 2-byte aligned, so the tag
+// never collides with a heap pointer.
+#define LVAL_IMM_MIN (-(1L << 62))
+#define LVAL_IMM_MAX ((1L << 62) - 1)
+
+static inline int lval_is_imm(lval* v) { return ((uintptr_t)v & 1) != 0; }
+
+static inline lval* lval_imm(long x) {
+    return (lval*)(((uintptr_t)x << 1) | 1);
+}
+
+// Type of any lval, tagged or not
+static inline int lval_type(lval* v) {
+    return lval_is_imm(v) ? LVAL_NUM : v->type;
+}
+
+// Value of a Number lval, tagged or not
+static inline long lval_num_val(lval* v) {
+    return lval_is_imm(v) ? (long)((intptr_t)v >> 1) : v->num;
+}
+
+lval* lval_num(long x);
+lval* lval_big(bigint x);
+lval* lval_rat(bigint num, bigint den);
+lval* lval_dec(__int128 x);
+lval* lval_dbl(double x);
+lval* lval_mpf(bigfloat x);
+lval* lval_vec(vec x);
+lval* lval_mat(mat x);
+lval* lval_err(char* m);
+lval* lval_sym(char* s);
+lval* lval_sym_id(int id);
+lval* lval_sexpr(void);
+void  lval_del(lval* v);
+lval* lval_add(lval* v, lval* x);
+lval* lval_pop(lval* v, int i);
+lval* lval_take(lval* v, int i);
+lval* lval_copy(lval* v);
+void  lval_print(lval* v);
+void  lval_println(lval* v);
+lval* lval_eval(lval* v);
+
+// Steps of evaluation shared by the tree walker and the VM. Local bindings
+// are a list of name, value pairs, like those a Function closes over.
+
+// Binds the symbol name to x among the local bindings in env, taking over both
+void  lval_env_put(lval* env, lval* name, lval* x);
+
+// Swaps a bound symbol for a copy of its value, in env or else the globals.
+// Builtin names stand for themselves, so they can be bound and passed around
+// like any value.
+lval* lval_lookup(lval* x, lval* env);
+
+// Applies an S-Expression whose children have already been evaluated, in
+// the local bindings env. A call to a Function comes back as its body, for
+// the caller to carry on with in place of v, and the bindings for it in
+// *call_env. line is set for the S-Expression of a whole input line, where a
+// lone Function is shown rather than called.
+lval* lval_eval_sexpr(lval* v, lval* env, lval** call_env, int line);
+
+// lval_eval in the local bindings env, which stay the caller's
+lval* lval_eval_in(lval* v, lval* env);
+
+// Sign of a number: -1, 0 or 1, and 2 for a NaN
+int   lval_sign(lval* x);
+
+// Packs a list of number literals into a Vector, deleting the list
+lval* lval_vec_pack(lval* list);
+
+// Packs a list of rows, each a list of number literals, into a Matrix,
+// deleting the list
+lval* lval_mat_pack(lval* rows);
+
+// Makes room for one more item on a work stack of size-byte items
+void* stack_reserve(void* items, int count, int* capacity, size_t size);
+
+// Applies builtin op to args[0..n), leaving the arguments to the caller
+lval* lval_fold(int op, lval** args, int n);
+
+// Streams the values of a Sequence or Vector in order, in O(1) space, with
+// every map and filter stage over it applied to each value in turn. Each
+// value lval_seq_next returns belongs to the caller; it returns NULL once
+// they run out, and an error from a stage is the last value it gives.
+typedef struct {
+    lval* src;
+    lval** stages;
+    int depth;
+    int done;
+    uint64_t i;
+    lval* x;
+} lseq_iter;
+
+void  lval_seq_start(lseq_iter* it, lval* s);
+lval* lval_seq_next(lseq_iter* it);
+void  lval_seq_stop(lseq_iter* it);
+
+// The first max values of a Sequence, packed as pmap packs its results: a
+// Vector if they all fit one and a list otherwise, or the first error among
+// them. *more is set if the Sequence had more values. The Sequence is left
+// to the caller.
+lval* lval_seq_pack(lval* s, uint64_t max, int* more);
+
+#endif
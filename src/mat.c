@@ -0,0 +1,232 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "mat.h"
+#include "pool.h"
+#include "vec.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define MAT_X86
+#include <immintrin.h>
+#endif
+
+// Each kernel call adds an MR x NR tile of the product into C. Around it, a
+// KC-deep micro-panel of packed B (16 KiB) stays in L1 while it meets every
+// micro-panel of an MC x KC block of packed A (192 KiB) from L2, and the
+// packed KC x NC panel of B is shared by all threads from L3.
+#define MAT_MR 6
+#define MAT_NR 8
+#define MAT_KC 256
+#define MAT_MC 96
+#define MAT_NC 4096
+
+// Columns of C per task, and the product size (multiply-adds) below which
+// waking the pool costs more than it saves
+#define MAT_NT 128
+#define MAT_PARALLEL_MIN (1 << 21)
+
+mat mat_alloc(size_t rows, size_t cols) {
+    mat m = { rows, cols, NULL, arena_alloc(rows * cols * 8 + VEC_ALIGN) };
+    m.data = (double*)(((uintptr_t)m.block + VEC_ALIGN - 1) & ~(uintptr_t)(VEC_ALIGN - 1));
+    return m;
+}
+
+void mat_free(mat* m) {
+    arena_free(m->block, m->rows * m->cols * 8 + VEC_ALIGN);
+    m->block = m->data = NULL;
+    m->rows = m->cols = 0;
+}
+
+mat mat_transpose(const mat* a) {
+    // In 32 x 32 tiles, so neither side is walked a whole column at a time
+    mat t = mat_alloc(a->cols, a->rows);
+    for (size_t i0 = 0; i0 < a->rows; i0 += 32) {
+        size_t i1 = i0 + 32 < a->rows ? i0 + 32 : a->rows;
+        for (size_t j0 = 0; j0 < a->cols; j0 += 32) {
+            size_t j1 = j0 + 32 < a->cols ? j0 + 32 : a->cols;
+            for (size_t i = i0; i < i1; i++) {
+                for (size_t j = j0; j < j1; j++) { t.data[j * a->rows + i] = a->data[i * a->cols + j]; }
+            }
+        }
+    }
+    return t;
+}
+
+static void mat_kernel_scalar(size_t kc, const double* a, const double* b, double* c, size_t ldc) {
+    double t[MAT_MR][MAT_NR] = { { 0 } };
+    for (size_t k = 0; k < kc; k++, a += MAT_MR, b += MAT_NR) {
+        for (int r = 0; r < MAT_MR; r++) {
+            for (int j = 0; j < MAT_NR; j++) { t[r][j] += a[r] * b[j]; }
+        }
+    }
+    for (int r = 0; r < MAT_MR; r++) {
+        for (int j = 0; j < MAT_NR; j++) { c[r * ldc + j] += t[r][j]; }
+    }
+}
+
+#ifdef MAT_X86
+
+// One row of the tile: a[r] times both halves of the row of B
+#define MAT_FMA(r) \
+    x = _mm256_broadcast_sd(a + r); \
+    c##r##0 = _mm256_fmadd_pd(x, b0, c##r##0); \
+    c##r##1 = _mm256_fmadd_pd(x, b1, c##r##1);
+
+#define MAT_STORE(r) \
+    _mm256_storeu_pd(c + r * ldc, _mm256_add_pd(_mm256_loadu_pd(c + r * ldc), c##r##0)); \
+    _mm256_storeu_pd(c + r * ldc + 4, _mm256_add_pd(_mm256_loadu_pd(c + r * ldc + 4), c##r##1));
+
+// The 6 x 8 tile lives in 12 of the 16 ymm registers for the whole loop
+__attribute__((target("avx2,fma")))
+static void mat_kernel_avx2(size_t kc, const double* a, const double* b, double* c, size_t ldc) {
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+    __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+    __m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+    for (size_t k = 0; k < kc; k++, a += MAT_MR, b += MAT_NR) {
+        __m256d b0 = _mm256_load_pd(b);
+        __m256d b1 = _mm256_load_pd(b + 4);
+        __m256d x;
+        MAT_FMA(0) MAT_FMA(1) MAT_FMA(2) MAT_FMA(3) MAT_FMA(4) MAT_FMA(5)
+    }
+    MAT_STORE(0) MAT_STORE(1) MAT_STORE(2) MAT_STORE(3) MAT_STORE(4) MAT_STORE(5)
+}
+
+#endif
+
+typedef void (*mat_kernel)(size_t kc, const double* a, const double* b, double* c, size_t ldc);
+
+static mat_kernel mat_pick_kernel(void) {
+#ifdef MAT_X86
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) { return mat_kernel_avx2; }
+#endif
+    return mat_kernel_scalar;
+}
+
+// Packing buffers, kept between calls by each thread that multiplies. Only
+// the calling thread resizes them.
+typedef struct { double* data; void* block; size_t capacity; } mat_buffer;
+
+static double* mat_reserve(mat_buffer* b, size_t n) {
+    if (n > b->capacity) {
+        free(b->block);
+        b->block = malloc(n * 8 + VEC_ALIGN);
+        b->data = (double*)(((uintptr_t)b->block + VEC_ALIGN - 1) & ~(uintptr_t)(VEC_ALIGN - 1));
+        b->capacity = n;
+    }
+    return b->data;
+}
+
+// One KC x NC step of the product: A's columns [pc, pc + kc) times B's
+// block of rows [pc, pc + kc) and columns [jc, jc + nc)
+typedef struct {
+    const mat* a;
+    const mat* b;
+    mat* c;
+    size_t pc, kc, jc, nc;
+    double* pa;
+    double* pb;
+    size_t a_blocks, b_blocks;
+    mat_kernel kernel;
+} mat_step;
+
+// Packs MC rows of A, as MR-row micro-panels laid out column by column, or
+// NT columns of B, as NR-column micro-panels laid out row by row. Rows and
+// columns past the edge are zero.
+static void mat_pack(void* ctx, size_t i, int worker) {
+    const mat_step* s = ctx;
+    (void)worker;
+    if (i < s->a_blocks) {
+        const mat* a = s->a;
+        for (size_t r0 = i * MAT_MC; r0 < a->rows && r0 < (i + 1) * MAT_MC; r0 += MAT_MR) {
+            double* dst = s->pa + r0 * s->kc;
+            size_t mr = a->rows - r0 < MAT_MR ? a->rows - r0 : MAT_MR;
+            for (size_t k = 0; k < s->kc; k++) {
+                for (size_t r = 0; r < MAT_MR; r++) {
+                    *dst++ = r < mr ? a->data[(r0 + r) * a->cols + s->pc + k] : 0;
+                }
+            }
+        }
+        return;
+    }
+
+    const mat* b = s->b;
+    i -= s->a_blocks;
+    for (size_t j0 = i * MAT_NT; j0 < s->nc && j0 < (i + 1) * MAT_NT; j0 += MAT_NR) {
+        double* dst = s->pb + j0 * s->kc;
+        size_t nr = s->nc - j0 < MAT_NR ? s->nc - j0 : MAT_NR;
+        for (size_t k = 0; k < s->kc; k++) {
+            const double* row = b->data + (s->pc + k) * b->cols + s->jc + j0;
+            for (size_t j = 0; j < MAT_NR; j++) { *dst++ = j < nr ? row[j] : 0; }
+        }
+    }
+}
+
+// Adds one MC x NT tile of the step into C. Edge tiles go through a scratch
+// tile, so the kernel always works on whole ones.
+static void mat_compute(void* ctx, size_t t, int worker) {
+    const mat_step* s = ctx;
+    size_t m = s->c->rows, n = s->c->cols;
+    size_t i0 = t / s->b_blocks * MAT_MC, i1 = i0 + MAT_MC < m ? i0 + MAT_MC : m;
+    size_t j0 = t % s->b_blocks * MAT_NT, j1 = j0 + MAT_NT < s->nc ? j0 + MAT_NT : s->nc;
+    (void)worker;
+
+    for (size_t j = j0; j < j1; j += MAT_NR) {
+        const double* pb = s->pb + j * s->kc;
+        for (size_t i = i0; i < i1; i += MAT_MR) {
+            const double* pa = s->pa + i * s->kc;
+            double* c = s->c->data + i * n + s->jc + j;
+            if (i + MAT_MR <= m && j + MAT_NR <= s->nc) {
+                s->kernel(s->kc, pa, pb, c, n);
+                continue;
+            }
+
+            double edge[MAT_MR * MAT_NR] = { 0 };
+            s->kernel(s->kc, pa, pb, edge, MAT_NR);
+            for (size_t r = 0; r < MAT_MR && i + r < m; r++) {
+                for (size_t q = 0; q < MAT_NR && j + q < s->nc; q++) { c[r * n + q] += edge[r * MAT_NR + q]; }
+            }
+        }
+    }
+}
+
+static void mat_run(size_t n, void (*body)(void* ctx, size_t i, int worker), void* ctx, int parallel) {
+    if (parallel) {
+        pool_for(n, body, ctx);
+    } else {
+        for (size_t i = 0; i < n; i++) { body(ctx, i, 0); }
+    }
+}
+
+mat mat_mul(const mat* a, const mat* b) {
+    static mat_kernel kernel;
+    static __thread mat_buffer pack_a, pack_b;
+    if (kernel == NULL) { kernel = mat_pick_kernel(); }
+
+    size_t m = a->rows, k = a->cols, n = b->cols;
+    mat c = mat_alloc(m, n);
+    memset(c.data, 0, m * n * 8);
+    int parallel = (double)m * n * k >= MAT_PARALLEL_MIN;
+
+    // A is packed whole for each KC slice, so every tile of C can be a task
+    size_t m_panels = (m + MAT_MR - 1) / MAT_MR * MAT_MR;
+    double* pa = mat_reserve(&pack_a, m_panels * MAT_KC);
+    double* pb = mat_reserve(&pack_b, (size_t)MAT_NC * MAT_KC);
+
+    for (size_t jc = 0; jc < n; jc += MAT_NC) {
+        size_t nc = n - jc < MAT_NC ? n - jc : MAT_NC;
+        for (size_t pc = 0; pc < k; pc += MAT_KC) {
+            mat_step s = {
+                a, b, &c, pc, k - pc < MAT_KC ? k - pc : MAT_KC, jc, nc, pa, pb,
+                (m + MAT_MC - 1) / MAT_MC, (nc + MAT_NT - 1) / MAT_NT, kernel,
+            };
+            mat_run(s.a_blocks + s.b_blocks, mat_pack, &s, parallel);
+            mat_run(s.a_blocks * s.b_blocks, mat_compute, &s, parallel);
+        }
+    }
+    return c;
+}
@@ -0,0 +1,31 @@
+#ifndef MYCLC_MAT_H
+#define MYCLC_MAT_H
+
+#include <stddef.h>
+
+// Dense matrices of doubles, stored row-major in a VEC_ALIGN-aligned buffer,
+// so the vector kernels apply to them element-wise. Every matrix has at least
+// one row and one column.
+
+typedef struct mat {
+    size_t rows;
+    size_t cols;
+    double* data;
+    void* block;
+} mat;
+
+// Most elements a product may have, 2 GiB of doubles
+#define MAT_MAX_ELEMENTS ((size_t)1 << 28)
+
+// Uninitialised matrix from the evaluation arena
+mat  mat_alloc(size_t rows, size_t cols);
+void mat_free(mat* m);
+
+// a * b, for a->cols == b->rows. Both are packed into cache-sized panels and
+// multiplied 6x8 tiles at a time, by an AVX2/FMA kernel where the CPU has
+// one, spread over the thread pool once the product is big enough.
+mat  mat_mul(const mat* a, const mat* b);
+
+mat  mat_transpose(const mat* a);
+
+#endif
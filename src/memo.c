@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "intern.h"
+#include "memo.h"
+
+typedef struct memo_entry {
+    memo_key key;
+    lval* value;
+    int slot;
+    unsigned char referenced;
+} memo_entry;
+
+memo_stats memo_counters;
+
+// Entries live in a fixed array swept by the CLOCK hand; slots is an
+// open-addressing table of entry + 1 (0 marks an empty slot)
+static memo_entry* entries;
+static int capacity;
+static int count;
+static int hand;
+static int* slots;
+static unsigned slot_mask;
+
+void memo_init(int size) {
+    unsigned n = 1;
+    while (n < (unsigned)size * 2) { n <<= 1; }
+
+    entries    = calloc(size, sizeof(memo_entry));
+    capacity   = size;
+    slots      = calloc(n, sizeof(int));
+    slot_mask  = n - 1;
+}
+
+int memo_enabled(void) { return capacity > 0; }
+
+// Appends tag, sign, length and limbs of x to k
+static int memo_key_big(memo_key* k, char tag, const bigint* x) {
+    if (k->len + 3 + (int)sizeof(uint64_t) * x->len > MEMO_KEY_MAX) { return 0; }
+    k->bytes[k->len++] = tag;
+    k->bytes[k->len++] = (unsigned char)x->neg;
+    k->bytes[k->len++] = (unsigned char)x->len;
+    memcpy(&k->bytes[k->len], x->d, sizeof(uint64_t) * x->len);
+    k->len += sizeof(uint64_t) * x->len;
+    return 1;
+}
+
+// Appends the preorder serialization of v to k. Returns 0 if v holds anything
+// impure (errors, non-builtin symbols) or the key would overflow.
+static int memo_key_add(memo_key* k, lval* v) {
+    int type = lval_type(v);
+    long num;
+
+    switch (type)
+    {
+        case LVAL_NUM:
+            if (k->len + 1 + (int)sizeof(long) > MEMO_KEY_MAX) { return 0; }
+            num = lval_num_val(v);
+            k->bytes[k->len++] = 'n';
+            memcpy(&k->bytes[k->len], &num, sizeof(long));
+            k->len += sizeof(long);
+            return 1;
+
+        case LVAL_BIG:
+            return memo_key_big(k, 'b', &v->big);
+
+        case LVAL_RAT:
+            return memo_key_big(k, 'r', &v->big) && memo_key_big(k, '/', &v->den);
+
+        case LVAL_DEC:
+            if (k->len + 1 + (int)sizeof(__int128) > MEMO_KEY_MAX) { return 0; }
+            k->bytes[k->len++] = 'm';
+            memcpy(&k->bytes[k->len], &v->dec, sizeof(__int128));
+            k->len += sizeof(__int128);
+            return 1;
+
+        // By bit pattern, so 0.0 and -0.0 stay apart
+        case LVAL_DBL:
+            if (k->len + 1 + (int)sizeof(double) > MEMO_KEY_MAX) { return 0; }
+            k->bytes[k->len++] = 'd';
+            memcpy(&k->bytes[k->len], &v->dbl, sizeof(double));
+            k->len += sizeof(double);
+            return 1;
+
+        // precision changes what every later Float means
+        case LVAL_SYM:
+            if (v->sym >= SYM_BUILTIN_COUNT || v->sym == SYM_PRECISION) { return 0; }
+            if (k->len + 2 > MEMO_KEY_MAX) { return 0; }
+            k->bytes[k->len++] = 's';
+            k->bytes[k->len++] = (unsigned char)v->sym;
+            return 1;
+
+        case LVAL_SEXPR:
+            if (k->len + 1 + (int)sizeof(int) > MEMO_KEY_MAX) { return 0; }
+            k->bytes[k->len++] = '(';
+            memcpy(&k->bytes[k->len], &v->count, sizeof(int));
+            k->len += sizeof(int);
+            for (int i = 0; i < v->count; i++) {
+                if (!memo_key_add(k, v->cell[i])) { return 0; }
+            }
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+// FNV-1a, 64-bit
+static uint64_t memo_hash(const unsigned char* p, int len) {
+    uint64_t h = 14695981039346656037ull;
+    for (int i = 0; i < len; i++) { h = (h ^ p[i]) * 1099511628211ull; }
+    return h;
+}
+
+// Slot holding key k, or the empty slot where it would go
+static int memo_find(memo_key* k) {
+    unsigned i = (unsigned)k->hash & slot_mask;
+    while (slots[i] != 0) {
+        memo_key* e = &entries[slots[i] - 1].key;
+        if (e->hash == k->hash && e->len == k->len && memcmp(e->bytes, k->bytes, k->len) == 0) {
+            break;
+        }
+        i = (i + 1) & slot_mask;
+    }
+    return i;
+}
+
+// Empties slot i, shifting later members of its probe run back
+static void memo_unslot(unsigned i) {
+    slots[i] = 0;
+    for (unsigned j = (i + 1) & slot_mask; slots[j] != 0; j = (j + 1) & slot_mask) {
+        memo_entry* e = &entries[slots[j] - 1];
+        unsigned home = (unsigned)e->key.hash & slot_mask;
+
+        // Move e into the hole unless its home lies cyclically in (i, j]
+        if (((j - home) & slot_mask) >= ((j - i) & slot_mask)) {
+            slots[i] = slots[j];
+            e->slot  = i;
+            slots[j] = 0;
+            i = j;
+        }
+    }
+}
+
+int memo_lookup(lval* v, memo_key** key, lval** result) {
+    *key = NULL;
+    if (capacity == 0 || v->count < 2) { return 0; }
+
+    memo_key* k = arena_alloc(sizeof(memo_key));
+    k->len = 0;
+    if (!memo_key_add(k, v)) {
+        arena_free(k, sizeof(memo_key));
+        return 0;
+    }
+    k->hash = memo_hash(k->bytes, k->len);
+
+    int i = memo_find(k);
+    if (slots[i] != 0) {
+        memo_entry* e = &entries[slots[i] - 1];
+        e->referenced = 1;
+        memo_counters.hits++;
+        arena_free(k, sizeof(memo_key));
+        *result = e->value;
+        return 1;
+    }
+
+    memo_counters.misses++;
+    *key = k;
+    return 0;
+}
+
+void memo_store(memo_key* k, lval* result) {
+    // Only immediates can outlive the arena they were evaluated in
+    if (!lval_is_imm(result)) {
+        arena_free(k, sizeof(memo_key));
+        return;
+    }
+
+    memo_entry* e;
+    if (count < capacity) {
+        e = &entries[count++];
+    } else {
+        // CLOCK: skip (and clear) recently used entries, evict the first cold one
+        while (entries[hand].referenced) {
+            entries[hand].referenced = 0;
+            hand = (hand + 1) % capacity;
+        }
+        e = &entries[hand];
+        hand = (hand + 1) % capacity;
+        memo_unslot(e->slot);
+        memo_counters.evictions++;
+    }
+
+    // The slot is looked up after any eviction, which may have moved things
+    memcpy(&e->key, k, sizeof(memo_key));
+    e->value = result;
+    e->referenced = 0;
+    e->slot = memo_find(k);
+    slots[e->slot] = (int)(e - entries) + 1;
+    arena_free(k, sizeof(memo_key));
+}
+
+void memo_report(void) {
+    fprintf(stderr, "memo: %lu hits, %lu misses, %lu evictions, %d/%d entries\n",
+        memo_counters.hits, memo_counters.misses, memo_counters.evictions, count, capacity);
+}
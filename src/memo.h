@@ -0,0 +1,41 @@
+#ifndef MYCLC_MEMO_H
+#define MYCLC_MEMO_H
+
+#include "lval.h"
+
+// Result cache for pure S-Expressions (numbers and builtin operators only),
+// keyed by a structural hash of the unevaluated tree. It holds a bounded
+// number of entries and evicts with CLOCK. Off unless memo_init is called.
+
+// Serialized form of a sexpr; trees too large to fit are not cached
+#define MEMO_KEY_MAX 256
+
+typedef struct memo_key {
+    uint64_t hash;
+    int len;
+    unsigned char bytes[MEMO_KEY_MAX];
+} memo_key;
+
+typedef struct memo_stats {
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+} memo_stats;
+
+extern memo_stats memo_counters;
+
+// Enable the cache with room for size entries
+void memo_init(int size);
+int  memo_enabled(void);
+
+// Returns 1 and sets *result on a hit. Otherwise returns 0 and sets *key to
+// an arena-allocated key for memo_store, or to NULL if v cannot be cached.
+int memo_lookup(lval* v, memo_key** key, lval** result);
+
+// Remembers result for key (if it can be held by value) and frees key
+void memo_store(memo_key* key, lval* result);
+
+// Print the counters to stderr
+void memo_report(void);
+
+#endif
@@ -1,4 +1,19 @@
+// getline, isatty
+#define _POSIX_C_SOURCE 200809L
+
 #include "../libs/mpc.h"
+#include "arena.h"
+#include "decimal.h"
+#include "dtoa.h"
+#include "intern.h"
+#include "lenv.h"
+#include "lval.h"
+#include "memo.h"
+#include "out.h"
+#include "pool.h"
+#include "read.h"
+#include "reduce.h"
+#include "vm.h"
 
 // Compile these functions if compiling on a Windows
 #ifdef _WIN32
@@ -22,90 +37,222 @@ void add_history(char*, unused) {}
 // If compiling on *nix, include and use from editline
 #else
 #include <editline/readline.h>
+#include <unistd.h>
 #endif
 
-// Create enum of lval typeS
-enum { LVAL_NUM, LVAL_ERR, LVAL_SYM, LVAL_SEXPR };
-
-// Define lval (Lisp Value) struct
-typedef struct lval {
-    int type;
-    long num;
-    char* err;
-    char* sym;
-    int count;
-    struct lval** cell;
-} lval;
-
-// Pointer to Number lval type
+// Pointer to Number lval type, immediate unless it is too wide for the tag
 lval* lval_num(long x) {
-    lval* v = malloc(sizeof(lval));
+    if (x >= LVAL_IMM_MIN && x <= LVAL_IMM_MAX) { return lval_imm(x); }
+
+    lval* v = arena_alloc(sizeof(lval));
     v->type = LVAL_NUM;
     v->num  = x;
     return v;
 }
 
+// Pointer to Number lval type for an integer too wide for a long, taking
+// over x; anything that fits in a long becomes a plain Number again
+lval* lval_big(bigint x) {
+    int64_t n;
+    if (bigint_to_i64(&x, &n)) {
+        bigint_free(&x);
+        return lval_num(n);
+    }
+
+    lval* v = arena_alloc(sizeof(lval));
+    v->type = LVAL_BIG;
+    v->big  = x;
+    return v;
+}
+
+// Pointer to Rational lval type num/den in lowest terms, taking over both.
+// The sign is carried by the numerator, and a denominator of 1 leaves a
+// Number.
+lval* lval_rat(bigint num, bigint den) {
+    bigint g = bigint_gcd(&num, &den);
+    if (g.len != 1 || g.d[0] != 1) {
+        bigint n = bigint_div(&num, &g, NULL);
+        bigint d = bigint_div(&den, &g, NULL);
+        bigint_free(&num);
+        bigint_free(&den);
+        num = n;
+        den = d;
+    }
+    bigint_free(&g);
+
+    if (den.neg) {
+        num.neg = num.len > 0 && !num.neg;
+        den.neg = 0;
+    }
+    if (den.len == 1 && den.d[0] == 1) {
+        bigint_free(&den);
+        return lval_big(num);
+    }
+
+    lval* v = arena_alloc(sizeof(lval));
+    v->type = LVAL_RAT;
+    v->big  = num;
+    v->den  = den;
+    return v;
+}
+
+// Pointer to Decimal (scaled fixed-point) lval type
+lval* lval_dec(__int128 x) {
+    lval* v = arena_alloc(sizeof(lval));
+    v->type = LVAL_DEC;
+    v->dec  = x;
+    return v;
+}
+
+// Pointer to Double (floating point) lval type
+lval* lval_dbl(double x) {
+    lval* v = arena_alloc(sizeof(lval));
+    v->type = LVAL_DBL;
+    v->dbl  = x;
+    return v;
+}
+
+// Pointer to multi-precision Float lval type, taking ownership of x
+lval* lval_mpf(bigfloat x) {
+    lval* v = arena_alloc(sizeof(lval));
+    v->type = LVAL_MPF;
+    v->mpf  = x;
+    return v;
+}
+
+// Pointer to Vector lval type, taking ownership of x
+lval* lval_vec(vec x) {
+    lval* v = arena_alloc(sizeof(lval));
+    v->type = LVAL_VEC;
+    v->vec  = x;
+    return v;
+}
+
+// Pointer to Matrix lval type, taking ownership of x
+lval* lval_mat(mat x) {
+    lval* v = arena_alloc(sizeof(lval));
+    v->type = LVAL_MAT;
+    v->mat  = x;
+    return v;
+}
 
 // Pointer to Error lval type
 lval* lval_err(char* m) {
-    lval* v = malloc(sizeof(lval));
+    lval* v = arena_alloc(sizeof(lval));
     v->type = LVAL_ERR;
-    v->err  = malloc(strlen(m) + 1);
-    strcpy(v->err, m);
+    v->err  = arena_strdup(m);
     return v;
 }
 
-// Pointer to Symbol lval type
+// Pointer to Symbol lval type, holding the interned ID of s
 lval* lval_sym(char* s) {
-    lval* v = malloc(sizeof(lval));
+    return lval_sym_id(intern(s, strlen(s)));
+}
+
+// Pointer to Symbol lval type for an already interned symbol
+lval* lval_sym_id(int id) {
+    lval* v = arena_alloc(sizeof(lval));
     v->type = LVAL_SYM;
-    v->sym  = malloc(strlen(s) + 1);
-    strcpy(v->sym, s);
+    v->sym  = id;
     return v;
 }
 
 // Pointer to empty Sexpr lval type
 lval* lval_sexpr(void) {
-    lval* v  = malloc(sizeof(lval));
+    lval* v  = arena_alloc(sizeof(lval));
     v->type  = LVAL_SEXPR;
-    v->count = 0;
-    v->cell  = NULL;
+    v->count    = 0;
+    v->capacity = 0;
+    v->cell     = NULL;
     return v;
 }
 
+// Makes room for one more item on a work stack. The evaluator, reader and
+// printer keep their own stacks instead of recursing, so nesting depth is
+// bounded by memory rather than by the C stack.
+void* stack_reserve(void* items, int count, int* capacity, size_t size) {
+    if (count < *capacity) { return items; }
+    *capacity = *capacity ? *capacity * 2 : 64;
+    items = realloc(items, size * *capacity);
+    if (items == NULL) { abort(); }
+    return items;
+}
+
 // Delete lval and release memory function
 void lval_del(lval* v) {
-    switch (v->type)
-    {
-        case LVAL_NUM: break;
+    static __thread lval** todo;
+    static __thread int capacity;
+    int count = 0;
 
-        // If v->type is Error or Symbol then free the string data
-        case LVAL_ERR:
-            free(v->err);
-            break;
+    todo = stack_reserve(todo, count, &capacity, sizeof(lval*));
+    todo[count++] = v;
 
-        case LVAL_SYM:
-            free(v->sym);
+    while (count > 0) {
+        v = todo[--count];
+
+        // Immediates own no memory
+        if (lval_is_imm(v)) { continue; }
+
+        switch (v->type)
+        {
+            // Symbol names belong to the intern table
+            case LVAL_NUM: break;
+            case LVAL_DEC: break;
+            case LVAL_DBL: break;
+            case LVAL_SYM: break;
+
+            case LVAL_BIG:
+                bigint_free(&v->big);
+                break;
+
+            case LVAL_RAT:
+                bigint_free(&v->big);
+                bigint_free(&v->den);
+                break;
+
+            case LVAL_MPF:
+                bigfloat_free(&v->mpf);
+                break;
+
+            case LVAL_VEC:
+                vec_free(&v->vec);
+                break;
+
+            case LVAL_MAT:
+                mat_free(&v->mat);
+                break;
+
+            // If v->type is Error then free the string data
+            case LVAL_ERR:
+                arena_strfree(v->err);
+                break;
+
+            // If v->type is Sexpr, Function or Sequence then queue all internal elements
+            case LVAL_SEXPR:
+            case LVAL_FUN:
+            case LVAL_SEQ:
+                for (int i = 0; i < v->count; i++) {
+                    todo = stack_reserve(todo, count, &capacity, sizeof(lval*));
+                    todo[count++] = v->cell[i];
+                }
+                // Free allocated memory containing the pointer
+                arena_free(v->cell, sizeof(lval*) * v->capacity);
             break;
+        }
 
-        // If v->type is Sexpr then delete all internal elements
-        case LVAL_SEXPR:
-            for (int i = 0; i < v->count; i++) {
-                lval_del(v->cell[i]);
-            }
-            // Free allocated memory containing the pointer
-            free(v->cell);
-        break;
+        // Free the memory allocated to lval (locally as 'v')
+        arena_free(v, sizeof(lval));
     }
-
-    // Free the memory allocated to lval (locally as 'v')
-    free(v);
 }
 
+// Appends x to the S-Expression, doubling the cell array when it is full
 lval* lval_add(lval* v, lval* x) {
-    v->count++;
-    v->cell = realloc(v->cell, sizeof(lval*) * v->count);
-    v->cell[v->count - 1] = x;
+    if (v->count == v->capacity) {
+        int capacity = v->capacity ? v->capacity * 2 : 4;
+        v->cell = arena_realloc(v->cell, sizeof(lval*) * v->capacity, sizeof(lval*) * capacity);
+        v->capacity = capacity;
+    }
+    v->cell[v->count++] = x;
     return v;
 }
 
@@ -117,11 +264,8 @@ lval* lval_pop(lval* v, int i) {
     // Shifts the memory after [i]
     memmove(&v->cell[i], &v->cell[i + 1], sizeof(lval*) * (v->count - i - 1));
 
-    // Decrease the count of items in the list
+    // Decrease the count of items in the list; the capacity is kept for reuse
     v->count--;
-
-    // Finally, reallocate the memory used
-    v->cell = realloc(v->cell, sizeof(lval*) * v->count);
     return x;
 }
 
@@ -131,227 +275,2392 @@ lval* lval_take(lval* v, int i) {
     return x;
 }
 
-void lval_print(lval* v);
+// Whether v keeps lvals in its cells: an S-Expression, Function or Sequence
+static int lval_has_cells(lval* v) {
+    return lval_type(v) == LVAL_SEXPR || lval_type(v) == LVAL_FUN || lval_type(v) == LVAL_SEQ;
+}
+
+// Copies v alone into the current arena, leaving an S-Expression, Function
+// or Sequence with no cells
+static lval* lval_copy_one(lval* v) {
+    if (lval_is_imm(v)) { return v; }
 
-void lval_expr_print(lval* v, char open, char close) {
-    putchar(open);
-    for (int i = 0; i < v->count; i++)
+    lval* c = arena_alloc(sizeof(lval));
+    c->type = v->type;
+    switch (v->type)
     {
-        // Print Value
-        lval_print(v->cell[i]);
+        case LVAL_NUM: c->num = v->num; break;
+        case LVAL_DEC: c->dec = v->dec; break;
+        case LVAL_DBL: c->dbl = v->dbl; break;
+        case LVAL_SYM: c->sym = v->sym; break;
+        case LVAL_ERR: c->err = arena_strdup(v->err); break;
+
+        case LVAL_BIG:
+            c->big = bigint_copy(&v->big);
+            break;
 
-        // If the last element is trailing space then don't print
-        if (i != (v->count - 1)) {
-            putchar(' ');
+        case LVAL_RAT:
+            c->big = bigint_copy(&v->big);
+            c->den = bigint_copy(&v->den);
+            break;
+
+        case LVAL_MPF:
+            c->mpf   = v->mpf;
+            c->mpf.m = bigint_copy(&v->mpf.m);
+            break;
+
+        // Elements of either kind are 8 bytes
+        case LVAL_VEC:
+            c->vec = vec_alloc(v->vec.kind, v->vec.len);
+            memcpy(c->vec.data, v->vec.data, v->vec.len * 8);
+            break;
+
+        case LVAL_MAT:
+            c->mat = mat_alloc(v->mat.rows, v->mat.cols);
+            memcpy(c->mat.data, v->mat.data, v->mat.rows * v->mat.cols * 8);
+            break;
+
+        case LVAL_SEQ:
+            c->seq = v->seq;
+            // fall through
+        case LVAL_SEXPR:
+        case LVAL_FUN:
+            c->count    = 0;
+            c->capacity = 0;
+            c->cell     = NULL;
+            break;
+    }
+    return c;
+}
+
+// Deep copy of v in the current arena. Like lval_del, nested S-Expressions
+// go on a work stack rather than the C stack.
+lval* lval_copy(lval* v) {
+    typedef struct { lval* from; lval* to; } copy_item;
+    static __thread copy_item* todo;
+    static __thread int capacity;
+    int count = 0;
+
+    lval* root = lval_copy_one(v);
+    if (lval_has_cells(v)) {
+        todo = stack_reserve(todo, count, &capacity, sizeof(copy_item));
+        todo[count++] = (copy_item){ v, root };
+    }
+
+    while (count > 0) {
+        copy_item it = todo[--count];
+        for (int i = 0; i < it.from->count; i++) {
+            lval* c = lval_copy_one(it.from->cell[i]);
+            lval_add(it.to, c);
+            if (lval_has_cells(c)) {
+                todo = stack_reserve(todo, count, &capacity, sizeof(copy_item));
+                todo[count++] = (copy_item){ it.from->cell[i], c };
+            }
         }
     }
+    return root;
+}
+
+// Prints a bigint, formatted straight into the output buffer when it fits
+static void lval_print_big(const bigint* x) {
+    int size = bigint_format_size(x);
+    if (size <= OUT_BUFFER_SIZE) {
+        out_commit(bigint_format(x, out_reserve(size)));
+        return;
+    }
 
-    putchar(close);
+    char* digits = arena_alloc(size);
+    out_bytes(digits, bigint_format(x, digits));
+    arena_free(digits, size);
 }
 
-// Construct what to print (see following function 'lval_println')
-void lval_print(lval* v) {
-    switch (v->type)
+// Prints a multi-precision Float, formatted in place like lval_print_big
+static void lval_print_mpf(const bigfloat* x) {
+    int size = bigfloat_format_size(x);
+    if (size <= OUT_BUFFER_SIZE) {
+        out_commit(bigfloat_format(x, out_reserve(size)));
+        return;
+    }
+
+    char* digits = arena_alloc(size);
+    out_bytes(digits, bigfloat_format(x, digits));
+    arena_free(digits, size);
+}
+
+// Prints a Vector as its literal, [1 2 3], or as [1 2 3 ...] if it is the
+// start of a Sequence with more values
+static void lval_print_vec(const vec* x, int more) {
+    out_char('[');
+    for (size_t i = 0; i < x->len; i++) {
+        if (i > 0) { out_char(' '); }
+        if (x->kind == VEC_I64) {
+            out_long(((const int64_t*)x->data)[i]);
+        } else {
+            out_commit(dtoa_shortest(((const double*)x->data)[i], out_reserve(DTOA_BUFFER_SIZE)));
+        }
+    }
+    out_str(more ? " ...]" : "]");
+}
+
+// Prints a Matrix as its literal, rows separated by ';'. A single row keeps
+// a trailing one, so it reads back as a Matrix: [1.0 2.0;]
+static void lval_print_mat(const mat* x) {
+    out_char('[');
+    for (size_t i = 0; i < x->rows; i++) {
+        if (i > 0) { out_str("; "); }
+        for (size_t j = 0; j < x->cols; j++) {
+            if (j > 0) { out_char(' '); }
+            out_commit(dtoa_shortest(x->data[i * x->cols + j], out_reserve(DTOA_BUFFER_SIZE)));
+        }
+    }
+    out_str(x->rows == 1 ? ";]" : "]");
+}
+
+// Prints any value other than an S-Expression or a Sequence
+static void lval_print_atom(lval* v) {
+    switch (lval_type(v))
     {
         case LVAL_NUM:
-            printf("%li", v->num);
+            out_long(lval_num_val(v));
+            break;
+
+        case LVAL_BIG:
+            lval_print_big(&v->big);
+            break;
+
+        case LVAL_RAT:
+            lval_print_big(&v->big);
+            out_char('/');
+            lval_print_big(&v->den);
+            break;
+
+        case LVAL_DEC:
+            out_commit(dec_format(v->dec, out_reserve(DEC_BUFFER_SIZE)));
+            break;
+
+        case LVAL_DBL:
+            out_commit(dtoa_shortest(v->dbl, out_reserve(DTOA_BUFFER_SIZE)));
+            break;
+
+        case LVAL_MPF:
+            lval_print_mpf(&v->mpf);
+            break;
+
+        case LVAL_VEC:
+            lval_print_vec(&v->vec, 0);
+            break;
+
+        case LVAL_MAT:
+            lval_print_mat(&v->mat);
             break;
 
         case LVAL_ERR:
-            printf("Error: %s", v->err);
+            out_str("Error: ");
+            out_str(v->err);
             break;
 
         case LVAL_SYM:
-            printf("%s", v->sym);
+            out_str(intern_name(v->sym));
             break;
+    }
+}
 
-        case LVAL_SEXPR:
-            lval_expr_print(v, '(', ')');
-            break;
+// Whether v prints as a list of its cells: an S-Expression, or a Function as
+// the lambda that made it
+static int lval_print_nested(lval* v) {
+    return lval_type(v) == LVAL_SEXPR || lval_type(v) == LVAL_FUN;
+}
+
+static void lval_print_open(lval* v) {
+    out_str(v->type == LVAL_FUN ? "(\\ " : "(");
+}
+
+// The most values of a Sequence that are made to print it; any after those
+// show as "..."
+#define LVAL_PRINT_MAX 100000
+
+// Each frame is an S-Expression and the index of its next element. The
+// values made to print a Sequence belong to its frame, with whether the
+// Sequence had more.
+typedef struct { lval* v; int i; int made; int more; } print_frame;
+
+// Prints x, or opens a frame for it if it has cells to print. A Sequence
+// prints as its first values, packed as pmap would pack them.
+static void lval_print_item(lval* x, print_frame** stack, int* top, int* capacity) {
+    int made = 0, more = 0;
+    if (lval_type(x) == LVAL_SEQ) {
+        x = lval_seq_pack(x, LVAL_PRINT_MAX, &more);
+        made = 1;
+    }
+
+    if (lval_print_nested(x)) {
+        *stack = stack_reserve(*stack, *top, capacity, sizeof(print_frame));
+        (*stack)[(*top)++] = (print_frame){ x, 0, made, more };
+        lval_print_open(x);
+        return;
+    }
+    if (lval_type(x) == LVAL_VEC) {
+        lval_print_vec(&x->vec, more);
+    } else {
+        lval_print_atom(x);
+    }
+    if (made) { lval_del(x); }
+}
+
+// Construct what to print (see following function 'lval_println')
+void lval_print(lval* v) {
+    static __thread print_frame* stack;
+    static __thread int capacity;
+    int top = 0;
+
+    lval_print_item(v, &stack, &top, &capacity);
+    while (top > 0) {
+        print_frame* f = &stack[top - 1];
+
+        // A Function prints as the lambda that made it, without its bindings
+        int count = f->v->type == LVAL_FUN ? LVAL_FUN_ENV : f->v->count;
+        if (f->i == count) {
+            out_str(f->more ? " ...)" : ")");
+            if (f->made) { lval_del(f->v); }
+            top--;
+            continue;
+        }
+
+        // If the last element is trailing space then don't print
+        lval* x = f->v->cell[f->i];
+        if (f->i++ > 0) { out_char(' '); }
+        lval_print_item(x, &stack, &top, &capacity);
     }
 }
 
 // Print lval
 void lval_println(lval* v) {
     lval_print(v);
-    putchar('\n');
+    out_newline();
 }
 
-// Functions similarly to eval_op function
-// Takes a single lval* which represents a list of all arguments which need operation
-lval* builtin_op(lval* a, char* op) {
-
-    // Check all arguments are numbers
-    for (int i = 0; i < a->count; i++)
+// Value of a Number or Double lval as a double
+static double lval_dbl_val(lval* v) {
+    switch (lval_type(v))
     {
-        if (a->cell[i]->type != LVAL_NUM)
-        {
-            lval_del(a);
-            return lval_err("Cannot operate on a non-number!");
-        }
+        case LVAL_DBL: return v->dbl;
+        case LVAL_MPF: return bigfloat_to_double(&v->mpf);
+        case LVAL_BIG: return bigint_to_double(&v->big);
+        case LVAL_RAT: return bigint_to_double(&v->big) / bigint_to_double(&v->den);
+        case LVAL_DEC: return dec_to_double(v->dec);
+        default:       return (double)lval_num_val(v);
     }
+}
 
-    // Pops the first element of the list
-    lval* x = lval_pop(a, 0);
+lval* lval_vec_pack(lval* list) {
+    // Integers stay integers unless a Float is among them; Floats read at a
+    // raised precision are rounded to doubles
+    int kind = VEC_I64;
+    for (int i = 0; i < list->count; i++) {
+        int type = lval_type(list->cell[i]);
+        if (type == LVAL_ERR) { return lval_take(list, i); }
+        if (type == LVAL_DBL || type == LVAL_MPF) {
+            kind = VEC_F64;
+        } else if (type != LVAL_NUM) {
+            lval_del(list);
+            return lval_err("Vector elements must be 64-bit integers or floats!");
+        }
+    }
 
-    // If there are no arguments and operation is '-' then perform unary negation
-    if ((strcmp(op, "-") == 0) && a->count == 0) { x->num = -x->num; }
+    vec v = vec_alloc(kind, list->count);
+    for (int i = 0; i < list->count; i++) {
+        if (kind == VEC_I64) {
+            ((int64_t*)v.data)[i] = lval_num_val(list->cell[i]);
+        } else {
+            ((double*)v.data)[i] = lval_dbl_val(list->cell[i]);
+        }
+    }
+    lval_del(list);
+    return lval_vec(v);
+}
 
-    // While there are elements remaining, continue
-    while (a->count > 0)
-    {
-        // Pop element
-        lval* y = lval_pop(a, 0);
+// A list of results as a Vector when every one is a 64-bit integer or
+// double, and otherwise the list itself, so bignums, rationals and the like
+// keep their values. The first error among them instead.
+static lval* lval_list_pack(lval* list) {
+    for (int i = 0; i < list->count; i++) {
+        if (lval_type(list->cell[i]) == LVAL_ERR) { return lval_take(list, i); }
+    }
+    for (int i = 0; i < list->count; i++) {
+        int type = lval_type(list->cell[i]);
+        if (type != LVAL_NUM && type != LVAL_DBL) { return list; }
+    }
+    return lval_vec_pack(list);
+}
 
-        if (strcmp(op, "+") == 0) { x->num += y->num; }
-        if (strcmp(op, "-") == 0) { x->num -= y->num; }
-        if (strcmp(op, "*") == 0) { x->num *= y->num; }
-        if (strcmp(op, "/") == 0)
-        {
-            if (y->num == 0)
-            {
-                lval_del(x);
-                lval_del(y);
-                x = lval_err("Cannot divide by zero!");
-                break;
+lval* lval_mat_pack(lval* rows) {
+    // A ';' just before the ']' ends the last row rather than starting one
+    if (rows->count > 1 && rows->cell[rows->count - 1]->count == 0) { lval_del(lval_pop(rows, rows->count - 1)); }
+
+    size_t cols = rows->cell[0]->count;
+    for (int i = 0; i < rows->count; i++) {
+        lval* row = rows->cell[i];
+        for (int j = 0; j < row->count; j++) {
+            int type = lval_type(row->cell[j]);
+            if (type == LVAL_ERR) {
+                lval* err = lval_pop(row, j);
+                lval_del(rows);
+                return err;
             }
-
-            x->num /= y->num;
+            if (type != LVAL_NUM && type != LVAL_DBL && type != LVAL_MPF) {
+                lval_del(rows);
+                return lval_err("Matrix elements must be 64-bit integers or floats!");
+            }
+        }
+        if (row->count == 0) {
+            lval_del(rows);
+            return lval_err("Matrix rows cannot be empty!");
         }
+        if ((size_t)row->count != cols) {
+            lval_del(rows);
+            return lval_err("Matrix rows differ in length!");
+        }
+    }
 
-        lval_del(y);
+    mat m = mat_alloc(rows->count, cols);
+    for (int i = 0; i < rows->count; i++) {
+        for (size_t j = 0; j < cols; j++) { m.data[i * cols + j] = lval_dbl_val(rows->cell[i]->cell[j]); }
     }
+    lval_del(rows);
+    return lval_mat(m);
+}
 
-    lval_del(a);
-    return x;
+// Double copy of an integer Vector
+static vec lval_vec_f64(const vec* x) {
+    vec r = vec_alloc(VEC_F64, x->len);
+    for (size_t i = 0; i < x->len; i++) {
+        ((double*)r.data)[i] = (double)((const int64_t*)x->data)[i];
+    }
+    return r;
 }
 
-lval* lval_eval(lval* v);
+// x op y where at least one is a Vector and the other a Vector of the same
+// length or a scalar, which is broadcast. Anything but integer Vectors and
+// Numbers makes a double Vector, as does an integer division that leaves a
+// remainder, since Vectors have no rational elements. With reuse set, x is
+// the caller's own and, if a Vector, may be updated in place and returned.
+static lval* lval_vec_apply(int vop, lval* x, lval* y, int reuse) {
+    lval* ops[2] = { x, y };
+    size_t len = 0;
+    int f64 = 0, vecs = 0, big = 0;
+    for (int k = 0; k < 2; k++) {
+        int type = lval_type(ops[k]);
+        if (type == LVAL_VEC) {
+            if (vecs++ > 0 && ops[k]->vec.len != len) { return lval_err("Vector lengths differ!"); }
+            len = ops[k]->vec.len;
+            f64 |= ops[k]->vec.kind == VEC_F64;
+        } else {
+            big |= type == LVAL_BIG;
+            f64 |= type != LVAL_NUM && type != LVAL_BIG;
+        }
+    }
 
-// Evaluates S-expression
-lval* lval_eval_sexpr(lval* v) {
-    // Evaluate Sexpr's children
-    for (int i = 0; i < v->count; i++) {
-        v->cell[i] = lval_eval(v->cell[i]);
+    // A bignum does not fit an int64_t lane, any more than a result that
+    // overflows one does; only a float operand makes the Vector floats
+    if (big && !f64) { return lval_err("Integer overflow in vector!"); }
+    f64 |= big;
+
+    // Each operand as a pointer and a step: 1 walks a Vector, 0 repeats a
+    // scalar
+    int64_t ki[2];
+    int steps[2];
+    for (int k = 0; k < 2; k++) {
+        steps[k] = lval_type(ops[k]) == LVAL_VEC;
+        if (!steps[k]) { ki[k] = lval_num_val(ops[k]); }
     }
 
-    // Errors
-    for (int i = 0; i < v->count; i++) {
-        if (v->cell[i]->type == LVAL_ERR) { return lval_take(v, i); }
+    if (!f64) {
+        const int64_t* a = steps[0] ? x->vec.data : &ki[0];
+        const int64_t* b = steps[1] ? y->vec.data : &ki[1];
+        if (vop == VEC_DIV && vec_any_zero_i64(b, steps[1] ? len : 1)) {
+            return lval_err("Cannot divide by zero!");
+        }
+
+        // Not in place for division, which may have to start over in doubles
+        if (reuse && steps[0] && vop != VEC_DIV) {
+            return vec_map_i64(vop, x->vec.data, a, 1, b, steps[1], len) ? x : lval_err("Integer overflow in vector!");
+        }
+
+        vec r = vec_alloc(VEC_I64, len);
+        if (vec_map_i64(vop, r.data, a, steps[0], b, steps[1], len)) { return lval_vec(r); }
+        vec_free(&r);
+        if (vop != VEC_DIV) { return lval_err("Integer overflow in vector!"); }
     }
 
-    // If Expression is empty
-    if (v->count == 0) { return v; }
+    // Integer Vectors are widened into temporaries
+    double kd[2];
+    vec wide[2] = { { 0 }, { 0 } };
+    const double* d[2];
+    for (int k = 0; k < 2; k++) {
+        if (!steps[k]) {
+            kd[k] = lval_dbl_val(ops[k]);
+            d[k] = &kd[k];
+        } else if (ops[k]->vec.kind == VEC_I64) {
+            wide[k] = lval_vec_f64(&ops[k]->vec);
+            d[k] = wide[k].data;
+        } else {
+            d[k] = ops[k]->vec.data;
+        }
+    }
 
-    // If Expression is single
-    if (v->count == 1) { return lval_take(v, 0); }
+    lval* result;
+    if (vop == VEC_DIV && vec_any_zero_f64(d[1], steps[1] ? len : 1)) {
+        result = lval_err("Cannot divide by zero!");
+    } else if (reuse && steps[0] && x->vec.kind == VEC_F64) {
+        vec_map_f64(vop, x->vec.data, d[0], 1, d[1], steps[1], len);
+        result = x;
+    } else {
+        vec r = vec_alloc(VEC_F64, len);
+        vec_map_f64(vop, r.data, d[0], steps[0], d[1], steps[1], len);
+        result = lval_vec(r);
+    }
+    for (int k = 0; k < 2; k++) {
+        if (wide[k].block != NULL) { vec_free(&wide[k]); }
+    }
+    return result;
+}
 
-    // Checks that the first element is a Symbol
-    lval* f = lval_pop(v, 0);
-    if (f->type != LVAL_SYM)
+// The same for Matrices, which always hold doubles
+static lval* lval_mat_apply(int vop, lval* x, lval* y, int reuse) {
+    lval* ops[2] = { x, y };
+    const mat* shape = NULL;
+    double kd[2];
+    const double* d[2];
+    int steps[2];
+    for (int k = 0; k < 2; k++) {
+        steps[k] = lval_type(ops[k]) == LVAL_MAT;
+        if (!steps[k]) {
+            kd[k] = lval_dbl_val(ops[k]);
+            d[k] = &kd[k];
+            continue;
+        }
+        if (shape != NULL && (shape->rows != ops[k]->mat.rows || shape->cols != ops[k]->mat.cols)) {
+            return lval_err("Matrix shapes differ!");
+        }
+        shape = &ops[k]->mat;
+        d[k] = shape->data;
+    }
+
+    size_t len = shape->rows * shape->cols;
+    if (vop == VEC_DIV && vec_any_zero_f64(d[1], steps[1] ? len : 1)) { return lval_err("Cannot divide by zero!"); }
+    if (reuse && steps[0]) {
+        vec_map_f64(vop, x->mat.data, d[0], 1, d[1], steps[1], len);
+        return x;
+    }
+
+    mat r = mat_alloc(shape->rows, shape->cols);
+    vec_map_f64(vop, r.data, d[0], steps[0], d[1], steps[1], len);
+    return lval_mat(r);
+}
+
+// lval_fold once any argument is a Vector, or a Matrix, of the given type:
+// + - * / apply element by element, from the left, with scalars broadcast.
+// apply combines two operands.
+static lval* lval_fold_each(int op, lval** args, int n, int type, lval* (*apply)(int, lval*, lval*, int)) {
+    int vop;
+    switch (op)
     {
-        lval_del(f);
-        lval_del(v);
-        return lval_err("S-Expression does not begin with a symbol!");
+        case SYM_ADD: vop = VEC_ADD; break;
+        case SYM_SUB: vop = VEC_SUB; break;
+        case SYM_MUL: vop = VEC_MUL; break;
+        case SYM_DIV: vop = VEC_DIV; break;
+        default:      return lval_err(type == LVAL_VEC ? "Operator does not take vectors!" : "Operator does not take matrices!");
     }
 
-    // Call builtin_op function with an operator
-    lval* result = builtin_op(v, f->sym);
-    lval_del(f);
-    return result;
+    // (- v) negates, and a lone operand otherwise comes back unchanged, as a
+    // copy made by multiplying it by 1
+    if (n == 1) {
+        if (op == SYM_SUB) { return apply(VEC_SUB, lval_num(0), args[0], 0); }
+        return apply(VEC_MUL, args[0], lval_num(1), 0);
+    }
+
+    // Scalars ahead of the first Vector or Matrix fold exactly, as they would
+    // alone.
+    // Past the first step the accumulator is ours to update in place.
+    int first = 0;
+    while (lval_type(args[first]) != type) { first++; }
+    int owned = first > 1;
+    lval* acc = owned ? lval_fold(op, args, first) : args[0];
+    if (lval_type(acc) == LVAL_ERR) { return acc; }
+
+    for (int i = owned ? first : 1; i < n; i++) {
+        lval* r = apply(vop, acc, args[i], owned);
+        if (owned && r != acc) { lval_del(acc); }
+        acc = r;
+        owned = 1;
+        if (lval_type(acc) == LVAL_ERR) { break; }
+    }
+    return acc;
 }
 
-// Evaluates lval type
-lval* lval_eval(lval* v) {
-    // S-expressions
-    if (v->type == LVAL_SEXPR) { return lval_eval_sexpr(v); }
-    // All other lval types
-    return v;
+// (matmul a b ...) multiplies Matrices from the left
+static lval* lval_matmul(lval** args, int n) {
+    int ok = n >= 2;
+    for (int i = 0; i < n; i++) { ok &= lval_type(args[i]) == LVAL_MAT; }
+    if (!ok) { return lval_err("matmul takes two or more matrices!"); }
+
+    mat acc = args[0]->mat;
+    for (int i = 1; i < n; i++) {
+        const mat* b = &args[i]->mat;
+        char* err = NULL;
+        if (acc.cols != b->rows) {
+            err = "Inner matrix dimensions differ!";
+        } else if ((double)acc.rows * b->cols > MAT_MAX_ELEMENTS) {
+            err = "Matrix too large!";
+        }
+
+        // Products along the way are ours to free; the first operand is not
+        mat r = { 0 };
+        if (err == NULL) { r = mat_mul(&acc, b); }
+        if (i > 1) { mat_free(&acc); }
+        if (err != NULL) { return lval_err(err); }
+        acc = r;
+    }
+    return lval_mat(acc);
 }
 
-lval* lval_read_num(mpc_ast_t* t) {
-    errno = 0;
-    long x = strtol(t->contents, NULL, 10);
-    return errno != ERANGE ?
-        lval_num(x) : lval_err("Invalid number!");
+static lval* lval_transpose(lval** args, int n) {
+    if (n != 1 || lval_type(args[0]) != LVAL_MAT) { return lval_err("transpose takes one matrix!"); }
+    return lval_mat(mat_transpose(&args[0]->mat));
 }
 
-lval* lval_read(mpc_ast_t* t) {
-    // If lval type is Symbol or Number return conversion to Symbol or Number
-    if (strstr(t->tag, "number")) { return lval_read_num(t); }
-    if (strstr(t->tag, "symbol")) { return lval_sym(t->contents); }
+// (sum v), (prod v), (min v) and (max v) reduce a single Vector. Integer sums
+// and products that overflow come back as bignums. Sequences are reduced by
+// lval_reduce_seq.
+static lval* lval_reduce_vec(int op, lval** args, int n) {
+    char message[64];
+    if (n != 1 || lval_type(args[0]) != LVAL_VEC) {
+        snprintf(message, sizeof(message), "%s takes one vector or sequence!", intern_name(op));
+        return lval_err(message);
+    }
 
-    // If > or Sexpr then create an empty list
-    lval* x = NULL;
-    if (strcmp(t->tag, ">") == 0) { x = lval_sexpr(); }
-    if (strstr(t->tag, "sexpr"))  { x = lval_sexpr(); }
+    const vec* v = &args[0]->vec;
+    if (v->len == 0 && (op == SYM_MIN || op == SYM_MAX)) {
+        snprintf(message, sizeof(message), "%s of an empty vector!", intern_name(op));
+        return lval_err(message);
+    }
+
+    if (v->kind == VEC_F64) {
+        const double* xs = v->data;
+        switch (op)
+        {
+            case SYM_SUM:  return lval_dbl(reduce_sum_f64(xs, v->len));
+            case SYM_PROD: return lval_dbl(reduce_prod_f64(xs, v->len));
+            case SYM_MIN:  return lval_dbl(reduce_min_f64(xs, v->len));
+            default:       return lval_dbl(reduce_max_f64(xs, v->len));
+        }
+    }
 
-    // Fill list with any valid expression (expr)
-    for (int i = 0; i < t->children_num; i++)
+    const int64_t* xs = v->data;
+    __int128 wide;
+    int64_t acc;
+    switch (op)
     {
-        if (strcmp(t->children[i]->contents, "(") == 0) { continue; }
-        if (strcmp(t->children[i]->contents, ")") == 0) { continue; }
-        if (strcmp(t->children[i]->contents, "{") == 0) { continue; }
-        if (strcmp(t->children[i]->contents, "}") == 0) { continue; }
-        if (strcmp(t->children[i]->tag, "regex")  == 0) { continue; }
-        x = lval_add(x, lval_read(t->children[i]));
+        case SYM_SUM:
+            wide = reduce_sum_i64(xs, v->len);
+            if (wide < INT64_MIN || wide > INT64_MAX) { return lval_big(bigint_from_i128(wide)); }
+            return lval_num((int64_t)wide);
+
+        case SYM_PROD:
+        {
+            if (reduce_prod_i64(xs, v->len, &acc)) { return lval_num(acc); }
+            bigint p = bigint_from_i128(1);
+            for (size_t i = 0; i < v->len; i++) {
+                uint64_t limb;
+                bigint x = bigint_view_i64(xs[i], &limb);
+                bigint t = bigint_mul(&p, &x);
+                bigint_free(&p);
+                p = t;
+            }
+            return lval_big(p);
+        }
+
+        case SYM_MIN: return lval_num(reduce_min_i64(xs, v->len));
+        default:      return lval_num(reduce_max_i64(xs, v->len));
     }
+}
 
-    return x;
+// lval_fold once any argument is a Double: everything is promoted
+static lval* lval_fold_dbl(int op, lval** args, int n) {
+    double acc = lval_dbl_val(args[0]);
+
+    switch (op)
+    {
+        case SYM_ADD:
+            for (int i = 1; i < n; i++) { acc += lval_dbl_val(args[i]); }
+            break;
+
+        case SYM_SUB:
+            if (n == 1) { acc = -acc; }
+            for (int i = 1; i < n; i++) { acc -= lval_dbl_val(args[i]); }
+            break;
+
+        case SYM_MUL:
+            for (int i = 1; i < n; i++) { acc *= lval_dbl_val(args[i]); }
+            break;
+
+        case SYM_DIV:
+            for (int i = 1; i < n; i++)
+            {
+                double d = lval_dbl_val(args[i]);
+                if (d == 0) { return lval_err("Cannot divide by zero!"); }
+                acc /= d;
+            }
+            break;
+
+        case SYM_MOD:
+            for (int i = 1; i < n; i++)
+            {
+                double d = lval_dbl_val(args[i]);
+                if (d == 0) { return lval_err("Cannot divide by zero!"); }
+                acc = fmod(acc, d);
+            }
+            break;
+
+        default:
+            return lval_err("Unknown operator!");
+    }
+
+    return lval_dbl(acc);
 }
 
-int main(int argc, char** argv) {
+// Bigint value of a Number lval, or the numerator of a Rational. Narrow
+// Numbers are viewed through limb, so the result must not be freed.
+static bigint lval_big_val(lval* v, uint64_t* limb) {
+    int type = lval_type(v);
+    if (type == LVAL_BIG || type == LVAL_RAT) { return v->big; }
+    return bigint_view_i64(lval_num_val(v), limb);
+}
 
-    // syntax parsers
-    mpc_parser_t* Number = mpc_new("number");
-    mpc_parser_t* Symbol = mpc_new("symbol");
-    mpc_parser_t* Sexpr  = mpc_new("sexpr");
-    mpc_parser_t* Expr   = mpc_new("expr");
-    mpc_parser_t* MyCLC  = mpc_new("myclc");
-
-    // MyCLC language definition
-    mpca_lang(MPCA_LANG_DEFAULT,
-    "                                            \
-        number : /-?[0-9]+/ ;                    \
-        symbol : '+' | '-' | '*' | '/' | '%' ;   \
-        sexpr  : '(' <expr>* ')' ;               \
-        expr   : <number> | <symbol> | <sexpr> ; \
-        myclc  : /^/ <expr>* /$/ ;               \
-    ",
-    Number, Symbol, Sexpr, Expr, MyCLC);
-
-    puts("MyCLC -- My Command-line Lisp Calculator\nDeveloped by Noah Altunian (github.com/naltun/)\n");
-    puts("Press ctrl+C to Exit\n");
+// Value of any number lval as a multi-precision Float, rounded to the
+// working precision. Returns 0 if it is out of range.
+static int lval_mpf_val(lval* v, bigfloat* out) {
+    uint64_t limb;
+    bigint x;
 
-    while (1) {
+    switch (lval_type(v))
+    {
+        case LVAL_MPF:
+            // The mantissa is rounded on its own, then scaled exactly
+            if (!bigfloat_from_big(&v->mpf.m, out)) { return 0; }
+            if (out->m.len > 0) { out->e += v->mpf.e; }
+            return 1;
 
-        // Output prompt and retrieve user input
-        char* input = readline(">> ");
-        
-        // if input is 'exit' or 'quit', then exit with a status of 0
-        if (strcmp(input, "exit") == 0 || strcmp(input, "quit") == 0) { exit(0); }
+        case LVAL_DBL:
+            return bigfloat_from_double(v->dbl, out);
 
-        // add user input to input history
-        add_history(input);
+        case LVAL_RAT:
+            return bigfloat_from_rat(&v->big, &v->den, out);
 
-        // Parse user input
-        mpc_result_t r;
-        if (mpc_parse("<stdin>", input, MyCLC, &r)) {
-            lval* x = lval_eval(lval_read(r.output));
-            lval_println(x);
-            lval_del(x);
-            mpc_ast_delete(r.output);
-        } else {
-            // If parse is not successful, print and delete Error
-            mpc_err_print(r.error);
-            mpc_err_delete(r.error);
+        case LVAL_DEC:
+        {
+            bigint num = bigint_from_i128(v->dec);
+            bigint den = bigint_from_i128(dec_from_i64(1));
+            int ok = bigfloat_from_rat(&num, &den, out);
+            bigint_free(&num);
+            bigint_free(&den);
+            return ok;
         }
 
-        free(input);
+        default:
+            x = lval_big_val(v, &limb);
+            return bigfloat_from_big(&x, out);
     }
+}
 
-    // Undefine and delete parsers
-    mpc_cleanup(5, Number, Symbol, Sexpr, Expr, MyCLC);
+// lval_fold once any argument is a multi-precision Float: everything is
+// rounded to the working precision and each step is correctly rounded
+static lval* lval_fold_mpf(int op, lval** args, int n) {
+    if (op != SYM_ADD && op != SYM_SUB && op != SYM_MUL && op != SYM_DIV && op != SYM_MOD) {
+        return lval_err("Unknown operator!");
+    }
+
+    bigfloat acc, y, r;
+    if (!lval_mpf_val(args[0], &acc)) { return lval_err("Float out of range!"); }
+    if (op == SYM_SUB && n == 1) {
+        r = bigfloat_neg(&acc);
+        bigfloat_free(&acc);
+        acc = r;
+    }
+
+    for (int i = 1; i < n; i++) {
+        if (!lval_mpf_val(args[i], &y)) {
+            bigfloat_free(&acc);
+            return lval_err("Float out of range!");
+        }
+
+        int ok = 1;
+        switch (op)
+        {
+            case SYM_ADD: r = bigfloat_add(&acc, &y); break;
+            case SYM_SUB: r = bigfloat_sub(&acc, &y); break;
+            case SYM_MUL: ok = bigfloat_mul(&acc, &y, &r); break;
+
+            default:
+                if (y.m.len == 0) {
+                    bigfloat_free(&acc);
+                    bigfloat_free(&y);
+                    return lval_err("Cannot divide by zero!");
+                }
+                ok = op == SYM_DIV ? bigfloat_div(&acc, &y, &r) : bigfloat_mod(&acc, &y, &r);
+                break;
+        }
+        bigfloat_free(&acc);
+        bigfloat_free(&y);
+        if (!ok) { return lval_err("Float out of range!"); }
+        acc = r;
+    }
+
+    return lval_mpf(acc);
+}
+
+// Value of any exact number lval as a Decimal, rounded to the scale.
+// Returns 0 if it is out of range.
+static int lval_dec_val(lval* v, __int128* out) {
+    switch (lval_type(v))
+    {
+        case LVAL_DEC: *out = v->dec; return 1;
+        case LVAL_BIG: return dec_from_big(&v->big, out);
+        case LVAL_RAT: return dec_from_rat(&v->big, &v->den, out);
+        default:       *out = dec_from_i64(lval_num_val(v)); return 1;
+    }
+}
+
+// lval_fold once a Decimal is involved: the other exact numbers are brought
+// to the decimal scale, and results stay there
+static lval* lval_fold_dec(int op, lval** args, int n) {
+    if (op != SYM_ADD && op != SYM_SUB && op != SYM_MUL && op != SYM_DIV && op != SYM_MOD) {
+        return lval_err("Unknown operator!");
+    }
+
+    __int128 acc, y;
+    int ok = lval_dec_val(args[0], &acc);
+    if (ok && op == SYM_SUB && n == 1) { ok = !__builtin_sub_overflow((__int128)0, acc, &acc); }
+
+    for (int i = 1; ok && i < n; i++)
+    {
+        ok = lval_dec_val(args[i], &y);
+        if (!ok) { break; }
+
+        switch (op)
+        {
+            case SYM_ADD: ok = !__builtin_add_overflow(acc, y, &acc); break;
+            case SYM_SUB: ok = !__builtin_sub_overflow(acc, y, &acc); break;
+            case SYM_MUL: ok = dec_mul(acc, y, &acc); break;
+
+            // Both sides share the scale, so the remainder is exact
+            case SYM_MOD:
+                if (y == 0) { return lval_err("Cannot divide by zero!"); }
+                acc = y == -1 ? 0 : acc % y;
+                break;
+
+            default:
+                if (y == 0) { return lval_err("Cannot divide by zero!"); }
+                ok = dec_div(acc, y, &acc);
+                break;
+        }
+    }
+
+    return ok ? lval_dec(acc) : lval_err("Decimal overflow!");
+}
+
+// Numerator and denominator of a Number or Rational lval, as views; limb
+// backs the numerator of a narrow Number
+static void lval_rat_val(lval* v, uint64_t* limb, bigint* num, bigint* den) {
+    static uint64_t one = 1;
+
+    *num = lval_big_val(v, limb);
+    if (lval_type(v) == LVAL_RAT) {
+        *den = v->den;
+    } else {
+        *den = bigint_view_i64(1, &one);
+    }
+}
+
+// lval_fold once a Rational is involved or a division comes out inexact.
+// The running value is brought to lowest terms after every step.
+static lval* lval_fold_rat(int op, lval** args, int n) {
+    if (op != SYM_ADD && op != SYM_SUB && op != SYM_MUL && op != SYM_DIV && op != SYM_MOD) {
+        return lval_err("Unknown operator!");
+    }
+
+    uint64_t limb;
+    bigint xn, xd;
+    lval_rat_val(args[0], &limb, &xn, &xd);
+    lval* acc = lval_rat(op == SYM_SUB && n == 1 ? bigint_neg(&xn) : bigint_copy(&xn), bigint_copy(&xd));
+
+    for (int i = 1; i < n; i++)
+    {
+        bigint an, ad, yn, yd, num, den, t, u, q;
+        lval_rat_val(acc, &limb, &an, &ad);
+        uint64_t ylimb;
+        lval_rat_val(args[i], &ylimb, &yn, &yd);
+
+        switch (op)
+        {
+            case SYM_ADD:
+            case SYM_SUB:
+                t   = bigint_mul(&an, &yd);
+                u   = bigint_mul(&yn, &ad);
+                num = op == SYM_ADD ? bigint_add(&t, &u) : bigint_sub(&t, &u);
+                den = bigint_mul(&ad, &yd);
+                bigint_free(&t);
+                bigint_free(&u);
+                break;
+
+            case SYM_MUL:
+                num = bigint_mul(&an, &yn);
+                den = bigint_mul(&ad, &yd);
+                break;
+
+            // a - trunc(a / y) y, over the common denominator
+            case SYM_MOD:
+                if (yn.len == 0) {
+                    lval_del(acc);
+                    return lval_err("Cannot divide by zero!");
+                }
+                t   = bigint_mul(&an, &yd);
+                u   = bigint_mul(&yn, &ad);
+                q   = bigint_div(&t, &u, &num);
+                den = bigint_mul(&ad, &yd);
+                bigint_free(&t);
+                bigint_free(&u);
+                bigint_free(&q);
+                break;
+
+            default:
+                if (yn.len == 0) {
+                    lval_del(acc);
+                    return lval_err("Cannot divide by zero!");
+                }
+                num = bigint_mul(&an, &yd);
+                den = bigint_mul(&ad, &yn);
+                break;
+        }
+        lval_del(acc);
+        acc = lval_rat(num, den);
+    }
+
+    return acc;
+}
+
+// lval_fold once an argument or the result is too wide for an int64
+static lval* lval_fold_big(int op, lval** args, int n) {
+    if (op != SYM_ADD && op != SYM_SUB && op != SYM_MUL && op != SYM_DIV && op != SYM_MOD) {
+        return lval_err("Unknown operator!");
+    }
+
+    uint64_t limb;
+    bigint x = lval_big_val(args[0], &limb);
+    bigint acc = op == SYM_SUB && n == 1 ? bigint_neg(&x) : bigint_copy(&x);
+
+    for (int i = 1; i < n; i++)
+    {
+        bigint y = lval_big_val(args[i], &limb);
+        bigint r, rem;
+        switch (op)
+        {
+            case SYM_ADD: r = bigint_add(&acc, &y); break;
+            case SYM_SUB: r = bigint_sub(&acc, &y); break;
+            case SYM_MUL: r = bigint_mul(&acc, &y); break;
+
+            case SYM_MOD:
+                if (y.len == 0) {
+                    bigint_free(&acc);
+                    return lval_err("Cannot divide by zero!");
+                }
+                rem = bigint_div(&acc, &y, &r);
+                bigint_free(&rem);
+                break;
+
+            default:
+                if (y.len == 0) {
+                    bigint_free(&acc);
+                    return lval_err("Cannot divide by zero!");
+                }
+                r = bigint_div(&acc, &y, &rem);
+                if (rem.len != 0) {
+                    bigint_free(&rem);
+                    bigint_free(&r);
+                    bigint_free(&acc);
+                    return lval_fold_rat(op, args, n);
+                }
+                bigint_free(&rem);
+                break;
+        }
+        bigint_free(&acc);
+        acc = r;
+    }
+
+    return lval_big(acc);
+}
+
+// Largest power lval_pow will build, in bits: about 630,000 digits, which
+// still prints in a few seconds
+#define POW_MAX_BITS ((uint64_t)1 << 21)
+
+// Whether x^n stays within POW_MAX_BITS
+static int lval_pow_fits(const bigint* x, uint64_t n) {
+    uint64_t bits = bigint_bits(x);
+    return bits <= 1 || (!__builtin_mul_overflow(bits - 1, n, &bits) && bits <= POW_MAX_BITS);
+}
+
+// x^n for an integer or Rational x and a non-negative integer n, by
+// squaring. Integers overflow into bignums.
+static lval* lval_pow_exact(lval* x, uint64_t n) {
+    uint64_t limb;
+    bigint b, num, den;
+
+    switch (lval_type(x))
+    {
+        case LVAL_NUM:
+        {
+            int64_t acc = 1, sq = lval_num_val(x);
+            for (uint64_t k = n; ; ) {
+                if ((k & 1) && __builtin_mul_overflow(acc, sq, &acc)) { break; }
+                if ((k >>= 1) == 0) { return lval_num(acc); }
+                if (__builtin_mul_overflow(sq, sq, &sq)) { break; }
+            }
+        }
+        // Overflowed: start over on bignums
+        // fall through
+
+        case LVAL_BIG:
+            b = lval_big_val(x, &limb);
+            if (!lval_pow_fits(&b, n)) { return lval_err("Exponent too large!"); }
+            return lval_big(bigint_pow(&b, n));
+
+        default:
+            if (!lval_pow_fits(&x->big, n) || !lval_pow_fits(&x->den, n)) {
+                return lval_err("Exponent too large!");
+            }
+            num = bigint_pow(&x->big, n);
+            den = bigint_pow(&x->den, n);
+            return lval_rat(num, den);
+    }
+}
+
+// x^y once either is a multi-precision Float. Integer powers are rounded at
+// the working precision; there is no multi-precision exp or log, and a power
+// computed in doubles would silently lose the precision asked for, so any
+// other exponent is an error.
+static lval* lval_pow_mpf(lval* x, lval* y) {
+    uint64_t limb;
+    bigint e, owned = { 0 };
+    double d;
+
+    switch (lval_type(y))
+    {
+        case LVAL_NUM:
+        case LVAL_BIG:
+            e = lval_big_val(y, &limb);
+            break;
+
+        case LVAL_MPF:
+            if (y->mpf.e >= 0) {
+                if (y->mpf.e > 64) { return lval_err("Exponent too large!"); }
+                e = owned = bigint_shl(&y->mpf.m, (int)y->mpf.e);
+                break;
+            }
+            return lval_err("Non-integer powers need (precision 53)!");
+
+        case LVAL_DBL:
+            d = y->dbl;
+            if (d != floor(d)) { return lval_err("Non-integer powers need (precision 53)!"); }
+            if (fabs(d) >= 0x1p64) { return lval_err("Exponent too large!"); }
+            e = owned = bigint_from_i128((__int128)d);
+            break;
+
+        case LVAL_DEC:
+            if (y->dec % dec_from_i64(1) != 0) { return lval_err("Non-integer powers need (precision 53)!"); }
+            e = owned = bigint_from_i128(y->dec / dec_from_i64(1));
+            break;
+
+        default:
+            return lval_err("Non-integer powers need (precision 53)!");
+    }
+
+    if (e.len > 1) {
+        bigint_free(&owned);
+        return lval_err("Exponent too large!");
+    }
+    uint64_t n = e.len > 0 ? e.d[0] : 0;
+    int negative = e.neg;
+    bigint_free(&owned);
+
+    bigfloat b, r;
+    if (!lval_mpf_val(x, &b)) { return lval_err("Float out of range!"); }
+    if (negative && b.m.len == 0) {
+        bigfloat_free(&b);
+        return lval_err("Cannot divide by zero!");
+    }
+
+    int ok = bigfloat_pow(&b, n, negative, &r);
+    bigfloat_free(&b);
+    return ok ? lval_mpf(r) : lval_err("Float out of range!");
+}
+
+// x^y. Integer powers of exact numbers are exact, negative ones being the
+// reciprocal; anything else is computed in floating point.
+static lval* lval_pow(lval* x, lval* y) {
+    int ty = lval_type(y);
+    if (lval_type(x) == LVAL_MPF || ty == LVAL_MPF) { return lval_pow_mpf(x, y); }
+    if (lval_type(x) == LVAL_DBL || (ty != LVAL_NUM && ty != LVAL_BIG)) {
+        return lval_dbl(pow(lval_dbl_val(x), lval_dbl_val(y)));
+    }
+
+    // Decimals are raised exactly, as the rational they stand for, and
+    // rounded to the scale once at the end
+    if (lval_type(x) == LVAL_DEC) {
+        lval* q = lval_rat(bigint_from_i128(x->dec), bigint_from_i128(dec_from_i64(1)));
+        lval* r = lval_pow(q, y);
+        lval_del(q);
+        if (lval_type(r) == LVAL_ERR) { return r; }
+
+        __int128 d;
+        int ok = lval_dec_val(r, &d);
+        lval_del(r);
+        return ok ? lval_dec(d) : lval_err("Decimal overflow!");
+    }
+
+    uint64_t limb;
+    bigint e = lval_big_val(y, &limb);
+    uint64_t n = e.len > 0 ? e.d[0] : 0;
+
+    // Past 64 bits only -1, 0 and 1 have a power small enough to build, and
+    // it depends on nothing but the exponent's parity
+    if (e.len > 1) {
+        int64_t v = lval_type(x) == LVAL_NUM ? lval_num_val(x) : 2;
+        if (v < -1 || v > 1) { return lval_err("Exponent too large!"); }
+        n = 2 | (n & 1);
+    }
+
+    lval* p = lval_pow_exact(x, n);
+    if (!e.neg || lval_type(p) == LVAL_ERR) { return p; }
+
+    lval* args[2] = { lval_num(1), p };
+    lval* r = lval_fold(SYM_DIV, args, 2);
+    lval_del(p);
+    return r;
+}
+
+// Folds ^ from the left, like the other operators: (^ 2 3 2) is 64
+static lval* lval_fold_pow(lval** args, int n) {
+    if (n == 1) { return lval_pow(args[0], lval_num(1)); }
+
+    lval* acc = lval_pow(args[0], args[1]);
+    for (int i = 2; i < n && lval_type(acc) != LVAL_ERR; i++) {
+        lval* r = lval_pow(acc, args[i]);
+        lval_del(acc);
+        acc = r;
+    }
+    return acc;
+}
+
+// (powmod b e m) is b^e mod m in [0, |m|), for integers with e >= 0
+static lval* lval_powmod(lval** args, int n) {
+    if (n != 3) { return lval_err("powmod takes three integers!"); }
+    for (int i = 0; i < n; i++) {
+        int type = lval_type(args[i]);
+        if (type != LVAL_NUM && type != LVAL_BIG) { return lval_err("powmod takes three integers!"); }
+    }
+
+    uint64_t limbs[3];
+    bigint b = lval_big_val(args[0], &limbs[0]);
+    bigint e = lval_big_val(args[1], &limbs[1]);
+    bigint m = lval_big_val(args[2], &limbs[2]);
+    if (m.len == 0) { return lval_err("Cannot divide by zero!"); }
+    if (e.neg) { return lval_err("powmod takes a non-negative exponent!"); }
+
+    return lval_big(bigint_powmod(&b, &e, &m));
+}
+
+// Set on a thread while it runs the body of a pmap or preduce. The memo cache
+// is skipped there, and def and precision, which change what other threads
+// are reading, are errors.
+static __thread int in_parallel;
+
+// (precision N) sets the working precision of Float literals and arithmetic
+// to N bits, returning it. At 53 literals are doubles again.
+static lval* lval_precision(lval** args, int n) {
+    if (n != 1 || lval_type(args[0]) != LVAL_NUM ||
+        lval_num_val(args[0]) < BIGFLOAT_PREC_MIN || lval_num_val(args[0]) > BIGFLOAT_PREC_MAX) {
+        return lval_err("precision takes a bit count from 2 to 65536!");
+    }
+    if (in_parallel) { return lval_err("precision cannot be set inside pmap or preduce!"); }
+    bigfloat_prec = (int)lval_num_val(args[0]);
+    return lval_num(bigfloat_prec);
+}
+
+int lval_sign(lval* x) {
+    switch (lval_type(x))
+    {
+        case LVAL_NUM: return (lval_num_val(x) > 0) - (lval_num_val(x) < 0);
+        case LVAL_BIG:
+        case LVAL_RAT: return x->big.len == 0 ? 0 : x->big.neg ? -1 : 1;
+        case LVAL_DEC: return (x->dec > 0) - (x->dec < 0);
+        case LVAL_DBL: return x->dbl != x->dbl ? 2 : (x->dbl > 0) - (x->dbl < 0);
+        case LVAL_MPF: return x->mpf.m.len == 0 ? 0 : x->mpf.m.neg ? -1 : 1;
+        default:       return 2;
+    }
+}
+
+// (< a b ...) and the other comparisons give 1 if every neighbouring pair
+// holds and 0 otherwise. Integers and doubles compare directly; anything
+// else by the sign of its difference, so mixed types promote as they do for
+// '-'. NaN is unordered, so only != holds for it.
+static lval* lval_compare(int op, lval** args, int n) {
+    if (n < 2) { return lval_err("Comparison takes two or more numbers!"); }
+    for (int i = 0; i < n; i++) {
+        int type = lval_type(args[i]);
+        if (type == LVAL_VEC || type == LVAL_MAT) { return lval_err("Cannot compare vectors or matrices!"); }
+    }
+
+    for (int i = 0; i + 1 < n; i++) {
+        int tx = lval_type(args[i]), ty = lval_type(args[i + 1]);
+        int s;
+        if (tx == LVAL_NUM && ty == LVAL_NUM) {
+            long x = lval_num_val(args[i]), y = lval_num_val(args[i + 1]);
+            s = (x > y) - (x < y);
+        } else if ((tx == LVAL_NUM || tx == LVAL_DBL) && (ty == LVAL_NUM || ty == LVAL_DBL)) {
+            double x = tx == LVAL_DBL ? args[i]->dbl : (double)lval_num_val(args[i]);
+            double y = ty == LVAL_DBL ? args[i + 1]->dbl : (double)lval_num_val(args[i + 1]);
+            s = x != x || y != y ? 2 : (x > y) - (x < y);
+        } else {
+            lval* d = lval_fold(SYM_SUB, args + i, 2);
+            if (lval_type(d) == LVAL_ERR) { return d; }
+            s = lval_sign(d);
+            lval_del(d);
+        }
+
+        int holds;
+        switch (op)
+        {
+            case SYM_LT: holds = s == -1; break;
+            case SYM_GT: holds = s == 1; break;
+            case SYM_LE: holds = s == -1 || s == 0; break;
+            case SYM_GE: holds = s == 1 || s == 0; break;
+            case SYM_EQ: holds = s == 0; break;
+            default:     holds = s != 0; break;
+        }
+        if (!holds) { return lval_num(0); }
+    }
+    return lval_num(1);
+}
+
+// Whether f can be applied to values: a Function, or a builtin operator
+// rather than a special form
+static int lval_is_fn(lval* f) {
+    return lval_type(f) == LVAL_FUN || (lval_type(f) == LVAL_SYM && f->sym < SYM_DEF);
+}
+
+// f applied to args[0..n), taking over the arguments. Builtin operators go
+// straight to lval_fold; Functions are called through the evaluator.
+static lval* lval_apply(lval* f, lval** args, int n) {
+    if (lval_type(f) == LVAL_SYM) {
+        lval* r = lval_fold(f->sym, args, n);
+        for (int i = 0; i < n; i++) { lval_del(args[i]); }
+        return r;
+    }
+
+    lval* e = lval_sexpr();
+    lval_add(e, lval_copy(f));
+    for (int i = 0; i < n; i++) { lval_add(e, args[i]); }
+    return lval_eval(e);
+}
+
+static lval* lval_seq(lseq s) {
+    lval* v = lval_sexpr();
+    v->type = LVAL_SEQ;
+    v->seq  = s;
+    return v;
+}
+
+// (range stop), (range start stop) and (range start stop step): the integers
+// from start, or 0, up to but not including stop. Nothing is made until the
+// Sequence is consumed.
+static lval* lval_range(lval** args, int n) {
+    int64_t r[3] = { 0, 0, 1 };
+    if (n < 1 || n > 3) { return lval_err("range takes integers!"); }
+    for (int i = 0; i < n; i++) {
+        if (lval_type(args[i]) != LVAL_NUM) { return lval_err("range takes integers!"); }
+        r[n == 1 ? 1 : i] = lval_num_val(args[i]);
+    }
+    int64_t start = r[0], stop = r[1], step = r[2];
+    if (step == 0) { return lval_err("range takes a non-zero step!"); }
+
+    // Differences are taken as unsigned, where they always fit
+    uint64_t count = 0;
+    if (step > 0 && start < stop) { count = ((uint64_t)stop - (uint64_t)start - 1) / (uint64_t)step + 1; }
+    if (step < 0 && start > stop) { count = ((uint64_t)start - (uint64_t)stop - 1) / (0 - (uint64_t)step) + 1; }
+    return lval_seq((lseq){ LSEQ_RANGE, start, stop, step, count });
+}
+
+// (iterate f x n): the first n of x, (f x), (f (f x)) ... for a Function or
+// builtin operator f
+static lval* lval_iterate(lval** args, int n) {
+    if (n != 3 || !lval_is_fn(args[0]) || lval_type(args[2]) != LVAL_NUM || lval_num_val(args[2]) < 0) {
+        return lval_err("iterate takes a function, a start and a count!");
+    }
+    lval* s = lval_seq((lseq){ LSEQ_ITERATE, 0, 0, 0, (uint64_t)lval_num_val(args[2]) });
+    lval_add(s, lval_copy(args[0]));
+    lval_add(s, lval_copy(args[1]));
+    return s;
+}
+
+// Whether f adds, subtracts or multiplies its one argument and an integer,
+// as in (\ (x) (* 2 x)): the operator, or 0 if not, with the integer in *k
+// and whether the argument is the left operand in *x_left
+static int lval_affine(lval* f, int64_t* k, int* x_left) {
+    if (lval_type(f) != LVAL_FUN) { return 0; }
+    lval* formals = f->cell[LVAL_FUN_FORMALS];
+    lval* body = f->cell[LVAL_FUN_BODY];
+    if (formals->count != 1 || lval_type(body) != LVAL_SEXPR || body->count != 3) { return 0; }
+
+    // Builtins cannot be rebound, so the operator means what it says
+    lval* op = body->cell[0];
+    lval* a = body->cell[1];
+    lval* b = body->cell[2];
+    int x = formals->cell[0]->sym;
+    *x_left = lval_type(a) == LVAL_SYM && a->sym == x && lval_type(b) == LVAL_NUM;
+    int x_right = lval_type(b) == LVAL_SYM && b->sym == x && lval_type(a) == LVAL_NUM;
+    if (lval_type(op) != LVAL_SYM || !(*x_left || x_right)) { return 0; }
+    if (op->sym != SYM_ADD && op->sym != SYM_SUB && op->sym != SYM_MUL) { return 0; }
+    *k = lval_num_val(*x_left ? b : a);
+    return op->sym;
+}
+
+// (map f r) for a range r and an f lval_affine takes is another range. NULL
+// if f is not of that form or an end of the new range would overflow; the
+// reductions still take such a map in closed form.
+static lval* lval_map_range(lval* f, lval* r) {
+    int64_t k;
+    int x_left;
+    int op = lval_affine(f, &k, &x_left);
+    if (op == 0 || r->seq.kind != LSEQ_RANGE || r->seq.count == 0) { return NULL; }
+
+    // The new ends are the old ones mapped, and the step the difference f
+    // makes to one step
+    int64_t first = r->seq.start, step = r->seq.step;
+    int64_t last = (int64_t)((uint64_t)first + (r->seq.count - 1) * (uint64_t)step);
+    int64_t first2, last2, step2, stop2;
+    int overflow;
+    switch (op)
+    {
+        case SYM_ADD:
+            overflow = __builtin_add_overflow(first, k, &first2) | __builtin_add_overflow(last, k, &last2);
+            step2 = step;
+            break;
+
+        case SYM_SUB:
+            if (x_left) {
+                overflow = __builtin_sub_overflow(first, k, &first2) | __builtin_sub_overflow(last, k, &last2);
+                step2 = step;
+            } else {
+                overflow = __builtin_sub_overflow(k, first, &first2) | __builtin_sub_overflow(k, last, &last2)
+                         | __builtin_sub_overflow((int64_t)0, step, &step2);
+            }
+            break;
+
+        default:
+            if (k == 0) { return NULL; }
+            overflow = __builtin_mul_overflow(first, k, &first2) | __builtin_mul_overflow(last, k, &last2)
+                     | __builtin_mul_overflow(step, k, &step2);
+            break;
+    }
+    if (overflow || __builtin_add_overflow(last2, step2, &stop2)) { return NULL; }
+    return lval_seq((lseq){ LSEQ_RANGE, first2, stop2, step2, r->seq.count });
+}
+
+lval* lval_seq_pack(lval* s, uint64_t max, int* more) {
+    if (lval_type(s) == LVAL_SEQ && s->seq.kind == LSEQ_RANGE) {
+        uint64_t n = s->seq.count < max ? s->seq.count : max;
+        vec v = vec_alloc(VEC_I64, n);
+        for (uint64_t i = 0; i < n; i++) {
+            ((int64_t*)v.data)[i] = (int64_t)((uint64_t)s->seq.start + i * (uint64_t)s->seq.step);
+        }
+        *more = s->seq.count > max;
+        return lval_vec(v);
+    }
+
+    lseq_iter it;
+    lval* x = NULL;
+    lval* list = lval_sexpr();
+    lval_seq_start(&it, s);
+    for (uint64_t n = 0; n < max && (x = lval_seq_next(&it)) != NULL; n++) {
+        lval_add(list, x);
+        if (lval_type(x) == LVAL_ERR) { break; }
+    }
+
+    // One more value tells whether any were left, whatever it is
+    *more = 0;
+    if (x != NULL && lval_type(x) != LVAL_ERR && (x = lval_seq_next(&it)) != NULL) {
+        *more = 1;
+        lval_del(x);
+    }
+    lval_seq_stop(&it);
+    return lval_list_pack(list);
+}
+
+// (map f s) and (filter p s). Over a Sequence both are lazy, so a chain of
+// them is run as a single loop, one value at a time through every stage, by
+// whatever consumes it. Over a Vector the values are all there already, so
+// they are made at once, and packed as pmap packs its results.
+static lval* lval_map(int op, lval** args, int n) {
+    if (n != 2 || !lval_is_fn(args[0]) || (lval_type(args[1]) != LVAL_SEQ && lval_type(args[1]) != LVAL_VEC)) {
+        char message[64];
+        snprintf(message, sizeof(message), "%s takes a function and a sequence!", intern_name(op));
+        return lval_err(message);
+    }
+    if (op == SYM_MAP && lval_type(args[1]) == LVAL_SEQ) {
+        lval* r = lval_map_range(args[0], args[1]);
+        if (r != NULL) { return r; }
+    }
+
+    lval* s = lval_seq((lseq){ op == SYM_MAP ? LSEQ_MAP : LSEQ_FILTER, 0, 0, 0, 0 });
+    lval_add(s, lval_copy(args[0]));
+    lval_add(s, lval_copy(args[1]));
+    if (lval_type(args[1]) == LVAL_SEQ) { return s; }
+
+    int more;
+    lval* v = lval_seq_pack(s, UINT64_MAX, &more);
+    lval_del(s);
+    return v;
+}
+
+// The map and filter stages are gathered, outermost first, down to the
+// Sequence or Vector at the bottom they draw from
+void lval_seq_start(lseq_iter* it, lval* s) {
+    it->depth = 0;
+    for (lval* t = s; lval_type(t) == LVAL_SEQ && t->seq.kind >= LSEQ_MAP; t = t->cell[1]) { it->depth++; }
+    it->stages = it->depth > 0 ? arena_alloc(sizeof(lval*) * it->depth) : NULL;
+    for (int d = 0; d < it->depth; d++, s = s->cell[1]) { it->stages[d] = s; }
+    it->src = s;
+    it->done = 0;
+    it->i = 0;
+    it->x = NULL;
+}
+
+// Next value of the Sequence or Vector at the bottom, or NULL
+static lval* lval_seq_pull(lseq_iter* it) {
+    lval* s = it->src;
+    if (lval_type(s) == LVAL_VEC) {
+        if (it->i == s->vec.len) { return NULL; }
+        size_t i = it->i++;
+        if (s->vec.kind == VEC_I64) { return lval_num(((const int64_t*)s->vec.data)[i]); }
+        return lval_dbl(((const double*)s->vec.data)[i]);
+    }
+
+    const lseq* q = &s->seq;
+    if (it->i == q->count) { return NULL; }
+    if (q->kind == LSEQ_RANGE) {
+        return lval_num((long)((uint64_t)q->start + it->i++ * (uint64_t)q->step));
+    }
+
+    // The latest value is kept to make the next one from
+    if (it->i++ == 0) {
+        it->x = lval_copy(s->cell[1]);
+    } else {
+        lval* x = it->x;
+        it->x = lval_apply(s->cell[0], &x, 1);
+    }
+    return lval_copy(it->x);
+}
+
+lval* lval_seq_next(lseq_iter* it) {
+    while (!it->done) {
+        lval* x = lval_seq_pull(it);
+        if (x == NULL) { return NULL; }
+
+        // Innermost stage first; a value a filter drops is never seen by the
+        // stages above it
+        int d = it->depth - 1;
+        for (; d >= 0 && lval_type(x) != LVAL_ERR; d--) {
+            lval* stage = it->stages[d];
+            if (stage->seq.kind == LSEQ_MAP) {
+                x = lval_apply(stage->cell[0], &x, 1);
+                continue;
+            }
+
+            lval* arg = lval_copy(x);
+            lval* keep = lval_apply(stage->cell[0], &arg, 1);
+            if (lval_type(keep) != LVAL_ERR && lval_type(keep) > LVAL_MPF) {
+                lval_del(keep);
+                keep = lval_err("filter takes a function giving numbers!");
+            }
+            if (lval_type(keep) == LVAL_ERR) {
+                lval_del(x);
+                x = keep;
+                break;
+            }
+            int pass = lval_sign(keep) != 0;
+            lval_del(keep);
+            if (!pass) { break; }
+        }
+
+        if (lval_type(x) == LVAL_ERR) {
+            it->done = 1;
+            return x;
+        }
+        if (d < 0) { return x; }
+        lval_del(x);
+    }
+    return NULL;
+}
+
+void lval_seq_stop(lseq_iter* it) {
+    if (it->x != NULL) { lval_del(it->x); }
+    if (it->stages != NULL) { arena_free(it->stages, sizeof(lval*) * it->depth); }
+    it->x = NULL;
+    it->stages = NULL;
+}
+
+// lval_reduce_seq for a range, without visiting its elements: the sum of an
+// arithmetic series is n (first + last) / 2, its least and greatest elements
+// are its ends, and a product through zero is zero. Other products are
+// multiplied out, in int64s until they overflow.
+static lval* lval_reduce_range(int op, const lseq* q) {
+    int64_t last = (int64_t)((uint64_t)q->start + (q->count - 1) * (uint64_t)q->step);
+    int64_t lo = q->step > 0 ? q->start : last, hi = q->step > 0 ? last : q->start;
+    uint64_t x = (uint64_t)q->start, i = 0;
+
+    switch (op)
+    {
+        case SYM_MIN: return lval_num(lo);
+        case SYM_MAX: return lval_num(hi);
+
+        // One of the factors is even; halving it first leaves at most 62
+        // bits by 65, which __int128 holds
+        case SYM_SUM:
+        {
+            __int128 n = q->count, ends = (__int128)lo + hi;
+            if (n % 2 == 0) { n /= 2; } else { ends /= 2; }
+            if (n < ((__int128)1 << 62)) {
+                __int128 wide = n * ends;
+                if (wide < INT64_MIN || wide > INT64_MAX) { return lval_big(bigint_from_i128(wide)); }
+                return lval_num((int64_t)wide);
+            }
+            bigint a = bigint_from_i128(n), b = bigint_from_i128(ends);
+            bigint p = bigint_mul(&a, &b);
+            bigint_free(&a);
+            bigint_free(&b);
+            return lval_big(p);
+        }
+
+        default:
+        {
+            if (lo <= 0 && hi >= 0 && (__int128)q->start % q->step == 0) { return lval_num(0); }
+            int64_t acc = 1, t;
+            for (; i < q->count && !__builtin_mul_overflow(acc, (int64_t)x, &t); i++, x += (uint64_t)q->step) {
+                acc = t;
+            }
+            if (i == q->count) { return lval_num(acc); }
+
+            // Finished in bigints from the element that overflowed
+            bigint p = bigint_from_i128(acc);
+            for (; i < q->count; i++, x += (uint64_t)q->step) {
+                uint64_t limb;
+                bigint y = bigint_view_i64((int64_t)x, &limb);
+                bigint t = bigint_mul(&p, &y);
+                bigint_free(&p);
+                p = t;
+            }
+            return lval_big(p);
+        }
+    }
+}
+
+// lval_reduce_range for a range mapped through an f lval_affine takes, which
+// lval_map_range leaves as a map when the new range would overflow. A sum is
+// the range's sum scaled or shifted by k, and the least and greatest values
+// are f of the range's ends, in bignums where they need them. NULL for other
+// Sequences and for products.
+static lval* lval_reduce_map_range(int op, lval* s) {
+    int64_t k;
+    int x_left;
+    if (s->seq.kind != LSEQ_MAP || lval_type(s->cell[1]) != LVAL_SEQ || op == SYM_PROD) { return NULL; }
+    const lseq* q = &s->cell[1]->seq;
+    int f = lval_affine(s->cell[0], &k, &x_left);
+    if (f == 0 || q->kind != LSEQ_RANGE || q->count == 0) { return NULL; }
+
+    if (op == SYM_MIN || op == SYM_MAX) {
+        lval* first = lval_num(q->start);
+        lval* last = lval_num((int64_t)((uint64_t)q->start + (q->count - 1) * (uint64_t)q->step));
+        lval* pair[2] = { lval_apply(s->cell[0], &last, 1), lval_apply(s->cell[0], &first, 1) };
+        lval* better = lval_compare(op == SYM_MIN ? SYM_LT : SYM_GT, pair, 2);
+        lval* r = lval_type(better) == LVAL_ERR ? better : lval_copy(pair[lval_num_val(better) ? 0 : 1]);
+        if (r != better) { lval_del(better); }
+        lval_del(pair[0]);
+        lval_del(pair[1]);
+        return r;
+    }
+
+    // k x sums to k S, and x + k, x - k and k - x to S + n k, S - n k and
+    // n k - S, for S the sum of the n values in the range
+    lval* sum = lval_reduce_range(SYM_SUM, q);
+    lval* scale = lval_num(k);
+    if (f != SYM_MUL) {
+        lval* n = q->count > INT64_MAX ? lval_big(bigint_from_i128(q->count)) : lval_num((int64_t)q->count);
+        lval* pair[2] = { n, scale };
+        lval* nk = lval_fold(SYM_MUL, pair, 2);
+        lval_del(n);
+        lval_del(scale);
+        scale = nk;
+    }
+    lval* pair[2] = { x_left ? sum : scale, x_left ? scale : sum };
+    lval* r = lval_fold(f, pair, 2);
+    lval_del(sum);
+    lval_del(scale);
+    return r;
+}
+
+// The closed form of a sum, product, least or greatest value of s, or NULL
+// if it has none and must be consumed a value at a time
+static lval* lval_reduce_closed(int op, lval* s) {
+    if (lval_type(s) != LVAL_SEQ) { return NULL; }
+    if (s->seq.kind == LSEQ_RANGE) { return s->seq.count > 0 ? lval_reduce_range(op, &s->seq) : NULL; }
+    return lval_reduce_map_range(op, s);
+}
+
+// (sum s), (prod s), (min s) and (max s) of a Sequence, consumed a value at
+// a time, so the Sequence is never held in memory. Generated values are added
+// and multiplied by lval_fold, so they may be of any type it takes.
+static lval* lval_reduce_seq(int op, lval* s) {
+    lval* closed = lval_reduce_closed(op, s);
+    if (closed != NULL) { return closed; }
+
+    lseq_iter it;
+    lval_seq_start(&it, s);
+    lval* acc = lval_seq_next(&it);
+    if (acc == NULL) {
+        lval_seq_stop(&it);
+        if (op == SYM_SUM) { return lval_num(0); }
+        if (op == SYM_PROD) { return lval_num(1); }
+        char message[64];
+        snprintf(message, sizeof(message), "%s of an empty sequence!", intern_name(op));
+        return lval_err(message);
+    }
+
+    lval* x;
+    while (lval_type(acc) != LVAL_ERR && (x = lval_seq_next(&it)) != NULL) {
+        if (lval_type(x) == LVAL_ERR) {
+            lval_del(acc);
+            acc = x;
+        } else if (op == SYM_SUM || op == SYM_PROD) {
+            lval* pair[2] = { acc, x };
+            lval* r = lval_fold(op == SYM_SUM ? SYM_ADD : SYM_MUL, pair, 2);
+            lval_del(acc);
+            lval_del(x);
+            acc = r;
+        } else {
+            // The first of equal values is kept
+            lval* pair[2] = { x, acc };
+            lval* better = lval_compare(op == SYM_MIN ? SYM_LT : SYM_GT, pair, 2);
+            if (lval_type(better) == LVAL_ERR) {
+                lval_del(acc);
+                lval_del(x);
+                acc = better;
+            } else if (lval_num_val(better)) {
+                lval_del(acc);
+                acc = x;
+            } else {
+                lval_del(x);
+            }
+        }
+    }
+    lval_seq_stop(&it);
+    return acc;
+}
+
+// (reduce f s) folds f over a Sequence or Vector from its first value, and
+// (fold f x s) from x, one value at a time as the Sequence makes them. A sum
+// or product with a closed form goes to lval_reduce_closed instead.
+static lval* lval_reduce(int op, lval** args, int n) {
+    int folds = op == SYM_FOLD;
+    lval* f = args[0];
+    lval* s = n == 2 + folds ? args[1 + folds] : NULL;
+    if (s == NULL || !lval_is_fn(f) || (lval_type(s) != LVAL_SEQ && lval_type(s) != LVAL_VEC)) {
+        return lval_err(folds ? "fold takes a function, a start and a sequence!"
+                              : "reduce takes a function and a sequence!");
+    }
+
+    lval* r = NULL;
+    if (lval_type(f) == LVAL_SYM && (f->sym == SYM_ADD || f->sym == SYM_MUL)) {
+        r = lval_reduce_closed(f->sym == SYM_ADD ? SYM_SUM : SYM_PROD, s);
+    }
+    if (r != NULL) {
+        if (!folds) { return r; }
+        lval* pair[2] = { args[1], r };
+        lval* total = lval_fold(f->sym, pair, 2);
+        lval_del(r);
+        return total;
+    }
+
+    lseq_iter it;
+    lval_seq_start(&it, s);
+    lval* acc = folds ? lval_copy(args[1]) : lval_seq_next(&it);
+    if (acc == NULL) {
+        lval_seq_stop(&it);
+        return lval_err("reduce of an empty sequence!");
+    }
+
+    lval* x;
+    while (lval_type(acc) != LVAL_ERR && (x = lval_seq_next(&it)) != NULL) {
+        if (lval_type(x) == LVAL_ERR) {
+            lval_del(acc);
+            acc = x;
+            continue;
+        }
+        lval* pair[2] = { acc, x };
+        acc = lval_apply(f, pair, 2);
+    }
+    lval_seq_stop(&it);
+    return acc;
+}
+
+// Most values pmap and preduce take, as many as a 2 GiB Vector holds
+#define PARALLEL_MAX ((size_t)1 << 28)
+
+// Arenas for the pool's other threads to evaluate in. Like the main one,
+// they are only reset between lines, so values made on any thread stay good
+// for the rest of the line wherever they end up.
+static arena worker_arenas[POOL_MAX];
+
+static void lval_parallel_reset(void) {
+    arena* prev = arena_use(&worker_arenas[0]);
+    for (int w = 1; w < POOL_MAX; w++) {
+        arena_use(&worker_arenas[w]);
+        arena_reset();
+    }
+    arena_use(prev);
+}
+
+// The values of a Sequence or Vector by index, from any thread. Ranges and
+// Vectors are read in place; other Sequences are drawn out in order first.
+typedef struct { lval* src; lval** items; size_t n; size_t capacity; } lval_items;
+
+// NULL, or an error from drawing out the Sequence
+static lval* lval_items_of(lval_items* it, lval* s) {
+    it->src = s;
+    it->items = NULL;
+    it->capacity = 0;
+    if (lval_type(s) == LVAL_VEC || s->seq.kind == LSEQ_RANGE) {
+        it->n = lval_type(s) == LVAL_VEC ? s->vec.len : s->seq.count;
+        return NULL;
+    }
+
+    lseq_iter iter;
+    lval* x;
+    lval_seq_start(&iter, s);
+    for (it->n = 0; (x = lval_seq_next(&iter)) != NULL; it->n++) {
+        if (lval_type(x) == LVAL_ERR || it->n == PARALLEL_MAX) { break; }
+        if (it->n == it->capacity) {
+            size_t grown = it->capacity ? it->capacity * 2 : 16;
+            it->items = arena_realloc(it->items, sizeof(lval*) * it->capacity, sizeof(lval*) * grown);
+            it->capacity = grown;
+        }
+        it->items[it->n] = x;
+    }
+    lval_seq_stop(&iter);
+    if (x == NULL) { return NULL; }
+
+    for (size_t i = 0; i < it->n; i++) { lval_del(it->items[i]); }
+    arena_free(it->items, sizeof(lval*) * it->capacity);
+    it->items = NULL;
+    if (lval_type(x) == LVAL_ERR) { return x; }
+    lval_del(x);
+    return lval_err("Sequence too long to run in parallel!");
+}
+
+// Value i, which the caller takes over. Drawn-out values are handed over
+// rather than copied, so each is taken once.
+static lval* lval_item(lval_items* it, size_t i) {
+    if (it->items != NULL) { return it->items[i]; }
+    lval* s = it->src;
+    if (lval_type(s) == LVAL_SEQ) { return lval_num((long)((uint64_t)s->seq.start + i * (uint64_t)s->seq.step)); }
+    if (s->vec.kind == VEC_I64) { return lval_num(((const int64_t*)s->vec.data)[i]); }
+    return lval_dbl(((const double*)s->vec.data)[i]);
+}
+
+// Checks the arguments of pmap and preduce, setting up their items; NULL if
+// they are good
+static lval* lval_parallel_args(int op, lval** args, int n, lval_items* items) {
+    if (n != 2 || !lval_is_fn(args[0]) || (lval_type(args[1]) != LVAL_SEQ && lval_type(args[1]) != LVAL_VEC)) {
+        char message[64];
+        snprintf(message, sizeof(message), "%s takes a function and a sequence!", intern_name(op));
+        return lval_err(message);
+    }
+    lval* err = lval_items_of(items, args[1]);
+    if (err == NULL && items->n > PARALLEL_MAX) { err = lval_err("Sequence too long to run in parallel!"); }
+    return err;
+}
+
+// Readies the thread running a pmap or preduce body to evaluate in its own
+// arena, returning the one it was using (NULL for the calling thread, which
+// keeps its own)
+static arena* lval_parallel_enter(int worker, int* was) {
+    *was = in_parallel;
+    in_parallel = 1;
+    return worker > 0 ? arena_use(&worker_arenas[worker]) : NULL;
+}
+
+static void lval_parallel_leave(arena* prev, int was) {
+    in_parallel = was;
+    if (prev != NULL) { arena_use(prev); }
+}
+
+typedef struct { lval* f; lval_items items; lval** out; } pmap_job;
+
+static void lval_pmap_body(void* ctx, size_t lo, size_t hi, int worker) {
+    pmap_job* job = ctx;
+    int was;
+    arena* prev = lval_parallel_enter(worker, &was);
+    for (size_t i = lo; i < hi; i++) {
+        lval* x = lval_item(&job->items, i);
+        job->out[i] = lval_apply(job->f, &x, 1);
+    }
+    lval_parallel_leave(prev, was);
+}
+
+// (pmap f s) applies f to every value of a Sequence or Vector across the
+// pool, giving the results in order: a Vector if they all fit one, and a
+// list otherwise. The first error among them is the result instead.
+static lval* lval_pmap(lval** args, int n) {
+    pmap_job job = { args[0], { 0 }, NULL };
+    lval* err = lval_parallel_args(SYM_PMAP, args, n, &job.items);
+    if (err != NULL) { return err; }
+
+    lval* list = lval_sexpr();
+    if (job.items.n > 0) {
+        job.out = arena_alloc(sizeof(lval*) * job.items.n);
+        pool_for_adaptive(job.items.n, lval_pmap_body, &job);
+    }
+    arena_free(job.items.items, sizeof(lval*) * job.items.capacity);
+    list->cell = job.out;
+    list->count = list->capacity = (int)job.items.n;
+    return lval_list_pack(list);
+}
+
+// Each thread records the result of every range it folds, by where the
+// range starts, in its own list
+typedef struct { size_t lo; lval* acc; } preduce_part;
+typedef struct { preduce_part* parts; int count; int capacity; } preduce_parts;
+typedef struct { lval* f; lval_items items; preduce_parts threads[POOL_MAX]; } preduce_job;
+
+static void lval_preduce_body(void* ctx, size_t lo, size_t hi, int worker) {
+    preduce_job* job = ctx;
+    int was;
+    arena* prev = lval_parallel_enter(worker, &was);
+    lval* acc = lval_item(&job->items, lo);
+    for (size_t i = lo + 1; i < hi; i++) {
+        lval* x = lval_item(&job->items, i);
+        if (lval_type(acc) == LVAL_ERR) {
+            lval_del(x);
+            continue;
+        }
+        lval* pair[2] = { acc, x };
+        acc = lval_apply(job->f, pair, 2);
+    }
+    lval_parallel_leave(prev, was);
+
+    preduce_parts* p = &job->threads[worker];
+    p->parts = stack_reserve(p->parts, p->count, &p->capacity, sizeof(preduce_part));
+    p->parts[p->count++] = (preduce_part){ lo, acc };
+}
+
+static int preduce_part_cmp(const void* a, const void* b) {
+    size_t x = ((const preduce_part*)a)->lo, y = ((const preduce_part*)b)->lo;
+    return (x > y) - (x < y);
+}
+
+// (preduce f s) is (reduce f s) with the values split into ranges folded
+// across the pool, and the results of those folded in order, so f must be
+// associative. A sum or product with a closed form takes it, as for reduce.
+static lval* lval_preduce(lval** args, int n) {
+    if (n == 2 && lval_type(args[0]) == LVAL_SYM && (args[0]->sym == SYM_ADD || args[0]->sym == SYM_MUL)) {
+        lval* r = lval_reduce_closed(args[0]->sym == SYM_ADD ? SYM_SUM : SYM_PROD, args[1]);
+        if (r != NULL) { return r; }
+    }
+
+    preduce_job* job = calloc(1, sizeof(preduce_job));
+    if (job == NULL) { abort(); }
+    job->f = args[0];
+    lval* err = lval_parallel_args(SYM_PREDUCE, args, n, &job->items);
+    if (err == NULL && job->items.n == 0) { err = lval_err("preduce of an empty sequence!"); }
+    if (err != NULL) {
+        free(job);
+        return err;
+    }
+    pool_for_adaptive(job->items.n, lval_preduce_body, job);
+    arena_free(job->items.items, sizeof(lval*) * job->items.capacity);
+
+    // Gathered back into the order of the values
+    size_t count = 0;
+    for (int w = 0; w < POOL_MAX; w++) { count += job->threads[w].count; }
+    preduce_part* parts = malloc(sizeof(preduce_part) * count);
+    if (parts == NULL) { abort(); }
+    count = 0;
+    for (int w = 0; w < POOL_MAX; w++) {
+        preduce_parts* p = &job->threads[w];
+        for (int i = 0; i < p->count; i++) { parts[count++] = p->parts[i]; }
+        free(p->parts);
+    }
+    free(job);
+    qsort(parts, count, sizeof(preduce_part), preduce_part_cmp);
+
+    lval* acc = parts[0].acc;
+    for (size_t i = 1; i < count; i++) {
+        if (lval_type(acc) == LVAL_ERR) {
+            lval_del(parts[i].acc);
+            continue;
+        }
+        if (lval_type(parts[i].acc) == LVAL_ERR) {
+            lval_del(acc);
+            acc = parts[i].acc;
+            continue;
+        }
+        lval* pair[2] = { acc, parts[i].acc };
+        acc = lval_apply(args[0], pair, 2);
+    }
+    free(parts);
+    return acc;
+}
+
+// Folds the n number arguments in args with the builtin op. The arguments
+// are only read; whoever owns them deletes them afterwards
+lval* lval_fold(int op, lval** args, int n) {
+    static __thread int64_t* vals;
+    static __thread int capacity;
+
+    // Sequences are made, and folded, with Functions as well as numbers
+    if (op == SYM_RANGE) { return lval_range(args, n); }
+    if (op == SYM_ITERATE) { return lval_iterate(args, n); }
+    if (op == SYM_MAP || op == SYM_FILTER) { return lval_map(op, args, n); }
+    if (op == SYM_REDUCE || op == SYM_FOLD) { return lval_reduce(op, args, n); }
+    if (op == SYM_PMAP) { return lval_pmap(args, n); }
+    if (op == SYM_PREDUCE) { return lval_preduce(args, n); }
+
+    // Check all arguments are numbers, gathering them into a flat array for
+    // the reduction kernels
+    while (n > capacity) { vals = stack_reserve(vals, capacity, &capacity, sizeof(int64_t)); }
+    int vec = 0, mat = 0, seq = 0, mpf = 0, dbl = 0, big = 0, rat = 0, dec = 0;
+    for (int i = 0; i < n; i++)
+    {
+        int type = lval_type(args[i]);
+        if (type == LVAL_SEQ) { seq = 1; continue; }
+        if (type == LVAL_VEC) { vec = 1; continue; }
+        if (type == LVAL_MAT) { mat = 1; continue; }
+        if (type == LVAL_MPF) { mpf = 1; continue; }
+        if (type == LVAL_DBL) { dbl = 1; continue; }
+        if (type == LVAL_BIG) { big = 1; continue; }
+        if (type == LVAL_RAT) { rat = 1; continue; }
+        if (type == LVAL_DEC) { dec = 1; continue; }
+        if (type != LVAL_NUM)
+        {
+            return lval_err("Cannot operate on a non-number!");
+        }
+        vals[i] = lval_num_val(args[i]);
+    }
+    if (seq) {
+        if (op >= SYM_SUM && op <= SYM_MAX && n == 1) { return lval_reduce_seq(op, args[0]); }
+        return lval_err("Operator does not take sequences!");
+    }
+    if (op >= SYM_LT && op <= SYM_NE) { return lval_compare(op, args, n); }
+    if (op == SYM_MATMUL) { return lval_matmul(args, n); }
+    if (op == SYM_TRANSPOSE) { return lval_transpose(args, n); }
+    if (op >= SYM_SUM && op <= SYM_MAX) { return lval_reduce_vec(op, args, n); }
+    if (vec && mat) { return lval_err("Cannot mix vectors and matrices!"); }
+    if (vec) { return lval_fold_each(op, args, n, LVAL_VEC, lval_vec_apply); }
+    if (mat) { return lval_fold_each(op, args, n, LVAL_MAT, lval_mat_apply); }
+    if (op == SYM_CARET || op == SYM_POW) { return lval_fold_pow(args, n); }
+    if (op == SYM_POWMOD) { return lval_powmod(args, n); }
+    if (op == SYM_PRECISION) { return lval_precision(args, n); }
+    if (mpf) { return lval_fold_mpf(op, args, n); }
+    if (dbl) { return lval_fold_dbl(op, args, n); }
+    if (dec) { return lval_fold_dec(op, args, n); }
+    if (rat) { return lval_fold_rat(op, args, n); }
+    if (big) { return lval_fold_big(op, args, n); }
+
+    if (n == 0) { return lval_err("Operator takes one or more numbers!"); }
+    __int128 wide;
+    int64_t acc = vals[0];
+
+    // Dispatch once on the operator, then run a tight loop for it. Results
+    // that overflow an int64 are redone, or finished, with bigints.
+    switch (op)
+    {
+        case SYM_ADD:
+            wide = reduce_sum_i64(vals, n);
+            if (wide < INT64_MIN || wide > INT64_MAX) { return lval_big(bigint_from_i128(wide)); }
+            acc = (int64_t)wide;
+            break;
+
+        case SYM_SUB:
+            // If there are no arguments then perform unary negation
+            wide = n == 1 ? -(__int128)acc : acc - reduce_sum_i64(vals + 1, n - 1);
+            if (wide < INT64_MIN || wide > INT64_MAX) { return lval_big(bigint_from_i128(wide)); }
+            acc = (int64_t)wide;
+            break;
+
+        case SYM_MUL:
+            if (!reduce_prod_i64(vals, n, &acc)) { return lval_fold_big(op, args, n); }
+            break;
+
+        case SYM_DIV:
+            for (int i = 1; i < n; i++)
+            {
+                if (vals[i] == 0) { return lval_err("Cannot divide by zero!"); }
+                if (acc == INT64_MIN && vals[i] == -1) { return lval_fold_big(op, args, n); }
+                if (acc % vals[i] != 0) { return lval_fold_rat(op, args, n); }
+                acc /= vals[i];
+            }
+            break;
+
+        // Truncated, like C: the remainder takes the sign of the dividend
+        case SYM_MOD:
+            for (int i = 1; i < n; i++)
+            {
+                if (vals[i] == 0) { return lval_err("Cannot divide by zero!"); }
+                acc = vals[i] == -1 ? 0 : acc % vals[i];
+            }
+            break;
+
+        default:
+            return lval_err("Unknown operator!");
+    }
+
+    return lval_num(acc);
+}
+
+// Functions similarly to eval_op function
+// Takes a single lval* which represents a list of all arguments which need
+// operation, and the interned ID of the operator symbol
+lval* builtin_op(lval* a, int op) {
+    lval* x = lval_fold(op, a->cell, a->count);
+    lval_del(a);
+    return x;
+}
+
+// Global bindings made by def
+lenv globals;
+
+// Value bound to sym among the local bindings in env, a list of name and
+// value pairs, or else among the globals; NULL if neither has it
+static lval* lval_env_get(lval* env, int sym) {
+    if (env != NULL) {
+        for (int i = 0; i < env->count; i += 2) {
+            if (env->cell[i]->sym == sym) { return env->cell[i + 1]; }
+        }
+    }
+    return lenv_get(&globals, sym);
+}
+
+void lval_env_put(lval* env, lval* name, lval* x) {
+    for (int i = 0; i < env->count; i += 2) {
+        if (env->cell[i]->sym == name->sym) {
+            lval_del(env->cell[i + 1]);
+            env->cell[i + 1] = x;
+            lval_del(name);
+            return;
+        }
+    }
+    lval_add(env, name);
+    lval_add(env, x);
+}
+
+lval* lval_lookup(lval* x, lval* env) {
+    if (lval_type(x) != LVAL_SYM || x->sym < SYM_BUILTIN_COUNT) { return x; }
+
+    lval* v = lval_env_get(env, x->sym);
+    if (v == NULL) {
+        char message[160];
+        snprintf(message, sizeof(message), "Unbound symbol '%.120s'!", intern_name(x->sym));
+        lval_del(x);
+        return lval_err(message);
+    }
+    lval_del(x);
+    return lval_copy(v);
+}
+
+static lval* lval_err_builtin(int sym) {
+    char message[64];
+    snprintf(message, sizeof(message), "Cannot redefine builtin '%s'!", intern_name(sym));
+    return lval_err(message);
+}
+
+// (def name value ...) binds each name to its value, returning the last one.
+// Nothing is bound unless every pair is good.
+static lval* builtin_def(lval* a) {
+    if (in_parallel) {
+        lval_del(a);
+        return lval_err("def cannot be used inside pmap or preduce!");
+    }
+    if (a->count % 2 != 0) {
+        lval_del(a);
+        return lval_err("def takes pairs of names and values!");
+    }
+    for (int i = 0; i < a->count; i += 2) {
+        lval* name = a->cell[i];
+        if (lval_type(name) != LVAL_SYM) {
+            lval_del(a);
+            return lval_err("def takes pairs of names and values!");
+        }
+        if (name->sym < SYM_BUILTIN_COUNT) {
+            lval* err = lval_err_builtin(name->sym);
+            lval_del(a);
+            return err;
+        }
+    }
+
+    for (int i = 0; i < a->count; i += 2) { lenv_put(&globals, a->cell[i]->sym, a->cell[i + 1]); }
+    return lval_take(a, a->count - 1);
+}
+
+// (\ (name ...) body) makes a Function closing over a copy of the local
+// bindings in env. Globals are looked up when it runs, so functions defined
+// later, itself included, can be called from its body.
+static lval* lval_lambda(lval* v, lval* env) {
+    lval* formals = v->count == 3 ? v->cell[1] : NULL;
+    if (formals == NULL || lval_type(formals) != LVAL_SEXPR) {
+        lval_del(v);
+        return lval_err("lambda takes a list of names and a body!");
+    }
+    for (int i = 0; i < formals->count; i++) {
+        lval* name = formals->cell[i];
+        if (lval_type(name) != LVAL_SYM) {
+            lval_del(v);
+            return lval_err("lambda takes a list of names and a body!");
+        }
+        if (name->sym < SYM_BUILTIN_COUNT) {
+            lval* err = lval_err_builtin(name->sym);
+            lval_del(v);
+            return err;
+        }
+    }
+
+    lval* f = lval_sexpr();
+    f->type = LVAL_FUN;
+    lval_add(f, lval_pop(v, 1));
+    lval_add(f, lval_pop(v, 1));
+    lval_add(f, env != NULL ? lval_copy(env) : lval_sexpr());
+    lval_del(v);
+    return f;
+}
+
+// (if cond then else) with cond evaluated: the branch it picks, still to be
+// evaluated. Any number but zero is true.
+static lval* lval_if(lval* v, lval* env) {
+    if (v->count != 4) {
+        lval_del(v);
+        return lval_err("if takes a condition, a then and an else!");
+    }
+
+    lval* cond = v->cell[1] = lval_lookup(v->cell[1], env);
+    if (lval_type(cond) == LVAL_ERR) { return lval_take(v, 1); }
+    if (lval_type(cond) > LVAL_MPF) {
+        lval_del(v);
+        return lval_err("if takes a number as its condition!");
+    }
+    return lval_take(v, lval_sign(cond) != 0 ? 2 : 3);
+}
+
+// Binds the arguments of a call to the formals of f, over the bindings f
+// closed over, taking over both. Returns the body of f, still to be
+// evaluated, with those bindings in *env; or an error.
+static lval* lval_call(lval* f, lval* args, lval** env) {
+    lval* formals = f->cell[LVAL_FUN_FORMALS];
+    if (formals->count != args->count) {
+        char message[96];
+        snprintf(message, sizeof(message), "Function takes %i arguments, got %i!", formals->count, args->count);
+        lval_del(f);
+        lval_del(args);
+        return lval_err(message);
+    }
+
+    // The names and arguments move into the bindings, the body out of f
+    *env = f->cell[LVAL_FUN_ENV];
+    for (int i = 0; i < args->count; i++) { lval_env_put(*env, formals->cell[i], args->cell[i]); }
+    lval* body = f->cell[LVAL_FUN_BODY];
+    formals->count = args->count = f->count = 0;
+    lval_del(formals);
+    lval_del(args);
+    lval_del(f);
+    return body;
+}
+
+lval* lval_eval_sexpr(lval* v, lval* env, lval** call_env, int line) {
+    // Symbols, apart from the names def is about to bind
+    if (v->count > 0) { v->cell[0] = lval_lookup(v->cell[0], env); }
+    int def = v->count > 0 && lval_type(v->cell[0]) == LVAL_SYM && v->cell[0]->sym == SYM_DEF;
+    for (int i = 1; i < v->count; i++) {
+        if (!def || i % 2 == 0) { v->cell[i] = lval_lookup(v->cell[i], env); }
+    }
+
+    // Errors
+    for (int i = 0; i < v->count; i++) {
+        if (lval_type(v->cell[i]) == LVAL_ERR) { return lval_take(v, i); }
+    }
+
+    // If Expression is empty
+    if (v->count == 0) { return v; }
+
+    // A Function is called with the rest as its arguments
+    if (lval_type(v->cell[0]) == LVAL_FUN && (v->count > 1 || !line)) {
+        lval* f = lval_pop(v, 0);
+        return lval_call(f, v, call_env);
+    }
+
+    // If Expression is single
+    if (v->count < 2) { return lval_take(v, 0); }
+
+    // Checks that the first element is a Symbol
+    lval* f = lval_pop(v, 0);
+    if (lval_type(f) != LVAL_SYM)
+    {
+        lval_del(f);
+        lval_del(v);
+        return lval_err("S-Expression does not begin with a symbol!");
+    }
+
+    // Call builtin_op function with an operator
+    lval* result = f->sym == SYM_DEF ? builtin_def(v) : builtin_op(v, f->sym);
+    lval_del(f);
+    return result;
+}
+
+// Leading children of v to evaluate before it is applied: none for a
+// lambda, just the condition for an if, and otherwise all of them
+static int lval_eval_count(lval* v) {
+    int head = v->count > 0 && lval_type(v->cell[0]) == LVAL_SYM ? v->cell[0]->sym : -1;
+    if (head == SYM_BACKSLASH || head == SYM_LAMBDA) { return 0; }
+    if (head == SYM_IF) { return v->count < 2 ? v->count : 2; }
+    return v->count;
+}
+
+// Evaluates lval type. S-Expressions are evaluated children first, with an
+// explicit frame per open S-Expression in place of recursion. The branch an
+// if picks, and the body of a Function called, take over the frame of the
+// S-Expression that led to them, so tail calls run in a fixed number of
+// frames however many there are. Each call evaluates a fresh copy of the
+// body, made from cells the previous one handed back to the arena. A builtin
+// that calls back into a Function (lval_apply) re-enters this loop, whose
+// frames go on the same stack above the caller's.
+static lval* lval_eval_env(lval* v, lval* env, int line) {
+    // Each frame is an S-Expression, the index of its next unevaluated child
+    // and how many are to be evaluated, its memo key if the result should be
+    // cached, and the local bindings it runs in, which are its own once it is
+    // the body of a call. line marks the frame of the whole input line.
+    typedef struct { lval* v; int i; int n; memo_key* key; lval* env; int owns; int line; } eval_frame;
+    static __thread eval_frame* stack;
+    static __thread int capacity;
+    static __thread int top;
+    int base = top;
+    lval* cached;
+
+    // All other lval types
+    if (lval_type(v) != LVAL_SEXPR) { return v; }
+
+    // Pure expressions we have already seen are answered from the memo cache
+    memo_key* key = NULL;
+    if (memo_enabled() && !in_parallel && memo_lookup(v, &key, &cached)) {
+        lval_del(v);
+        return cached;
+    }
+    stack = stack_reserve(stack, top, &capacity, sizeof(eval_frame));
+    stack[top++] = (eval_frame){ v, 0, lval_eval_count(v), key, env, 0, line };
+
+    while (1) {
+        eval_frame* f = &stack[top - 1];
+
+        // Descend into the next child S-Expression, if any remain
+        if (f->i < f->n) {
+            lval* c = f->v->cell[f->i];
+            if (lval_type(c) != LVAL_SEXPR) { f->i++; continue; }
+
+            if (memo_enabled() && !in_parallel && memo_lookup(c, &key, &cached)) {
+                lval_del(c);
+                f->v->cell[f->i++] = cached;
+                continue;
+            }
+            lval* env = f->env;
+            stack = stack_reserve(stack, top, &capacity, sizeof(eval_frame));
+            stack[top++] = (eval_frame){ c, 0, lval_eval_count(c), key, env, 0, 0 };
+            continue;
+        }
+
+        // Every child that needs it is a value now, so apply this S-Expression
+        lval* x = f->v;
+        int head = x->count > 0 && lval_type(x->cell[0]) == LVAL_SYM ? x->cell[0]->sym : -1;
+        lval* call_env = NULL;
+        lval* next = NULL;
+        lval* result = NULL;
+        if (head == SYM_BACKSLASH || head == SYM_LAMBDA) {
+            result = lval_lambda(x, f->env);
+        } else if (head == SYM_IF) {
+            next = lval_if(x, f->env);
+        } else {
+            result = lval_eval_sexpr(x, f->env, &call_env, f->line);
+            if (call_env != NULL) { next = result; }
+        }
+        f = &stack[top - 1];
+
+        // Carry on in this frame with the branch or body, in its bindings
+        if (next != NULL) {
+            if (call_env != NULL) {
+                if (f->owns) { lval_del(f->env); }
+                f->env = call_env;
+                f->owns = 1;
+            }
+            f->line = 0;
+            if (lval_type(next) == LVAL_SEXPR) {
+                f->v = next;
+                f->i = 0;
+                f->n = lval_eval_count(next);
+                continue;
+            }
+            result = lval_lookup(next, f->env);
+        }
+
+        if (f->key != NULL) { memo_store(f->key, result); }
+        if (f->owns) { lval_del(f->env); }
+
+        if (--top == base) { return result; }
+        f = &stack[top - 1];
+        f->v->cell[f->i++] = result;
+    }
+}
+
+lval* lval_eval(lval* v) {
+    return lval_eval_env(v, NULL, 1);
+}
+
+lval* lval_eval_in(lval* v, lval* env) {
+    return lval_eval_env(v, env, 0);
+}
+
+// Next line of input without its newline, or NULL at the end. Piped input
+// skips line editing, so its prompts go through the output buffer in order
+// with the results.
+static char* input_line(int interactive) {
+#ifndef _WIN32
+    if (!interactive) {
+        char* line = NULL;
+        size_t size = 0;
+        out_str(">> ");
+        ssize_t n = getline(&line, &size, stdin);
+        if (n < 0) {
+            free(line);
+            return NULL;
+        }
+        if (n > 0 && line[n - 1] == '\n') { line[n - 1] = '\0'; }
+        return line;
+    }
+#endif
+    (void)interactive;
+    out_flush();
+    return readline(">> ");
+}
+
+int main(int argc, char** argv) {
+
+    // Command-line options
+    int engine = ENGINE_TREE;
+    int reader = READER_NATIVE;
+#ifdef _WIN32
+    int interactive = 1;
+#else
+    int interactive = isatty(STDIN_FILENO);
+    out_mode = isatty(STDOUT_FILENO) ? OUT_LINE : OUT_BLOCK;
+#endif
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--engine=tree") == 0) { engine = ENGINE_TREE; }
+        else if (strcmp(argv[i], "--engine=vm") == 0) { engine = ENGINE_VM; }
+        else if (strcmp(argv[i], "--reader=native") == 0) { reader = READER_NATIVE; }
+        else if (strcmp(argv[i], "--reader=ast") == 0) { reader = READER_AST; }
+        else if (strcmp(argv[i], "--reader=fold") == 0) { reader = READER_FOLD; }
+        else if (strncmp(argv[i], "--memo=", 7) == 0 && atoi(argv[i] + 7) > 0) {
+            memo_init(atoi(argv[i] + 7));
+        }
+        else if (strncmp(argv[i], "--scale=", 8) == 0 && isdigit((unsigned char)argv[i][8]) &&
+                 atoi(argv[i] + 8) <= DEC_SCALE_MAX) {
+            dec_scale = atoi(argv[i] + 8);
+        }
+        else if (strncmp(argv[i], "--round=", 8) == 0 && dec_round_mode(argv[i] + 8) >= 0) {
+            dec_round = dec_round_mode(argv[i] + 8);
+        }
+        else if (strcmp(argv[i], "--flush=line") == 0) { out_mode = OUT_LINE; }
+        else if (strcmp(argv[i], "--flush=block") == 0) { out_mode = OUT_BLOCK; }
+        else if (strncmp(argv[i], "--precision=", 12) == 0 && atoi(argv[i] + 12) >= BIGFLOAT_PREC_MIN &&
+                 atoi(argv[i] + 12) <= BIGFLOAT_PREC_MAX) {
+            bigfloat_prec = atoi(argv[i] + 12);
+        }
+        else if (strncmp(argv[i], "--threads=", 10) == 0 && atoi(argv[i] + 10) > 0) {
+            pool_threads = atoi(argv[i] + 10);
+        }
+        else {
+            fprintf(stderr, "Usage: %s [--engine=tree|vm] [--reader=native|fold|ast] [--memo=ENTRIES]\n"
+                "          [--scale=DIGITS] [--round=half-even|half-up|half-down|down|up|floor|ceiling]\n"
+                "          [--flush=line|block] [--precision=BITS] [--threads=N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Builtin symbols get their fixed IDs before any input is read
+    intern_init();
+    read_init();
+
+    // CPU features and the float printer's tables, set up before any
+    // worker thread can use them
+    reduce_init();
+    vec_init();
+    dtoa_init();
+
+    out_str("MyCLC -- My Command-line Lisp Calculator\nDeveloped by Noah Altunian (github.com/naltun/)\n\n");
+    out_str("Press ctrl+C to Exit\n\n");
+
+    while (1) {
+
+        // Output prompt and retrieve user input
+        char* input = input_line(interactive);
+
+        // End of input (ctrl+D, or the end of a piped batch)
+        if (input == NULL) { out_char('\n'); break; }
+
+        // if input is 'exit' or 'quit', then exit with a status of 0
+        if (strcmp(input, "exit") == 0 || strcmp(input, "quit") == 0) { free(input); break; }
+
+        // add user input to input history
+        if (interactive) { add_history(input); }
+
+        // Parse user input; errors are reported by the reader
+        lval* x = read_line(reader, input);
+        if (x != NULL) {
+            x = engine == ENGINE_VM ? vm_eval(x) : lval_eval(x);
+            lval_println(x);
+#ifdef MYCLC_MALLOC
+            lval_del(x);
+#endif
+        }
+
+        // The whole result tree lives in the arena, so drop it in one go
+        arena_reset();
+        lval_parallel_reset();
+
+        free(input);
+    }
+
+    out_flush();
+
+    // Undefine and delete parsers
+    read_cleanup();
+
+    // Cache counters, for tuning --memo
+    if (memo_enabled()) { memo_report(); }
 
     return 0;
 }
@@ -0,0 +1,135 @@
+#include <string.h>
+
+#ifdef _WIN32
+#include <stdio.h>
+#else
+#include <errno.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "out.h"
+
+int out_mode = OUT_LINE;
+
+static char buffer[OUT_BUFFER_SIZE];
+static size_t used;
+
+// "00" through "99", so integers are formatted two digits per division
+static const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+#ifdef _WIN32
+static void out_write(const char* p, size_t n) {
+    fwrite(p, 1, n, stdout);
+    fflush(stdout);
+}
+
+static void out_writev(const char* p, size_t n, const char* q, size_t m) {
+    out_write(p, n);
+    out_write(q, m);
+}
+#else
+// Writes all n bytes, resuming after short writes and signals. Output that
+// cannot be written at all (a closed pipe) is dropped.
+static void out_write(const char* p, size_t n) {
+    while (n > 0) {
+        ssize_t w = write(STDOUT_FILENO, p, n);
+        if (w < 0) {
+            if (errno == EINTR) { continue; }
+            return;
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+}
+
+// The same for two pieces, in one system call unless it comes up short
+static void out_writev(const char* p, size_t n, const char* q, size_t m) {
+    struct iovec iov[2] = { { (void*)p, n }, { (void*)q, m } };
+    ssize_t w;
+    do { w = writev(STDOUT_FILENO, iov, 2); } while (w < 0 && errno == EINTR);
+    if (w < 0) { return; }
+
+    size_t done = (size_t)w;
+    if (done < n) {
+        out_write(p + done, n - done);
+        out_write(q, m);
+    } else {
+        out_write(q + (done - n), m - (done - n));
+    }
+}
+#endif
+
+void out_flush(void) {
+    out_write(buffer, used);
+    used = 0;
+}
+
+void out_bytes(const char* s, size_t n) {
+    if (n <= OUT_BUFFER_SIZE - used) {
+        memcpy(buffer + used, s, n);
+        used += n;
+        return;
+    }
+
+    // Too large to buffer: send what is held and s together, uncopied
+    if (n >= OUT_BUFFER_SIZE / 2) {
+        out_writev(buffer, used, s, n);
+        used = 0;
+        return;
+    }
+    out_flush();
+    memcpy(buffer, s, n);
+    used = n;
+}
+
+void out_str(const char* s) {
+    out_bytes(s, strlen(s));
+}
+
+void out_char(char c) {
+    if (used == OUT_BUFFER_SIZE) { out_flush(); }
+    buffer[used++] = c;
+}
+
+char* out_reserve(size_t n) {
+    if (n > OUT_BUFFER_SIZE - used) { out_flush(); }
+    return buffer + used;
+}
+
+void out_commit(size_t n) {
+    used += n;
+}
+
+void out_long(long x) {
+    // Sign and 19 digits
+    char digits[20];
+    char* p = digits + sizeof(digits);
+    unsigned long m = x < 0 ? -(unsigned long)x : (unsigned long)x;
+
+    while (m >= 100) {
+        const char* pair = digit_pairs + (m % 100) * 2;
+        m /= 100;
+        *--p = pair[1];
+        *--p = pair[0];
+    }
+    if (m >= 10) {
+        *--p = digit_pairs[m * 2 + 1];
+        *--p = digit_pairs[m * 2];
+    } else {
+        *--p = (char)('0' + m);
+    }
+    if (x < 0) { *--p = '-'; }
+
+    size_t n = (size_t)(digits + sizeof(digits) - p);
+    memcpy(out_reserve(n), p, n);
+    out_commit(n);
+}
+
+void out_newline(void) {
+    out_char('\n');
+    if (out_mode == OUT_LINE) { out_flush(); }
+}
@@ -0,0 +1,34 @@
+#ifndef MYCLC_OUT_H
+#define MYCLC_OUT_H
+
+#include <stddef.h>
+
+// Buffered standard output. Everything the REPL prints is appended to one
+// contiguous buffer and handed to the kernel with write(2), either after
+// every result line (interactive use) or only when the buffer fills and at
+// exit (pipes), so a batch of results costs a handful of system calls.
+// Nothing else may write to stdout while the buffer holds data.
+
+#define OUT_BUFFER_SIZE (64 * 1024)
+
+enum { OUT_LINE, OUT_BLOCK };
+
+// Flush mode; OUT_LINE until changed
+extern int out_mode;
+
+void out_bytes(const char* s, size_t n);
+void out_str(const char* s);
+void out_char(char c);
+void out_long(long x);
+
+// Room for n bytes (at most OUT_BUFFER_SIZE) to be filled in place, then
+// kept with out_commit
+char* out_reserve(size_t n);
+void  out_commit(size_t n);
+
+// Ends a line, flushing it in OUT_LINE mode
+void out_newline(void);
+
+void out_flush(void);
+
+#endif
@@ -0,0 +1,280 @@
+// clock_gettime
+#define _POSIX_C_SOURCE 200809L
+
+#include "pool.h"
+
+int pool_threads;
+
+typedef struct { void (*body)(void* ctx, size_t i, int worker); void* ctx; } pool_each;
+
+// pool_for as ranges of a single index
+static void pool_for_one(void* ctx, size_t lo, size_t hi, int worker) {
+    const pool_each* e = ctx;
+    for (size_t i = lo; i < hi; i++) { e->body(e->ctx, i, worker); }
+}
+
+void pool_for(size_t n, void (*body)(void* ctx, size_t i, int worker), void* ctx) {
+    pool_each e = { body, ctx };
+    pool_run(n, 1, pool_for_one, &e);
+}
+
+#ifdef _WIN32
+
+// No worker threads here; loops run on the caller alone
+int pool_size(void) { return 1; }
+
+void pool_run(size_t n, size_t grain, void (*body)(void* ctx, size_t lo, size_t hi, int worker), void* ctx) {
+    (void)grain;
+    if (n > 0) { body(ctx, 0, n, 0); }
+}
+
+void pool_for_adaptive(size_t n, void (*body)(void* ctx, size_t lo, size_t hi, int worker), void* ctx) {
+    if (n > 0) { body(ctx, 0, n, 0); }
+}
+
+#else
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+// Tasks a deque holds; a thread whose deque is full stops splitting
+#define POOL_DEQUE_SIZE 1024
+
+// A loop over [base, base + n), waited on by the thread that started it
+// until pending, the indices yet to run, comes down to zero. Tasks hold
+// ranges relative to base.
+typedef struct pool_job {
+    void (*body)(void* ctx, size_t lo, size_t hi, int worker);
+    void* ctx;
+    size_t base;
+    size_t grain;
+    size_t pending;
+} pool_job;
+
+typedef struct pool_task {
+    pool_job* job;
+    size_t lo;
+    size_t hi;
+    struct pool_task* next;
+} pool_task;
+
+// The owner pushes and pops at bottom; thieves take from top. Both only
+// ever grow, and index the ring modulo its size.
+typedef struct {
+    int64_t top;
+    int64_t bottom;
+    pool_task* tasks[POOL_DEQUE_SIZE];
+} pool_deque;
+
+static pool_deque deques[POOL_MAX];
+
+// Thread's index into deques, its spare tasks and its state for picking
+// victims
+static __thread int self;
+static __thread pool_task* spare;
+static __thread unsigned seed;
+
+static int started;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+
+// Loops running, nested ones included. Workers look for tasks while there
+// are any and sleep otherwise.
+static int jobs;
+
+static int pool_push(pool_deque* d, pool_task* t) {
+    int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED);
+    int64_t top = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+    if (b - top >= POOL_DEQUE_SIZE) { return 0; }
+    __atomic_store_n(&d->tasks[b % POOL_DEQUE_SIZE], t, __ATOMIC_RELAXED);
+    __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+// The owner's newest task, racing thieves only for the last one
+static pool_task* pool_pop(pool_deque* d) {
+    int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&d->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t top = __atomic_load_n(&d->top, __ATOMIC_RELAXED);
+    if (top > b) {
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    pool_task* t = __atomic_load_n(&d->tasks[b % POOL_DEQUE_SIZE], __ATOMIC_RELAXED);
+    if (top == b) {
+        if (!__atomic_compare_exchange_n(&d->top, &top, top + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) { t = NULL; }
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+    return t;
+}
+
+// The oldest task of another thread, or NULL if there is none or another
+// thief got there first
+static pool_task* pool_steal(pool_deque* d) {
+    int64_t top = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE);
+    if (top >= b) { return NULL; }
+
+    pool_task* t = __atomic_load_n(&d->tasks[top % POOL_DEQUE_SIZE], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&d->top, &top, top + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) { return NULL; }
+    return t;
+}
+
+static pool_task* pool_task_new(pool_job* job, size_t lo, size_t hi) {
+    pool_task* t = spare;
+    if (t != NULL) {
+        spare = t->next;
+    } else if ((t = malloc(sizeof(pool_task))) == NULL) {
+        return NULL;
+    }
+    t->job = job;
+    t->lo = lo;
+    t->hi = hi;
+    return t;
+}
+
+// Runs a range, first halving it down to the grain, each right half pushed
+// for this thread to come back to or another to steal
+static void pool_execute(pool_job* job, size_t lo, size_t hi) {
+    while (hi - lo > job->grain) {
+        size_t mid = lo + (hi - lo) / 2;
+        pool_task* t = pool_task_new(job, mid, hi);
+        if (t == NULL) { break; }
+        if (!pool_push(&deques[self], t)) {
+            t->next = spare;
+            spare = t;
+            break;
+        }
+        hi = mid;
+    }
+    job->body(job->ctx, job->base + lo, job->base + hi, self);
+    __atomic_fetch_sub(&job->pending, hi - lo, __ATOMIC_ACQ_REL);
+}
+
+// Runs one task, this thread's own or a stolen one; 0 if there was none
+static int pool_work(void) {
+    pool_task* t = pool_pop(&deques[self]);
+    int size = pool_threads;
+    for (int k = 0; t == NULL && k < size - 1; k++) {
+        seed = seed * 1103515245u + 12345u;
+        int victim = (int)((seed >> 16) % (unsigned)size);
+        if (victim != self) { t = pool_steal(&deques[victim]); }
+    }
+    if (t == NULL) { return 0; }
+
+    pool_job* job = t->job;
+    size_t lo = t->lo, hi = t->hi;
+    t->next = spare;
+    spare = t;
+    pool_execute(job, lo, hi);
+    return 1;
+}
+
+static void* pool_main(void* arg) {
+    self = (int)(intptr_t)arg;
+    seed = (unsigned)self * 2654435761u;
+    while (1) {
+        pthread_mutex_lock(&lock);
+        while (__atomic_load_n(&jobs, __ATOMIC_ACQUIRE) == 0) { pthread_cond_wait(&wake, &lock); }
+        pthread_mutex_unlock(&lock);
+
+        int idle = 0;
+        while (__atomic_load_n(&jobs, __ATOMIC_ACQUIRE) > 0) {
+            if (pool_work()) {
+                idle = 0;
+            } else if (++idle > 64) {
+                sched_yield();
+            }
+        }
+    }
+    return NULL;
+}
+
+int pool_size(void) {
+    if (pool_threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        pool_threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (pool_threads > POOL_MAX) { pool_threads = POOL_MAX; }
+    return pool_threads;
+}
+
+// Workers are detached and live until the process exits. Any that fail to
+// start just leave more of the work to the others.
+static void pool_start(void) {
+    started = 1;
+    int size = pool_size();
+    for (int w = 1; w < size; w++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, pool_main, (void*)(intptr_t)w) != 0) {
+            pool_threads = w;
+            break;
+        }
+        pthread_detach(thread);
+    }
+}
+
+// pool_run over [base, base + n)
+static void pool_run_from(size_t base, size_t n, size_t grain,
+                          void (*body)(void* ctx, size_t lo, size_t hi, int worker), void* ctx) {
+    if (grain == 0) { grain = 1; }
+    if (n <= grain || pool_size() == 1) {
+        if (n > 0) { body(ctx, base, base + n, self); }
+        return;
+    }
+    if (!started) { pool_start(); }
+
+    pool_job job = { body, ctx, base, grain, n };
+    if (__atomic_fetch_add(&jobs, 1, __ATOMIC_ACQ_REL) == 0) {
+        pthread_mutex_lock(&lock);
+        pthread_cond_broadcast(&wake);
+        pthread_mutex_unlock(&lock);
+    }
+
+    // Help with whatever is there, this loop or others, until it is done
+    pool_execute(&job, 0, n);
+    while (__atomic_load_n(&job.pending, __ATOMIC_ACQUIRE) > 0) {
+        if (!pool_work()) { sched_yield(); }
+    }
+    __atomic_fetch_sub(&jobs, 1, __ATOMIC_ACQ_REL);
+}
+
+void pool_run(size_t n, size_t grain, void (*body)(void* ctx, size_t lo, size_t hi, int worker), void* ctx) {
+    pool_run_from(0, n, grain, body, ctx);
+}
+
+static long long pool_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void pool_for_adaptive(size_t n, void (*body)(void* ctx, size_t lo, size_t hi, int worker), void* ctx) {
+    // Doubling runs of indices until they add up to POOL_SAMPLE_NS
+    size_t done = 0;
+    long long start = pool_now(), elapsed = 0;
+    for (size_t run = 1; done < n && elapsed < POOL_SAMPLE_NS; run *= 2) {
+        size_t hi = n - done < run ? n : done + run;
+        body(ctx, done, hi, self);
+        done = hi;
+        elapsed = pool_now() - start;
+    }
+    if (done == n) { return; }
+
+    double per_index = (double)(elapsed > 0 ? elapsed : 1) / done;
+    if (per_index * (n - done) < POOL_TASK_NS || pool_size() == 1) {
+        body(ctx, done, n, self);
+        return;
+    }
+
+    pool_run_from(done, n - done, (size_t)(POOL_TASK_NS / per_index), body, ctx);
+}
+
+#endif
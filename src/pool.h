@@ -0,0 +1,45 @@
+#ifndef MYCLC_POOL_H
+#define MYCLC_POOL_H
+
+#include <stddef.h>
+
+// Work-stealing pool of worker threads, one per CPU. Each thread keeps a
+// Chase-Lev deque of tasks: it splits its own ranges in half, pushing one
+// half to the bottom for itself and leaving the older, larger halves at
+// the top for idle threads to steal. Loops may be nested, and a thread
+// waiting on one runs other tasks meanwhile. The threads start on first use
+// and sleep while no loop is running; the calling thread always takes part.
+// Loop bodies run concurrently, so they must not touch the output buffer or
+// any other unshared state, nor the evaluation arena unless each worker
+// switches to its own with arena_use.
+
+#define POOL_MAX 64
+
+// Target length of a task for pool_for_adaptive, and how long its caller
+// times the first indices for before deciding how to split the rest
+#define POOL_TASK_NS   50000
+#define POOL_SAMPLE_NS 20000
+
+// Threads to use, the caller included: set before first use, or left at 0
+// for one per online CPU. Clamped to 1 .. POOL_MAX.
+extern int pool_threads;
+
+// Number of threads the loops run on
+int  pool_size(void);
+
+// Runs body(ctx, i, worker) for every i in [0, n), each index a task of its
+// own, and returns once all have finished. worker is in [0, pool_size())
+// and names the thread, for per-thread scratch space.
+void pool_for(size_t n, void (*body)(void* ctx, size_t i, int worker), void* ctx);
+
+// Runs body(ctx, lo, hi, worker) over disjoint ranges covering [0, n), none
+// longer than grain, and returns once all have finished
+void pool_run(size_t n, size_t grain, void (*body)(void* ctx, size_t lo, size_t hi, int worker), void* ctx);
+
+// pool_run for bodies of unknown and possibly tiny cost per index. The
+// caller runs the first ranges itself, timing them, then splits the rest
+// into ranges of about POOL_TASK_NS each; or, if the rest would take less
+// than that, runs it alone, so small inputs never wake the pool.
+void pool_for_adaptive(size_t n, void (*body)(void* ctx, size_t lo, size_t hi, int worker), void* ctx);
+
+#endif
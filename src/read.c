@@ -0,0 +1,540 @@
+#include <ctype.h>
+#include <limits.h>
+
+#include "../libs/mpc.h"
+#include "decimal.h"
+#include "intlit.h"
+#include "intern.h"
+#include "out.h"
+#include "read.h"
+
+// mpca_lang grammar, producing an mpc_ast_t for lval_read
+static mpc_parser_t* Number;
+static mpc_parser_t* Symbol;
+static mpc_parser_t* Sexpr;
+static mpc_parser_t* Vector;
+static mpc_parser_t* Expr;
+static mpc_parser_t* MyCLC;
+
+// The same grammar built from combinators whose semantic actions return
+// lvals, so no mpc_ast_t is ever allocated. Keep the two in step.
+static mpc_parser_t* FoldNumber;
+static mpc_parser_t* FoldSymbol;
+static mpc_parser_t* FoldSexpr;
+static mpc_parser_t* FoldVector;
+static mpc_parser_t* FoldExpr;
+static mpc_parser_t* FoldMyCLC;
+
+// Decimal literal of len bytes, ending in 'm'
+static lval* lval_read_dec(const char* s, int len) {
+    __int128 x;
+    return dec_parse(s, len, &x) ? lval_dec(x) : lval_err("Decimal overflow!");
+}
+
+// Integer literal of len bytes, in any radix. Integers too wide for a long
+// are read straight into a bigint.
+static lval* lval_read_int(const char* s, int len) {
+    int64_t x;
+    return intlit_parse(s, len, &x) ? lval_num(x) : lval_big(bigint_parse(s, len));
+}
+
+// Float literal of len bytes: a Double at the default precision, otherwise
+// a multi-precision Float rounded once from the exact decimal
+static lval* lval_read_float(const char* s, int len) {
+    if (bigfloat_prec == BIGFLOAT_PREC_DOUBLE) { return lval_dbl(strtod(s, NULL)); }
+
+    bigfloat x;
+    if (!bigfloat_parse(s, len, &x)) { return lval_err("Float out of range!"); }
+    return lval_mpf(x);
+}
+
+static lval* lval_read_num(const char* s) {
+    int len = strlen(s);
+    int skip;
+    if (intlit_radix(s[0] == '-' ? s + 1 : s, &skip) != 10) { return lval_read_int(s, len); }
+    if (s[len - 1] == 'm') { return lval_read_dec(s, len); }
+
+    // A fraction or exponent makes it a Float
+    if (strpbrk(s, ".eE") != NULL) { return lval_read_float(s, len); }
+
+    return lval_read_int(s, len);
+}
+
+// Converts a single AST node; S-Expressions come back empty for lval_read to fill
+static lval* lval_read_node(mpc_ast_t* t) {
+    // If lval type is Symbol or Number return conversion to Symbol or Number
+    if (strstr(t->tag, "number")) { return lval_read_num(t->contents); }
+    if (strstr(t->tag, "symbol")) { return lval_sym(t->contents); }
+
+    // Vectors hold only numbers, so they are read whole. A ';' among them
+    // ends a row and makes it a Matrix.
+    if (strstr(t->tag, "vector")) {
+        lval* rows = NULL;
+        lval* list = lval_sexpr();
+        for (int i = 0; i < t->children_num; i++) {
+            mpc_ast_t* c = t->children[i];
+            if (strstr(c->tag, "number")) {
+                lval_add(list, lval_read_num(c->contents));
+            } else if (strcmp(c->contents, ";") == 0) {
+                if (rows == NULL) { rows = lval_sexpr(); }
+                lval_add(rows, list);
+                list = lval_sexpr();
+            }
+        }
+        return rows == NULL ? lval_vec_pack(list) : lval_mat_pack(lval_add(rows, list));
+    }
+
+    // If > or Sexpr then create an empty list
+    return lval_sexpr();
+}
+
+// Skips punctuation and the /^/ and /$/ anchors
+static int lval_read_skip(mpc_ast_t* t) {
+    if (strcmp(t->contents, "(") == 0) { return 1; }
+    if (strcmp(t->contents, ")") == 0) { return 1; }
+    if (strcmp(t->contents, "{") == 0) { return 1; }
+    if (strcmp(t->contents, "}") == 0) { return 1; }
+    if (strcmp(t->tag, "regex")  == 0) { return 1; }
+    return 0;
+}
+
+static lval* lval_read(mpc_ast_t* t) {
+    // Each frame is an AST node, the list being filled from it, and the index
+    // of its next child
+    typedef struct { mpc_ast_t* t; lval* x; int i; } read_frame;
+    static read_frame* stack;
+    static int capacity;
+    int top = 0;
+
+    lval* root = lval_read_node(t);
+    if (lval_type(root) != LVAL_SEXPR) { return root; }
+    stack = stack_reserve(stack, top, &capacity, sizeof(read_frame));
+    stack[top++] = (read_frame){ t, root, 0 };
+
+    // Fill list with any valid expression (expr)
+    while (top > 0) {
+        read_frame* f = &stack[top - 1];
+        if (f->i == f->t->children_num) { top--; continue; }
+
+        mpc_ast_t* c = f->t->children[f->i++];
+        if (lval_read_skip(c)) { continue; }
+
+        lval* x = lval_read_node(c);
+        lval_add(f->x, x);
+        if (lval_type(x) == LVAL_SEXPR) {
+            stack = stack_reserve(stack, top, &capacity, sizeof(read_frame));
+            stack[top++] = (read_frame){ c, x, 0 };
+        }
+    }
+
+    return root;
+}
+
+// Describes c the way mpc_err_print does
+static const char* read_error_char(const char* c) {
+    static char quoted[4] = "' '";
+    switch (*c)
+    {
+        case '\0': return "end of input";
+        case '\n': return "newline";
+        case '\t': return "tab";
+        case '\r': return "carriage return";
+        case '\v': return "vertical tab";
+        case '\f': return "formfeed";
+        case '\a': return "bell";
+        case '\b': return "backspace";
+        case ' ':  return "space";
+        default:
+            quoted[1] = *c;
+            return quoted;
+    }
+}
+
+// Prints a syntax error at p in the same form and position as the mpc readers
+static void read_error_print(const char* input, const char* p, const char* expected) {
+    int row = 1, col = 1;
+    for (const char* q = input; q < p; q++) {
+        if (*q == '\n') { row++; col = 1; } else { col++; }
+    }
+    char location[64];
+    snprintf(location, sizeof(location), "<stdin>:%i:%i: error: expected ", row, col);
+    out_str(location);
+    out_str(expected);
+    out_str(" at ");
+    out_str(read_error_char(p));
+    out_newline();
+}
+
+// Characters that start a name, and that continue one
+#define READ_NAME_START "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_"
+#define READ_NAME_CHARS "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_"
+
+#define READ_DIGITS "one or more of one of '0123456789'"
+
+// Every way a symbol other than '-' can start, in the grammar's order
+#define READ_SYMBOLS "'+', '*', '/', '%', '^', '\\', \"<=\", \">=\", \"==\", \"!=\", '<', '>', " \
+    "one of '" READ_NAME_START "'"
+
+// Prints the ", "-separated expectations in list as mpc does: "a, b or c",
+// with only the first of any repeats
+static void read_error_list(const char* input, const char* p, const char* list) {
+    const char* items[64];
+    size_t lens[64];
+    int n = 0;
+    for (const char* s = list; *s != '\0';) {
+        const char* end = strstr(s, ", ");
+        size_t len = end != NULL ? (size_t)(end - s) : strlen(s);
+        int repeat = 0;
+        for (int i = 0; i < n; i++) {
+            if (lens[i] == len && memcmp(items[i], s, len) == 0) { repeat = 1; }
+        }
+        if (!repeat && n < 64) {
+            items[n] = s;
+            lens[n++] = len;
+        }
+        s += end != NULL ? len + 2 : len;
+    }
+
+    char expected[1024];
+    size_t used = 0;
+    for (int i = 0; i < n; i++) {
+        const char* sep = i == 0 ? "" : i == n - 1 ? " or " : ", ";
+        used += snprintf(expected + used, sizeof(expected) - used, "%s%.*s", sep, (int)lens[i], items[i]);
+        if (used >= sizeof(expected)) { used = sizeof(expected) - 1; }
+    }
+    expected[used] = '\0';
+    read_error_print(input, p, expected);
+}
+
+// Reports a missing expression at p with mpc's wording, so scripts matching
+// on errors see no difference. mpc also lists the ways the tokens just before
+// p could have continued, which the scanner passes in as prefix.
+static void read_error(const char* input, const char* p, int nested, const char* prefix) {
+    char list[1024];
+    const char* exprs = "'-', '0', " READ_DIGITS ", " READ_SYMBOLS ", '(', '['";
+    if (p > input && p[-1] == '-') {
+        exprs = "'0', " READ_DIGITS ", '-', " READ_SYMBOLS ", '(', '['";
+    }
+
+    snprintf(list, sizeof(list), "%s%s, %s", prefix, exprs, nested ? "')'" : "end of input");
+    read_error_list(input, p, list);
+}
+
+// The same inside a Vector literal, where only numbers, ';' or ']' can follow
+static void read_vector_error(const char* input, const char* p, const char* prefix) {
+    char list[512];
+    snprintf(list, sizeof(list), "%s'-', '0', " READ_DIGITS ", ';', ']'", prefix);
+    read_error_list(input, p, list);
+}
+
+// Digits of the prefixed literals, and mpc's names for one and for a run
+typedef struct { const char* digits; const char* one; const char* run; } read_radix;
+
+static const read_radix read_radixes[] = {
+    { "0123456789abcdefABCDEF", "one of '0123456789abcdefABCDEF', ", "one or more of one of '0123456789abcdefABCDEF'" },
+    { "01234567",               "one of '01234567', ",               "one or more of one of '01234567'" },
+    { "01",                     "one of '01', ",                     "one or more of one of '01'" },
+};
+
+// Reads the line in a single pass straight off the input buffer, with an
+// explicit stack of open S-Expressions and no temporary strings
+static lval* read_native(const char* input) {
+    static lval** stack;
+    static int capacity;
+    int top = 0;
+
+    lval* root = lval_sexpr();
+    stack = stack_reserve(stack, top, &capacity, sizeof(lval*));
+    stack[top++] = root;
+
+    // End and continuation list of the last number, for error messages
+    const char* last = NULL;
+    const char* prefix = "";
+    const char* expected = NULL;
+
+    // mpc backs out of an exponent or radix prefix with no digits after it
+    // and reads the shorter number, but still reports that failure if no
+    // later one gets further
+    const char* pending = NULL;
+    const char* pending_at = NULL;
+
+    // Elements of an open Vector literal, and the rows before them once a
+    // ';' has made it a Matrix
+    lval* vector = NULL;
+    lval* rows = NULL;
+
+    const char* p = input;
+    while (1) {
+        while (isspace((unsigned char)*p)) { p++; }
+
+        char c = *p;
+        int number = isdigit((unsigned char)c) || (c == '-' && isdigit((unsigned char)p[1]));
+        lval* into = vector != NULL ? vector : stack[top - 1];
+
+        if (vector != NULL && !number) {
+            if (c == ']') {
+                lval_add(stack[top - 1], rows == NULL ? lval_vec_pack(vector) : lval_mat_pack(lval_add(rows, vector)));
+                vector = rows = NULL;
+                p++;
+                continue;
+            }
+            if (c == ';') {
+                if (rows == NULL) { rows = lval_sexpr(); }
+                lval_add(rows, vector);
+                vector = lval_sexpr();
+                p++;
+                continue;
+            }
+
+            // A '-' here could only have started a number
+            if (c == '-') {
+                expected = "'0' or " READ_DIGITS;
+                p++;
+            }
+            break;
+        }
+
+        if (c == '\0' && top == 1) { return root; }
+
+        if (c == '(') {
+            lval* x = lval_sexpr();
+            lval_add(stack[top - 1], x);
+            stack = stack_reserve(stack, top, &capacity, sizeof(lval*));
+            stack[top++] = x;
+            p++;
+        } else if (c == ')' && top > 1) {
+            top--;
+            p++;
+        } else if (c == '[') {
+            vector = lval_sexpr();
+            p++;
+        } else if (number) {
+            const char* start = p;
+            if (c == '-') { p++; }
+
+            // Hex, binary and octal literals are integers and nothing more
+            int skip;
+            int radix = intlit_radix(p, &skip);
+            const read_radix* r = &read_radixes[radix == 16 ? 0 : radix == 8 ? 1 : 2];
+            if (radix != 10 && (p[skip] == '\0' || strchr(r->digits, p[skip]) == NULL)) {
+                // Just the 0, leaving the letter to start a name
+                pending = r->run;
+                pending_at = p + skip;
+                radix = 10;
+            }
+            if (radix != 10) {
+                p += skip;
+                while (*p != '\0' && strchr(r->digits, *p) != NULL) { p++; }
+                prefix = r->one;
+                last = p;
+                lval_add(into, lval_read_int(start, p - start));
+                continue;
+            }
+
+            // A lone 0 could still have become a radix prefix
+            const char* digits = p;
+            while (isdigit((unsigned char)*p)) { p++; }
+            prefix = p - digits == 1 && *digits == '0' ?
+                "'x', 'b', 'o', one of '0123456789', '.', one of 'eE', 'm', " :
+                "one of '0123456789', '.', one of 'eE', 'm', ";
+
+            // A '.' commits to a fraction, as nothing else can start with one
+            int dbl = 0;
+            if (*p == '.') {
+                dbl = 1;
+                if (!isdigit((unsigned char)*++p)) { expected = READ_DIGITS; break; }
+                while (isdigit((unsigned char)*p)) { p++; }
+                prefix = "one of '0123456789', one of 'eE', 'm', ";
+            }
+            if (*p == 'e' || *p == 'E') {
+                const char* q = p + 1;
+                int sign = *q == '-' || *q == '+';
+                q += sign;
+                if (isdigit((unsigned char)*q)) {
+                    dbl = 1;
+                    p = q;
+                    while (isdigit((unsigned char)*p)) { p++; }
+                    prefix = "one of '0123456789', 'm', ";
+                } else {
+                    pending = sign ? READ_DIGITS : "one of '-+', " READ_DIGITS;
+                    pending_at = q;
+                }
+            }
+
+            // A trailing 'm' makes it a Decimal; otherwise strtod stops exactly
+            // where the scan above did
+            if (*p == 'm') {
+                p++;
+                prefix = "";
+                lval_add(into, lval_read_dec(start, p - start));
+            } else if (dbl) {
+                lval_add(into, lval_read_float(start, p - start));
+            } else {
+                lval_add(into, lval_read_int(start, p - start));
+            }
+            last = p;
+        } else if (c != '\0' && strchr("+-*/%^\\<>=!", c) != NULL) {
+            // Comparisons may take an '=', which '=' and '!' cannot do without
+            int len = strchr("<>=!", c) != NULL && p[1] == '=' ? 2 : 1;
+            if (len == 1 && (c == '=' || c == '!')) { break; }
+            lval_add(stack[top - 1], lval_sym_id(intern(p, len)));
+            p += len;
+        } else if (c != '\0' && strchr(READ_NAME_START, c) != NULL) {
+            // Names of builtins were interned first, so they come back as those
+            const char* start = p;
+            while (*p != '\0' && strchr(READ_NAME_CHARS, *p) != NULL) { p++; }
+            lval_add(stack[top - 1], lval_sym_id(intern(start, p - start)));
+            prefix = "one of '" READ_NAME_CHARS "', ";
+            last = p;
+        } else {
+            break;
+        }
+    }
+
+    // Like mpc, report the failure that got furthest, with everything that
+    // was expected there
+    char merged[256];
+    const char* before = p == last ? prefix : "";
+    if (expected != NULL) {
+        read_error_print(input, p, expected);
+    } else if (pending_at != NULL && pending_at > p) {
+        read_error_list(input, pending_at, pending);
+    } else {
+        if (pending_at == p) {
+            snprintf(merged, sizeof(merged), "%s, %s", pending, before);
+            before = merged;
+        }
+        if (vector != NULL) {
+            read_vector_error(input, p, before);
+        } else {
+            read_error(input, p, top > 1, before);
+        }
+    }
+    if (vector != NULL) { lval_del(vector); }
+    if (rows != NULL) { lval_del(rows); }
+    lval_del(root);
+    return NULL;
+}
+
+// Semantic actions for the fold grammar. Token text arrives malloc'd by mpc.
+static mpc_val_t* read_apply_num(mpc_val_t* x) {
+    lval* v = lval_read_num(x);
+    free(x);
+    return v;
+}
+
+static mpc_val_t* read_apply_sym(mpc_val_t* x) {
+    lval* v = lval_sym(x);
+    free(x);
+    return v;
+}
+
+// Gathers the expressions matched by <expr>* into an S-Expression
+static mpc_val_t* read_fold_exprs(int n, mpc_val_t** xs) {
+    lval* v = lval_sexpr();
+    for (int i = 0; i < n; i++) { lval_add(v, xs[i]); }
+    return v;
+}
+
+// Packs '[', the first row, the list of any rows after it and ']' into a
+// Vector, or into a Matrix if there were more rows
+static mpc_val_t* read_fold_vector(int n, mpc_val_t** xs) {
+    lval* first = xs[1];
+    lval* rest = xs[2];
+    free(xs[0]);
+    free(xs[3]);
+    (void)n;
+
+    if (rest->count == 0) {
+        lval_del(rest);
+        return lval_vec_pack(first);
+    }
+    lval* rows = lval_add(lval_sexpr(), first);
+    while (rest->count > 0) { lval_add(rows, lval_pop(rest, 0)); }
+    lval_del(rest);
+    return lval_mat_pack(rows);
+}
+
+// Discards lvals built by a branch that later failed to match
+static void read_dtor(mpc_val_t* x) { lval_del(x); }
+
+void read_init(void) {
+    Number = mpc_new("number");
+    Symbol = mpc_new("symbol");
+    Sexpr  = mpc_new("sexpr");
+    Vector = mpc_new("vector");
+    Expr   = mpc_new("expr");
+    MyCLC  = mpc_new("myclc");
+
+    // MyCLC language definition
+    mpca_lang(MPCA_LANG_DEFAULT,
+    "                                                           \
+        number : /-?(0x[0-9a-fA-F]+|0b[01]+|0o[0-7]+|[0-9]+(\\.[0-9]+)?([eE][-+]?[0-9]+)?m?)/ ; \
+        symbol : '+' | '-' | '*' | '/' | '%' | '^' | '\\\\'     \
+               | \"<=\" | \">=\" | \"==\" | \"!=\" | '<' | '>'  \
+               | /[a-zA-Z_][a-zA-Z0-9_]*/ ;                     \
+        sexpr  : '(' <expr>* ')' ;                              \
+        vector : '[' <number>* (';' <number>*)* ']' ;           \
+        expr   : <number> | <symbol> | <sexpr> | <vector> ;     \
+        myclc  : /^/ <expr>* /$/ ;                              \
+    ",
+    Number, Symbol, Sexpr, Vector, Expr, MyCLC);
+
+    FoldNumber = mpc_new("number");
+    FoldSymbol = mpc_new("symbol");
+    FoldSexpr  = mpc_new("sexpr");
+    FoldVector = mpc_new("vector");
+    FoldExpr   = mpc_new("expr");
+    FoldMyCLC  = mpc_new("myclc");
+
+    mpc_define(FoldNumber, mpc_apply(mpc_tok(mpc_re("-?(0x[0-9a-fA-F]+|0b[01]+|0o[0-7]+|[0-9]+(\\.[0-9]+)?([eE][-+]?[0-9]+)?m?)")), read_apply_num));
+    mpc_define(FoldSymbol, mpc_apply(mpc_or(14,
+        mpc_tok(mpc_char('+')), mpc_tok(mpc_char('-')), mpc_tok(mpc_char('*')),
+        mpc_tok(mpc_char('/')), mpc_tok(mpc_char('%')), mpc_tok(mpc_char('^')),
+        mpc_tok(mpc_char('\\')), mpc_tok(mpc_string("<=")), mpc_tok(mpc_string(">=")),
+        mpc_tok(mpc_string("==")), mpc_tok(mpc_string("!=")), mpc_tok(mpc_char('<')),
+        mpc_tok(mpc_char('>')),
+        mpc_tok(mpc_re("[a-zA-Z_][a-zA-Z0-9_]*"))), read_apply_sym));
+    mpc_define(FoldSexpr, mpc_and(3, mpcf_snd_free,
+        mpc_tok(mpc_char('(')), mpc_many(read_fold_exprs, FoldExpr), mpc_tok(mpc_char(')')),
+        free, read_dtor));
+    mpc_define(FoldVector, mpc_and(4, read_fold_vector,
+        mpc_tok(mpc_char('[')),
+        mpc_many(read_fold_exprs, FoldNumber),
+        mpc_many(read_fold_exprs, mpc_and(2, mpcf_snd_free,
+            mpc_tok(mpc_char(';')), mpc_many(read_fold_exprs, FoldNumber), free)),
+        mpc_tok(mpc_char(']')),
+        free, read_dtor, read_dtor));
+    mpc_define(FoldExpr, mpc_or(4, FoldNumber, FoldSymbol, FoldSexpr, FoldVector));
+    mpc_define(FoldMyCLC, mpc_whole(mpc_stripl(mpc_many(read_fold_exprs, FoldExpr)), read_dtor));
+}
+
+void read_cleanup(void) {
+    mpc_cleanup(6, Number, Symbol, Sexpr, Vector, Expr, MyCLC);
+    mpc_cleanup(6, FoldNumber, FoldSymbol, FoldSexpr, FoldVector, FoldExpr, FoldMyCLC);
+}
+
+lval* read_line(int reader, const char* input) {
+    mpc_result_t r;
+    lval* x = NULL;
+
+    if (reader == READER_NATIVE) { return read_native(input); }
+
+    if (mpc_parse("<stdin>", input, reader == READER_AST ? MyCLC : FoldMyCLC, &r)) {
+        if (reader == READER_AST) {
+            x = lval_read(r.output);
+            mpc_ast_delete(r.output);
+        } else {
+            x = r.output;
+        }
+    } else {
+        // If parse is not successful, print and delete Error
+        char* message = mpc_err_string(r.error);
+        out_bytes(message, strcspn(message, "\n"));
+        out_newline();
+        free(message);
+        mpc_err_delete(r.error);
+    }
+
+    return x;
+}
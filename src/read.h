@@ -0,0 +1,20 @@
+#ifndef MYCLC_READ_H
+#define MYCLC_READ_H
+
+#include "lval.h"
+
+// Readers selectable with --reader=
+//   READER_NATIVE  hand-written single-pass scanner (default)
+//   READER_FOLD    mpc semantic actions build lvals while parsing
+//   READER_AST     mpca_lang grammar to an mpc_ast_t, then walked by lval_read
+enum { READER_NATIVE, READER_FOLD, READER_AST };
+
+// Build the grammars; call once after intern_init
+void read_init(void);
+void read_cleanup(void);
+
+// Parses a line into its root S-Expression. On a syntax error the error is
+// printed and NULL is returned.
+lval* read_line(int reader, const char* input);
+
+#endif
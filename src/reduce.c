@@ -0,0 +1,311 @@
+#include "reduce.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define REDUCE_X86
+#include <immintrin.h>
+#endif
+
+// Exact sum with 128-bit accumulation; 2^63 int64 terms cannot overflow it
+static __int128 reduce_sum_wide(const int64_t* xs, size_t n) {
+    __int128 s = 0;
+    for (size_t i = 0; i < n; i++) { s += xs[i]; }
+    return s;
+}
+
+// Adds xs[i..n) to *s, returning 0 if a 64-bit overflow occurred
+static int reduce_sum_tail(const int64_t* xs, size_t i, size_t n, int64_t* s) {
+    int ok = 1;
+    for (; i < n; i++) { ok &= !__builtin_add_overflow(*s, xs[i], s); }
+    return ok;
+}
+
+static __int128 reduce_sum_scalar(const int64_t* xs, size_t n) {
+    int64_t s = 0;
+    if (reduce_sum_tail(xs, 0, n, &s)) { return s; }
+    return reduce_sum_wide(xs, n);
+}
+
+// Set once by reduce_init, before any pool thread can read it
+static int reduce_has_avx2;
+
+void reduce_init(void) {
+#ifdef REDUCE_X86
+    reduce_has_avx2 = __builtin_cpu_supports("avx2");
+#endif
+}
+
+#ifdef REDUCE_X86
+
+static int reduce_avx2(void) {
+    return reduce_has_avx2;
+}
+
+// Signed lane overflow of s = a + b: a and b agree in sign and s does not
+#define REDUCE_OVERFLOW(a, b, s) (((a) ^ (s)) & ((b) ^ (s)))
+
+__attribute__((target("avx2")))
+static __int128 reduce_sum_avx2(const int64_t* xs, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    __m256i ovf = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(xs + i));
+        __m256i s = _mm256_add_epi64(acc, x);
+        ovf = _mm256_or_si256(ovf, _mm256_and_si256(_mm256_xor_si256(acc, s), _mm256_xor_si256(x, s)));
+        acc = s;
+    }
+
+    // Any lane sign bit set in ovf means that lane wrapped
+    if (_mm256_movemask_pd(_mm256_castsi256_pd(ovf)) != 0) { return reduce_sum_wide(xs, n); }
+
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, acc);
+    __int128 s = (__int128)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; i++) { s += xs[i]; }
+    return s;
+}
+
+static __int128 reduce_sum_sse2(const int64_t* xs, size_t n) {
+    __m128i acc = _mm_setzero_si128();
+    __m128i ovf = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 2 <= n; i += 2) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(xs + i));
+        __m128i s = _mm_add_epi64(acc, x);
+        ovf = _mm_or_si128(ovf, _mm_and_si128(_mm_xor_si128(acc, s), _mm_xor_si128(x, s)));
+        acc = s;
+    }
+
+    if (_mm_movemask_pd(_mm_castsi128_pd(ovf)) != 0) { return reduce_sum_wide(xs, n); }
+
+    int64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, acc);
+    __int128 s = (__int128)lanes[0] + lanes[1];
+    for (; i < n; i++) { s += xs[i]; }
+    return s;
+}
+
+#endif
+
+__int128 reduce_sum_i64(const int64_t* xs, size_t n) {
+#ifdef REDUCE_X86
+    // Short lists are not worth setting up vectors for
+    if (n >= 16) { return reduce_avx2() ? reduce_sum_avx2(xs, n) : reduce_sum_sse2(xs, n); }
+#endif
+    return reduce_sum_scalar(xs, n);
+}
+
+// Neither AVX2 nor SSE has a 64-bit multiply with overflow detection, so the
+// product runs four independent scalar chains to keep the multiplier busy.
+// A chain that overflows sinks the whole product unless some factor is zero.
+int reduce_prod_i64(const int64_t* xs, size_t n, int64_t* out) {
+    int64_t p[4] = { 1, 1, 1, 1 };
+    int ok = 1, zero = 0;
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        for (int k = 0; k < 4; k++) {
+            ok &= !__builtin_mul_overflow(p[k], xs[i + k], &p[k]);
+            zero |= xs[i + k] == 0;
+        }
+    }
+    for (; i < n; i++) {
+        ok &= !__builtin_mul_overflow(p[0], xs[i], &p[0]);
+        zero |= xs[i] == 0;
+    }
+
+    if (zero) { *out = 0; return 1; }
+    ok &= !__builtin_mul_overflow(p[0], p[1], &p[0]);
+    ok &= !__builtin_mul_overflow(p[2], p[3], &p[2]);
+    ok &= !__builtin_mul_overflow(p[0], p[2], out);
+    return ok;
+}
+
+static int64_t reduce_min_i64_scalar(const int64_t* xs, size_t n) {
+    int64_t m = xs[0];
+    for (size_t i = 1; i < n; i++) { m = xs[i] < m ? xs[i] : m; }
+    return m;
+}
+
+static int64_t reduce_max_i64_scalar(const int64_t* xs, size_t n) {
+    int64_t m = xs[0];
+    for (size_t i = 1; i < n; i++) { m = xs[i] > m ? xs[i] : m; }
+    return m;
+}
+
+static double reduce_sum_f64_scalar(const double* xs, size_t n) {
+    double s = 0;
+    for (size_t i = 0; i < n; i++) { s += xs[i]; }
+    return s;
+}
+
+static double reduce_prod_f64_scalar(const double* xs, size_t n) {
+    double p = 1;
+    for (size_t i = 0; i < n; i++) { p *= xs[i]; }
+    return p;
+}
+
+// NaN-propagating comparisons, as opposed to fmin and fmax
+static double reduce_min_f64_scalar(const double* xs, size_t n) {
+    double m = xs[0];
+    for (size_t i = 1; i < n; i++) { m = xs[i] < m || xs[i] != xs[i] ? xs[i] : m; }
+    return m;
+}
+
+static double reduce_max_f64_scalar(const double* xs, size_t n) {
+    double m = xs[0];
+    for (size_t i = 1; i < n; i++) { m = xs[i] > m || xs[i] != xs[i] ? xs[i] : m; }
+    return m;
+}
+
+#ifdef REDUCE_X86
+
+// SSE has no 64-bit signed compare before SSE4.2, so integer min and max
+// only have an AVX2 kernel
+__attribute__((target("avx2")))
+static int64_t reduce_minmax_i64_avx2(const int64_t* xs, size_t n, int max) {
+    __m256i m = _mm256_loadu_si256((const __m256i*)xs);
+    size_t i = 4;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(xs + i));
+        m = _mm256_blendv_epi8(m, x, max ? _mm256_cmpgt_epi64(x, m) : _mm256_cmpgt_epi64(m, x));
+    }
+
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, m);
+    int64_t r = max ? reduce_max_i64_scalar(lanes, 4) : reduce_min_i64_scalar(lanes, 4);
+    for (; i < n; i++) {
+        if (max ? xs[i] > r : xs[i] < r) { r = xs[i]; }
+    }
+    return r;
+}
+
+// Sum (mul = 0) or product of xs in four lanes, combined at the end
+__attribute__((target("avx")))
+static double reduce_fold_f64_avx(const double* xs, size_t n, int mul) {
+    __m256d acc = _mm256_set1_pd(mul ? 1.0 : 0.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_loadu_pd(xs + i);
+        acc = mul ? _mm256_mul_pd(acc, x) : _mm256_add_pd(acc, x);
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    double r = mul ? (lanes[0] * lanes[1]) * (lanes[2] * lanes[3]) : (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < n; i++) { r = mul ? r * xs[i] : r + xs[i]; }
+    return r;
+}
+
+static double reduce_fold_f64_sse2(const double* xs, size_t n, int mul) {
+    __m128d acc = _mm_set1_pd(mul ? 1.0 : 0.0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d x = _mm_loadu_pd(xs + i);
+        acc = mul ? _mm_mul_pd(acc, x) : _mm_add_pd(acc, x);
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, acc);
+    double r = mul ? lanes[0] * lanes[1] : lanes[0] + lanes[1];
+    for (; i < n; i++) { r = mul ? r * xs[i] : r + xs[i]; }
+    return r;
+}
+
+// Min or max in lanes. The vector instructions drop NaNs depending on
+// operand order, so a list holding one is left to the scalar loop.
+__attribute__((target("avx")))
+static int reduce_minmax_f64_avx(const double* xs, size_t n, int max, double* out) {
+    __m256d m = _mm256_loadu_pd(xs);
+    __m256d nan = _mm256_cmp_pd(m, m, _CMP_UNORD_Q);
+    size_t i = 4;
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_loadu_pd(xs + i);
+        nan = _mm256_or_pd(nan, _mm256_cmp_pd(x, x, _CMP_UNORD_Q));
+        m = max ? _mm256_max_pd(m, x) : _mm256_min_pd(m, x);
+    }
+    if (_mm256_movemask_pd(nan) != 0) { return 0; }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, m);
+    double r = max ? reduce_max_f64_scalar(lanes, 4) : reduce_min_f64_scalar(lanes, 4);
+    for (; i < n; i++) {
+        if (xs[i] != xs[i]) { return 0; }
+        if (max ? xs[i] > r : xs[i] < r) { r = xs[i]; }
+    }
+    *out = r;
+    return 1;
+}
+
+static int reduce_minmax_f64_sse2(const double* xs, size_t n, int max, double* out) {
+    __m128d m = _mm_loadu_pd(xs);
+    __m128d nan = _mm_cmpunord_pd(m, m);
+    size_t i = 2;
+    for (; i + 2 <= n; i += 2) {
+        __m128d x = _mm_loadu_pd(xs + i);
+        nan = _mm_or_pd(nan, _mm_cmpunord_pd(x, x));
+        m = max ? _mm_max_pd(m, x) : _mm_min_pd(m, x);
+    }
+    if (_mm_movemask_pd(nan) != 0) { return 0; }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, m);
+    double r = max ? reduce_max_f64_scalar(lanes, 2) : reduce_min_f64_scalar(lanes, 2);
+    for (; i < n; i++) {
+        if (xs[i] != xs[i]) { return 0; }
+        if (max ? xs[i] > r : xs[i] < r) { r = xs[i]; }
+    }
+    *out = r;
+    return 1;
+}
+#endif
+
+int64_t reduce_min_i64(const int64_t* xs, size_t n) {
+#ifdef REDUCE_X86
+    if (n >= 16 && reduce_avx2()) { return reduce_minmax_i64_avx2(xs, n, 0); }
+#endif
+    return reduce_min_i64_scalar(xs, n);
+}
+
+int64_t reduce_max_i64(const int64_t* xs, size_t n) {
+#ifdef REDUCE_X86
+    if (n >= 16 && reduce_avx2()) { return reduce_minmax_i64_avx2(xs, n, 1); }
+#endif
+    return reduce_max_i64_scalar(xs, n);
+}
+
+double reduce_sum_f64(const double* xs, size_t n) {
+#ifdef REDUCE_X86
+    if (n >= 16) { return reduce_avx2() ? reduce_fold_f64_avx(xs, n, 0) : reduce_fold_f64_sse2(xs, n, 0); }
+#endif
+    return reduce_sum_f64_scalar(xs, n);
+}
+
+double reduce_prod_f64(const double* xs, size_t n) {
+#ifdef REDUCE_X86
+    if (n >= 16) { return reduce_avx2() ? reduce_fold_f64_avx(xs, n, 1) : reduce_fold_f64_sse2(xs, n, 1); }
+#endif
+    return reduce_prod_f64_scalar(xs, n);
+}
+
+double reduce_min_f64(const double* xs, size_t n) {
+#ifdef REDUCE_X86
+    double r;
+    if (n >= 16 && (reduce_avx2() ? reduce_minmax_f64_avx(xs, n, 0, &r) : reduce_minmax_f64_sse2(xs, n, 0, &r))) {
+        return r;
+    }
+#endif
+    return reduce_min_f64_scalar(xs, n);
+}
+
+double reduce_max_f64(const double* xs, size_t n) {
+#ifdef REDUCE_X86
+    double r;
+    if (n >= 16 && (reduce_avx2() ? reduce_minmax_f64_avx(xs, n, 1, &r) : reduce_minmax_f64_sse2(xs, n, 1, &r))) {
+        return r;
+    }
+#endif
+    return reduce_max_f64_scalar(xs, n);
+}
@@ -0,0 +1,33 @@
+#ifndef MYCLC_REDUCE_H
+#define MYCLC_REDUCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Reduction kernels for wide numeric argument lists. On x86-64 they pick an
+// AVX2 or SSE2 implementation at run time, with a scalar fallback elsewhere.
+
+// Detects the CPU's vector extensions. Call once from main, before the
+// worker pool starts.
+void reduce_init(void);
+
+// Exact sum of xs[0..n). The vector lanes check for overflow as they go and
+// only fall back to 128-bit accumulation when a lane overflows.
+__int128 reduce_sum_i64(const int64_t* xs, size_t n);
+
+// Product of xs[0..n) into *out. Returns 0 if it does not fit in int64_t.
+int reduce_prod_i64(const int64_t* xs, size_t n, int64_t* out);
+
+// Smallest and largest of xs[0..n), n > 0
+int64_t reduce_min_i64(const int64_t* xs, size_t n);
+int64_t reduce_max_i64(const int64_t* xs, size_t n);
+
+// Double reductions. The sum and product are taken lane by lane, so they
+// can round differently from a left-to-right fold. min and max of a list
+// holding a NaN are NaN; n > 0 for them.
+double reduce_sum_f64(const double* xs, size_t n);
+double reduce_prod_f64(const double* xs, size_t n);
+double reduce_min_f64(const double* xs, size_t n);
+double reduce_max_f64(const double* xs, size_t n);
+
+#endif
@@ -0,0 +1,196 @@
+#include "arena.h"
+#include "vec.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define VEC_X86
+#include <immintrin.h>
+#endif
+
+// Set once by vec_init, before any pool thread can read it
+static int vec_has_avx2;
+
+void vec_init(void) {
+#ifdef VEC_X86
+    vec_has_avx2 = __builtin_cpu_supports("avx2");
+#endif
+}
+
+vec vec_alloc(int kind, size_t len) {
+    // Over-allocated by VEC_ALIGN so the data can start on a boundary
+    vec v = { kind, len, NULL, arena_alloc(len * 8 + VEC_ALIGN) };
+    v.data = (void*)(((uintptr_t)v.block + VEC_ALIGN - 1) & ~(uintptr_t)(VEC_ALIGN - 1));
+    return v;
+}
+
+void vec_free(vec* v) {
+    arena_free(v->block, v->len * 8 + VEC_ALIGN);
+    v->block = v->data = NULL;
+    v->len = 0;
+}
+
+static void vec_map_f64_scalar(int op, double* dst, const double* a, int as, const double* b, int bs, size_t n) {
+    switch (op)
+    {
+        case VEC_ADD: for (size_t i = 0; i < n; i++) { dst[i] = a[i * as] + b[i * bs]; } break;
+        case VEC_SUB: for (size_t i = 0; i < n; i++) { dst[i] = a[i * as] - b[i * bs]; } break;
+        case VEC_MUL: for (size_t i = 0; i < n; i++) { dst[i] = a[i * as] * b[i * bs]; } break;
+        default:      for (size_t i = 0; i < n; i++) { dst[i] = a[i * as] / b[i * bs]; } break;
+    }
+}
+
+// Operands are loaded before each store: dst may alias a, and GCC's
+// overflow builtins misreport when their result aliases an operand
+static int vec_map_i64_scalar(int op, int64_t* dst, const int64_t* a, int as, const int64_t* b, int bs, size_t n) {
+    int ok = 1;
+    for (size_t i = 0; i < n; i++) {
+        int64_t x = a[i * as], y = b[i * bs], r;
+        switch (op)
+        {
+            case VEC_ADD: ok &= !__builtin_add_overflow(x, y, &r); break;
+            case VEC_SUB: ok &= !__builtin_sub_overflow(x, y, &r); break;
+
+            // Neither AVX2 nor SSE has a 64-bit multiply with overflow detection
+            case VEC_MUL: ok &= !__builtin_mul_overflow(x, y, &r); break;
+
+            default:
+                if (y == -1) {
+                    ok &= x != INT64_MIN;
+                    r = (int64_t)(0 - (uint64_t)x);
+                } else {
+                    ok &= x % y == 0;
+                    r = x / y;
+                }
+                break;
+        }
+        dst[i] = r;
+    }
+    return ok;
+}
+
+#ifdef VEC_X86
+
+// One loop of width W per operator; a walked operand is loaded, a broadcast
+// one comes from ka or kb
+#define VEC_LOOP(W, LOAD, STORE, OP) \
+    for (; i + (W) <= n; i += (W)) { \
+        STORE(dst + i, OP(as ? LOAD(a + i) : ka, bs ? LOAD(b + i) : kb)); \
+    }
+
+__attribute__((target("avx")))
+static size_t vec_map_f64_avx(int op, double* dst, const double* a, int as, const double* b, int bs, size_t n) {
+    __m256d ka = _mm256_set1_pd(a[0]);
+    __m256d kb = _mm256_set1_pd(b[0]);
+    size_t i = 0;
+    switch (op)
+    {
+        case VEC_ADD: VEC_LOOP(4, _mm256_load_pd, _mm256_store_pd, _mm256_add_pd); break;
+        case VEC_SUB: VEC_LOOP(4, _mm256_load_pd, _mm256_store_pd, _mm256_sub_pd); break;
+        case VEC_MUL: VEC_LOOP(4, _mm256_load_pd, _mm256_store_pd, _mm256_mul_pd); break;
+        default:      VEC_LOOP(4, _mm256_load_pd, _mm256_store_pd, _mm256_div_pd); break;
+    }
+    return i;
+}
+
+static size_t vec_map_f64_sse2(int op, double* dst, const double* a, int as, const double* b, int bs, size_t n) {
+    __m128d ka = _mm_set1_pd(a[0]);
+    __m128d kb = _mm_set1_pd(b[0]);
+    size_t i = 0;
+    switch (op)
+    {
+        case VEC_ADD: VEC_LOOP(2, _mm_load_pd, _mm_store_pd, _mm_add_pd); break;
+        case VEC_SUB: VEC_LOOP(2, _mm_load_pd, _mm_store_pd, _mm_sub_pd); break;
+        case VEC_MUL: VEC_LOOP(2, _mm_load_pd, _mm_store_pd, _mm_mul_pd); break;
+        default:      VEC_LOOP(2, _mm_load_pd, _mm_store_pd, _mm_div_pd); break;
+    }
+    return i;
+}
+
+// Integer sums and differences, collecting lane overflows in ovf: a sum
+// wraps when both operands differ in sign from it, a difference when the
+// operands differ in sign and the result differs from the first
+#define VEC_ADD_OVF(x, y, s, XOR, AND) AND(XOR(x, s), XOR(y, s))
+#define VEC_SUB_OVF(x, y, s, XOR, AND) AND(XOR(x, y), XOR(x, s))
+
+#define VEC_LOOP_I64(W, T, LOAD, STORE, OP, OVF, XOR, AND, OR) \
+    for (; i + (W) <= n; i += (W)) { \
+        T x = as ? LOAD((const T*)(a + i)) : ka; \
+        T y = bs ? LOAD((const T*)(b + i)) : kb; \
+        T s = OP(x, y); \
+        ovf = OR(ovf, OVF(x, y, s, XOR, AND)); \
+        STORE((T*)(dst + i), s); \
+    }
+
+// Handles VEC_ADD and VEC_SUB, returning how many elements it did, or -1 on
+// overflow
+__attribute__((target("avx2")))
+static long vec_map_i64_avx2(int op, int64_t* dst, const int64_t* a, int as, const int64_t* b, int bs, size_t n) {
+    __m256i ka = _mm256_set1_epi64x(a[0]);
+    __m256i kb = _mm256_set1_epi64x(b[0]);
+    __m256i ovf = _mm256_setzero_si256();
+    size_t i = 0;
+    if (op == VEC_ADD) {
+        VEC_LOOP_I64(4, __m256i, _mm256_load_si256, _mm256_store_si256, _mm256_add_epi64,
+            VEC_ADD_OVF, _mm256_xor_si256, _mm256_and_si256, _mm256_or_si256);
+    } else {
+        VEC_LOOP_I64(4, __m256i, _mm256_load_si256, _mm256_store_si256, _mm256_sub_epi64,
+            VEC_SUB_OVF, _mm256_xor_si256, _mm256_and_si256, _mm256_or_si256);
+    }
+
+    // Any lane sign bit set in ovf means that lane wrapped
+    return _mm256_movemask_pd(_mm256_castsi256_pd(ovf)) != 0 ? -1 : (long)i;
+}
+
+static long vec_map_i64_sse2(int op, int64_t* dst, const int64_t* a, int as, const int64_t* b, int bs, size_t n) {
+    __m128i ka = _mm_set1_epi64x(a[0]);
+    __m128i kb = _mm_set1_epi64x(b[0]);
+    __m128i ovf = _mm_setzero_si128();
+    size_t i = 0;
+    if (op == VEC_ADD) {
+        VEC_LOOP_I64(2, __m128i, _mm_load_si128, _mm_store_si128, _mm_add_epi64,
+            VEC_ADD_OVF, _mm_xor_si128, _mm_and_si128, _mm_or_si128);
+    } else {
+        VEC_LOOP_I64(2, __m128i, _mm_load_si128, _mm_store_si128, _mm_sub_epi64,
+            VEC_SUB_OVF, _mm_xor_si128, _mm_and_si128, _mm_or_si128);
+    }
+    return _mm_movemask_pd(_mm_castsi128_pd(ovf)) != 0 ? -1 : (long)i;
+}
+
+static int vec_avx2(void) {
+    return vec_has_avx2;
+}
+
+#endif
+
+void vec_map_f64(int op, double* dst, const double* a, int as, const double* b, int bs, size_t n) {
+    size_t i = 0;
+    if (n == 0) { return; }
+#ifdef VEC_X86
+    i = vec_avx2() ? vec_map_f64_avx(op, dst, a, as, b, bs, n) : vec_map_f64_sse2(op, dst, a, as, b, bs, n);
+#endif
+    vec_map_f64_scalar(op, dst + i, a + i * as, as, b + i * bs, bs, n - i);
+}
+
+int vec_map_i64(int op, int64_t* dst, const int64_t* a, int as, const int64_t* b, int bs, size_t n) {
+    size_t i = 0;
+    if (n == 0) { return 1; }
+#ifdef VEC_X86
+    if (op == VEC_ADD || op == VEC_SUB) {
+        long done = vec_avx2() ? vec_map_i64_avx2(op, dst, a, as, b, bs, n) : vec_map_i64_sse2(op, dst, a, as, b, bs, n);
+        if (done < 0) { return 0; }
+        i = (size_t)done;
+    }
+#endif
+    return vec_map_i64_scalar(op, dst + i, a + i * as, as, b + i * bs, bs, n - i);
+}
+
+int vec_any_zero_i64(const int64_t* xs, size_t n) {
+    int zero = 0;
+    for (size_t i = 0; i < n; i++) { zero |= xs[i] == 0; }
+    return zero;
+}
+
+int vec_any_zero_f64(const double* xs, size_t n) {
+    int zero = 0;
+    for (size_t i = 0; i < n; i++) { zero |= xs[i] == 0; }
+    return zero;
+}
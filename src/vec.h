@@ -0,0 +1,45 @@
+#ifndef MYCLC_VEC_H
+#define MYCLC_VEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Contiguous numeric vectors: len elements, all int64_t or all double, in a
+// buffer aligned to VEC_ALIGN bytes. The element-wise kernels below pick an
+// AVX2/AVX or SSE2 implementation at run time on x86-64, with a scalar
+// fallback elsewhere.
+
+#define VEC_ALIGN 64
+
+enum { VEC_I64, VEC_F64 };
+enum { VEC_ADD, VEC_SUB, VEC_MUL, VEC_DIV };
+
+typedef struct vec {
+    int kind;
+    size_t len;
+    void* data;
+    void* block;
+} vec;
+
+// Detects the CPU's vector extensions. Call once from main, before the
+// worker pool starts.
+void vec_init(void);
+
+// Uninitialised vector from the evaluation arena
+vec  vec_alloc(int kind, size_t len);
+void vec_free(vec* v);
+
+// dst[i] = a[i * as] op b[i * bs] for i in [0, n), so a step of 0 broadcasts
+// a scalar and a step of 1 walks a vector. Operands walked must be
+// VEC_ALIGN-aligned; dst may be one of them.
+void vec_map_f64(int op, double* dst, const double* a, int as, const double* b, int bs, size_t n);
+
+// The same on integers. Returns 0 if any element overflows or, for VEC_DIV,
+// leaves a remainder; dst then holds garbage. Divisors must not be zero.
+int  vec_map_i64(int op, int64_t* dst, const int64_t* a, int as, const int64_t* b, int bs, size_t n);
+
+// Whether any of xs[0..n) is zero (or -0.0)
+int  vec_any_zero_i64(const int64_t* xs, size_t n);
+int  vec_any_zero_f64(const double* xs, size_t n);
+
+#endif
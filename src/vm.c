@@ -0,0 +1,785 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "intern.h"
+#include "lenv.h"
+#include "vm.h"
+
+// Bytecode is a flat array of words: an opcode followed by its operands.
+// Each chunk has a pool of constants of its own, copies of the literals,
+// symbols and unevaluated forms of the expression it was compiled from, so
+// the code never points back into a read tree and can be run again.
+//
+//   OP_CONST k            push a copy of constant k
+//   OP_VAR k              push the value bound to the symbol constant k
+//   OP_ADD argc           fold the top argc values with +, likewise SUB, MUL
+//                         and DIV; symbols among them are looked up first
+//   OP_FOLD op argc       the same with any other builtin operator
+//   OP_CALL k argc flags  call what the symbol constant k is bound to with
+//                         the top argc values
+//   OP_APPLY n flags      apply the top n values, the first being what is
+//                         applied, as the tree walker would
+//   OP_BRANCH else end    pop a condition: carry on if it is true, jump to
+//                         else if it is zero, and to end with an error in
+//                         its place if it is not a number
+//   OP_JUMP to
+//   OP_EVAL k             push constant k evaluated by the tree walker, for
+//                         lambdas and malformed special forms
+//   OP_RETURN             the value on top is the chunk's result
+//
+// Symbol operands of a builtin are looked up by OP_VAR as they are pushed
+// when nothing after them can def; otherwise they are pushed as they are and
+// looked up with the rest once every operand is in, as the tree walker does.
+enum { OP_CONST, OP_VAR, OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_FOLD, OP_CALL, OP_APPLY,
+       OP_BRANCH, OP_JUMP, OP_EVAL, OP_RETURN };
+
+// Flags of OP_CALL and OP_APPLY: a call in tail position reuses the frame it
+// is made from, and a lone Function on a line of its own is shown, not called
+enum { VM_TAIL = 1, VM_LINE = 2 };
+
+// GCC and Clang can jump straight to the next handler (computed goto)
+#if defined(__GNUC__)
+#define VM_THREADED
+#endif
+
+// Compiled expressions are kept, keyed by their serialized tree, until the
+// keys of those cached add up to VM_CACHE_BYTES; the cache is then emptied
+// before the next line. Expressions whose key would pass VM_KEY_MAX are left
+// to the tree walker.
+#define VM_KEY_MAX     (1 << 20)
+#define VM_CACHE_BYTES (16 << 20)
+
+typedef struct vm_chunk {
+    uint64_t hash;
+    int key_len;
+    unsigned char* key;
+    intptr_t* code;
+    int count;
+    int capacity;
+    lval** consts;
+    int const_count;
+    int const_capacity;
+    int depth;
+    int max_depth;
+} vm_chunk;
+
+// Open-addressing table of chunks by hash, with the arena their constants
+// live in, which outlives the evaluation arena's reset after each line
+static vm_chunk** table;
+static unsigned table_mask;
+static int table_count;
+static size_t table_bytes;
+static arena consts_arena;
+
+// Chunks for the bodies of global Functions, by the address of the body in
+// the globals, good while the globals are unchanged. It saves serializing
+// the body again on every call.
+#define VM_FN_CACHE 64
+typedef struct { lval* body; unsigned version; vm_chunk* chunk; } vm_fn_entry;
+static vm_fn_entry fn_cache[VM_FN_CACHE];
+
+static void vm_flush(void) {
+    for (unsigned i = 0; table != NULL && i <= table_mask; i++) {
+        vm_chunk* c = table[i];
+        if (c == NULL) { continue; }
+        free(c->key);
+        free(c->code);
+        free(c->consts);
+        free(c);
+        table[i] = NULL;
+    }
+    table_count = 0;
+    table_bytes = 0;
+    memset(fn_cache, 0, sizeof(fn_cache));
+
+    arena* prev = arena_use(&consts_arena);
+    arena_reset();
+    arena_use(prev);
+}
+
+// Serialized tree being looked up, shared by every key built
+static unsigned char* key;
+static int key_len;
+static int key_capacity;
+
+static int vm_key_put(const void* p, size_t n) {
+    if (key_len + n > VM_KEY_MAX) { return 0; }
+    while (key_len + (int)n > key_capacity) {
+        key_capacity = key_capacity ? key_capacity * 2 : 4096;
+        key = realloc(key, key_capacity);
+        if (key == NULL) { abort(); }
+    }
+    memcpy(key + key_len, p, n);
+    key_len += n;
+    return 1;
+}
+
+static int vm_key_tag(char tag) { return vm_key_put(&tag, 1); }
+
+static int vm_key_big(const bigint* x) {
+    return vm_key_put(&x->neg, sizeof(int)) && vm_key_put(&x->len, sizeof(int)) &&
+           vm_key_put(x->d, sizeof(uint64_t) * x->len);
+}
+
+// Appends v itself, not its cells, to the key. Returns 0 for values no read
+// tree holds, or once the key is too long.
+static int vm_key_one(lval* v) {
+    long num;
+    size_t len;
+
+    switch (lval_type(v))
+    {
+        case LVAL_NUM:
+            num = lval_num_val(v);
+            return vm_key_tag('n') && vm_key_put(&num, sizeof(long));
+
+        case LVAL_BIG: return vm_key_tag('b') && vm_key_big(&v->big);
+        case LVAL_RAT: return vm_key_tag('r') && vm_key_big(&v->big) && vm_key_big(&v->den);
+        case LVAL_DEC: return vm_key_tag('m') && vm_key_put(&v->dec, sizeof(__int128));
+        case LVAL_DBL: return vm_key_tag('d') && vm_key_put(&v->dbl, sizeof(double));
+
+        case LVAL_MPF:
+            return vm_key_tag('f') && vm_key_put(&v->mpf.prec, sizeof(int)) &&
+                   vm_key_put(&v->mpf.e, sizeof(int64_t)) && vm_key_big(&v->mpf.m);
+
+        case LVAL_VEC:
+            return vm_key_tag('v') && vm_key_put(&v->vec.kind, sizeof(int)) &&
+                   vm_key_put(&v->vec.len, sizeof(size_t)) && vm_key_put(v->vec.data, v->vec.len * 8);
+
+        case LVAL_MAT:
+            return vm_key_tag('M') && vm_key_put(&v->mat.rows, sizeof(size_t)) &&
+                   vm_key_put(&v->mat.cols, sizeof(size_t)) &&
+                   vm_key_put(v->mat.data, v->mat.rows * v->mat.cols * 8);
+
+        case LVAL_ERR:
+            len = strlen(v->err);
+            return vm_key_tag('e') && vm_key_put(&len, sizeof(size_t)) && vm_key_put(v->err, len);
+
+        case LVAL_SYM:
+            return vm_key_tag('s') && vm_key_put(&v->sym, sizeof(int));
+
+        case LVAL_SEXPR:
+            return vm_key_tag('(') && vm_key_put(&v->count, sizeof(int));
+
+        default:
+            return 0;
+    }
+}
+
+// Preorder serialization of v into key, led by tag, with a work stack in
+// place of recursion
+static int vm_key_build(lval* v, char tag) {
+    static lval** todo;
+    static int capacity;
+    int count = 0;
+
+    key_len = 0;
+    if (!vm_key_tag(tag)) { return 0; }
+    todo = stack_reserve(todo, count, &capacity, sizeof(lval*));
+    todo[count++] = v;
+
+    while (count > 0) {
+        v = todo[--count];
+        if (!vm_key_one(v)) { return 0; }
+        if (lval_type(v) != LVAL_SEXPR) { continue; }
+        for (int i = v->count - 1; i >= 0; i--) {
+            todo = stack_reserve(todo, count, &capacity, sizeof(lval*));
+            todo[count++] = v->cell[i];
+        }
+    }
+    return 1;
+}
+
+// FNV-1a, 64-bit
+static uint64_t vm_hash(const unsigned char* p, int len) {
+    uint64_t h = 14695981039346656037ull;
+    for (int i = 0; i < len; i++) { h = (h ^ p[i]) * 1099511628211ull; }
+    return h;
+}
+
+// Slot of the chunk for the current key, or the empty slot where it would go
+static unsigned vm_slot(uint64_t hash) {
+    unsigned i = (unsigned)hash & table_mask;
+    while (table[i] != NULL) {
+        vm_chunk* c = table[i];
+        if (c->hash == hash && c->key_len == key_len && memcmp(c->key, key, key_len) == 0) { break; }
+        i = (i + 1) & table_mask;
+    }
+    return i;
+}
+
+static void vm_grow(void) {
+    vm_chunk** old = table;
+    unsigned old_size = old != NULL ? table_mask + 1 : 0;
+    unsigned size = old_size ? old_size * 2 : 256;
+
+    table = calloc(size, sizeof(vm_chunk*));
+    if (table == NULL) { abort(); }
+    table_mask = size - 1;
+    for (unsigned j = 0; j < old_size; j++) {
+        if (old[j] == NULL) { continue; }
+        unsigned i = (unsigned)old[j]->hash & table_mask;
+        while (table[i] != NULL) { i = (i + 1) & table_mask; }
+        table[i] = old[j];
+    }
+    free(old);
+}
+
+static void vm_emit(vm_chunk* c, intptr_t w) {
+    c->code = stack_reserve(c->code, c->count, &c->capacity, sizeof(intptr_t));
+    c->code[c->count++] = w;
+}
+
+static void vm_push_depth(vm_chunk* c, int n) {
+    c->depth += n;
+    if (c->depth > c->max_depth) { c->max_depth = c->depth; }
+}
+
+// Adds a copy of x, made in the chunks' own arena, to the constant pool
+static int vm_const(vm_chunk* c, lval* x) {
+    c->consts = stack_reserve(c->consts, c->const_count, &c->const_capacity, sizeof(lval*));
+    arena* prev = arena_use(&consts_arena);
+    c->consts[c->const_count] = lval_copy(x);
+    arena_use(prev);
+    return c->const_count++;
+}
+
+static void vm_emit_const(vm_chunk* c, int op, lval* x) {
+    vm_emit(c, op);
+    vm_emit(c, vm_const(c, x));
+    vm_push_depth(c, 1);
+}
+
+// Whether the builtin op may run a Function, which could def: the
+// reductions and pmap draw values from Sequences, whose stages are Functions
+static int vm_calls_back(int op) {
+    return (op >= SYM_SUM && op <= SYM_MAX) || op == SYM_REDUCE || op == SYM_FOLD ||
+           op == SYM_PMAP || op == SYM_PREDUCE;
+}
+
+// Compiles v, operands before operators, with an explicit frame per open
+// S-Expression rather than recursion. A call frame compiles the children of
+// an application from first, then emits op; an if frame compiles its
+// condition, then its branches (at stage 1 and 2), patching the jumps
+// between them. pure is cleared once anything in the frame could def, and
+// impure_at is the last child of a call found so.
+static void vm_compile(vm_chunk* c, lval* v, int line) {
+    typedef struct {
+        lval* v;
+        int is_if;
+        int i;
+        int op;
+        int sym;
+        int flags;
+        int pure;
+        int impure_at;
+        int syms;
+        int at;
+        int depth;
+    } compile_frame;
+    static compile_frame* frames;
+    static int capacity;
+    int top = 0;
+
+    // Symbol operands of the open calls: where each was emitted and which
+    // child it is
+    typedef struct { int at; int child; } sym_operand;
+    static sym_operand* syms;
+    static int syms_capacity;
+    int sym_count = 0;
+
+    // e is the next expression to start; operand is set for a child of a
+    // call, whose symbols are looked up along with the others
+    lval* e = v;
+    int operand = 0;
+    int flags = VM_TAIL | (line ? VM_LINE : 0);
+
+    while (1) {
+        int done = 0, pure = 1;
+
+        if (e != NULL) {
+            int head = lval_type(e) == LVAL_SEXPR && e->count > 0 && lval_type(e->cell[0]) == LVAL_SYM
+                     ? e->cell[0]->sym : -1;
+
+            if (lval_type(e) != LVAL_SEXPR || e->count == 0) {
+                // Builtin names stand for themselves
+                int bound = lval_type(e) == LVAL_SYM && e->sym >= SYM_BUILTIN_COUNT;
+                if (bound && operand) {
+                    syms = stack_reserve(syms, sym_count, &syms_capacity, sizeof(sym_operand));
+                    syms[sym_count++] = (sym_operand){ c->count, frames[top - 1].i - 1 };
+                }
+                vm_emit_const(c, bound && !operand ? OP_VAR : OP_CONST, e);
+                done = 1;
+            } else if (head == SYM_BACKSLASH || head == SYM_LAMBDA || (head == SYM_IF && e->count != 4)) {
+                vm_emit_const(c, OP_EVAL, e);
+                pure = head != SYM_IF;
+                done = 1;
+            } else if (head >= 0 && head < SYM_DEF && e->count == 1) {
+                // (+) is just the operator
+                vm_emit_const(c, OP_CONST, e->cell[0]);
+                done = 1;
+            } else {
+                frames = stack_reserve(frames, top, &capacity, sizeof(compile_frame));
+                compile_frame* f = &frames[top++];
+                *f = (compile_frame){ e, head == SYM_IF, 1, OP_APPLY, head, flags, 1, -1, sym_count, 0, 0 };
+                if (f->is_if) {
+                    f->i = 0;
+                } else if (head >= 0 && head < SYM_DEF) {
+                    f->op = head == SYM_ADD ? OP_ADD : head == SYM_SUB ? OP_SUB : head == SYM_MUL ? OP_MUL
+                          : head == SYM_DIV ? OP_DIV : OP_FOLD;
+                    f->pure = !vm_calls_back(head);
+                } else if (head >= SYM_BUILTIN_COUNT) {
+                    f->op = OP_CALL;
+                    f->pure = 0;
+                } else {
+                    // def, and anything not headed by a symbol, is applied
+                    // by the tree walker's own code
+                    f->i = 0;
+                    f->pure = 0;
+                }
+            }
+            e = NULL;
+        } else {
+            compile_frame* f = &frames[top - 1];
+            if (f->is_if) {
+                switch (f->i++)
+                {
+                    // The condition, looked up if a symbol
+                    case 0:
+                        e = f->v->cell[1];
+                        operand = 0;
+                        flags = 0;
+                        continue;
+
+                    case 1:
+                        vm_emit(c, OP_BRANCH);
+                        f->at = c->count;
+                        vm_emit(c, 0);
+                        vm_emit(c, 0);
+                        vm_push_depth(c, -1);
+                        f->depth = c->depth;
+                        e = f->v->cell[2];
+                        operand = 0;
+                        flags = f->flags & VM_TAIL;
+                        continue;
+
+                    case 2:
+                        vm_emit(c, OP_JUMP);
+                        vm_emit(c, 0);
+                        c->code[f->at] = c->count;
+                        c->depth = f->depth;
+                        e = f->v->cell[3];
+                        operand = 0;
+                        flags = f->flags & VM_TAIL;
+                        continue;
+
+                    default:
+                        c->code[f->at + 1] = c->count;
+                        c->code[c->code[f->at] - 1] = c->count;
+                        pure = f->pure;
+                        top--;
+                        done = 1;
+                        break;
+                }
+            } else if (f->i < f->v->count) {
+                e = f->v->cell[f->i++];
+                operand = 1;
+                flags = 0;
+                continue;
+            } else {
+                int argc = f->v->count - 1;
+                switch (f->op)
+                {
+                    case OP_APPLY:
+                        vm_emit(c, OP_APPLY);
+                        vm_emit(c, f->v->count);
+                        vm_emit(c, f->flags);
+                        vm_push_depth(c, 1 - f->v->count);
+                        break;
+
+                    case OP_CALL:
+                        vm_emit(c, OP_CALL);
+                        vm_emit(c, vm_const(c, f->v->cell[0]));
+                        vm_emit(c, argc);
+                        vm_emit(c, f->flags);
+                        vm_push_depth(c, 1 - argc);
+                        break;
+
+                    default:
+                        // Symbols with nothing after them that could def are
+                        // looked up as they are pushed
+                        for (int s = f->syms; s < sym_count; s++) {
+                            if (syms[s].child > f->impure_at) { c->code[syms[s].at] = OP_VAR; }
+                        }
+                        vm_emit(c, f->op);
+                        if (f->op == OP_FOLD) { vm_emit(c, f->sym); }
+                        vm_emit(c, argc);
+                        vm_push_depth(c, 1 - argc);
+                        break;
+                }
+                sym_count = f->syms;
+                pure = f->pure;
+                top--;
+                done = 1;
+            }
+        }
+
+        if (!done) { continue; }
+        if (top == 0) { break; }
+
+        // Tell the enclosing frame what its child turned out to be
+        compile_frame* f = &frames[top - 1];
+        if (!pure) {
+            f->pure = 0;
+            if (!f->is_if) { f->impure_at = f->i - 1; }
+        }
+    }
+
+    vm_emit(c, OP_RETURN);
+}
+
+// Chunk for the expression v, compiled now if it has not been already. tag
+// tells a whole line from the body of a Function, which compile apart. NULL
+// if v is too large to cache.
+static vm_chunk* vm_chunk_for(lval* v, char tag) {
+    if (!vm_key_build(v, tag)) { return NULL; }
+    uint64_t hash = vm_hash(key, key_len);
+    if (table == NULL) { vm_grow(); }
+    unsigned i = vm_slot(hash);
+    if (table[i] != NULL) { return table[i]; }
+
+    vm_chunk* c = calloc(1, sizeof(vm_chunk));
+    if (c == NULL) { abort(); }
+    c->hash = hash;
+    c->key_len = key_len;
+    c->key = malloc(key_len);
+    if (c->key == NULL) { abort(); }
+    memcpy(c->key, key, key_len);
+    vm_compile(c, v, tag == 'L');
+
+    table[i] = c;
+    table_bytes += key_len + sizeof(intptr_t) * c->count;
+    if (++table_count * 2 > (int)table_mask + 1) { vm_grow(); }
+    return c;
+}
+
+// Chunk for the body of a Function that lives in the globals
+static vm_chunk* vm_chunk_for_global(lval* body) {
+    vm_fn_entry* e = &fn_cache[((uintptr_t)body >> 4) % VM_FN_CACHE];
+    if (e->body == body && e->version == globals.version && e->chunk != NULL) { return e->chunk; }
+    *e = (vm_fn_entry){ body, globals.version, vm_chunk_for(body, 'B') };
+    return e->chunk;
+}
+
+// Value stack and call frames, reused across lines
+typedef struct { vm_chunk* chunk; intptr_t* ip; lval* env; int owns; } vm_frame;
+static lval** stack;
+static int stack_size;
+static vm_frame* frames;
+static int frames_capacity;
+
+// Makes room for n more values above sp, returning sp in the moved stack
+static lval** vm_reserve(lval** sp, int n) {
+    int used = stack != NULL ? (int)(sp - stack) : 0;
+    if (used + n > stack_size) {
+        while (used + n > stack_size) { stack_size = stack_size ? stack_size * 2 : 256; }
+        stack = realloc(stack, sizeof(lval*) * stack_size);
+        if (stack == NULL) { abort(); }
+    }
+    return stack + used;
+}
+
+// Looks up the symbols among args[0..n), as lval_eval_sexpr does once the
+// children of an S-Expression are evaluated
+static void vm_lookup(lval** args, int n, lval* env) {
+    for (int i = 0; i < n; i++) {
+        if (lval_type(args[i]) == LVAL_SYM) { args[i] = lval_lookup(args[i], env); }
+    }
+}
+
+// Deletes args[0..n) but for the leftmost error, which is returned; NULL if
+// there is none, leaving them be
+static lval* vm_first_error(lval** args, int n) {
+    int i = 0;
+    while (i < n && lval_type(args[i]) != LVAL_ERR) { i++; }
+    if (i == n) { return NULL; }
+
+    lval* err = args[i];
+    for (int j = 0; j < n; j++) {
+        if (j != i) { lval_del(args[j]); }
+    }
+    return err;
+}
+
+// Replaces the top argc stack values with op applied to them. Like
+// lval_eval_sexpr, the leftmost error among the arguments wins.
+static lval** vm_apply(int op, lval** sp, int argc, lval* env) {
+    lval** args = sp - argc;
+    vm_lookup(args, argc, env);
+
+    lval* r = vm_first_error(args, argc);
+    if (r == NULL) {
+        r = lval_fold(op, args, argc);
+        for (int i = 0; i < argc; i++) { lval_del(args[i]); }
+    }
+    args[0] = r;
+    return args + 1;
+}
+
+// S-Expression of args[0..n), taking them over
+static lval* vm_sexpr(lval** args, int n) {
+    lval* v = lval_sexpr();
+    for (int i = 0; i < n; i++) { lval_add(v, args[i]); }
+    return v;
+}
+
+// Copy of the value bound to sym, as lval_lookup gives, without making a
+// Symbol to look up
+static lval* vm_var(lval* sym, lval* env) {
+    for (int i = 0; env != NULL && i < env->count; i += 2) {
+        if (env->cell[i]->sym == sym->sym) { return lval_copy(env->cell[i + 1]); }
+    }
+    lval* x = lenv_get(&globals, sym->sym);
+    return x != NULL ? lval_copy(x) : lval_lookup(lval_copy(sym), env);
+}
+
+// Function bound to sym among the local bindings in env, or else the
+// globals, still theirs; NULL if it is bound to anything else. *global is
+// set if it is one of the globals.
+static lval* vm_function(int sym, lval* env, int* global) {
+    lval* f = NULL;
+    *global = 0;
+    for (int i = 0; env != NULL && i < env->count; i += 2) {
+        if (env->cell[i]->sym == sym) {
+            f = env->cell[i + 1];
+            break;
+        }
+    }
+    if (f == NULL) {
+        f = lenv_get(&globals, sym);
+        *global = 1;
+    }
+    return f != NULL && lval_type(f) == LVAL_FUN ? f : NULL;
+}
+
+// Runs chunk c in the local bindings env, which stay the caller's
+static lval* vm_run(vm_chunk* c, lval* env) {
+#ifdef VM_THREADED
+    static void* labels[] = { &&L_OP_CONST, &&L_OP_VAR, &&L_OP_ADD, &&L_OP_SUB, &&L_OP_MUL,
+                              &&L_OP_DIV, &&L_OP_FOLD, &&L_OP_CALL, &&L_OP_APPLY, &&L_OP_BRANCH,
+                              &&L_OP_JUMP, &&L_OP_EVAL, &&L_OP_RETURN };
+#define VM_CASE(op) L_##op:
+#define VM_NEXT     goto *labels[*ip++]
+#else
+#define VM_CASE(op) case op:
+#define VM_NEXT     break
+#endif
+
+    int top = 0;
+    frames = stack_reserve(frames, top, &frames_capacity, sizeof(vm_frame));
+    frames[top++] = (vm_frame){ c, c->code, env, 0 };
+    lval** sp = vm_reserve(stack, c->max_depth);
+    intptr_t* ip = c->code;
+    lval** consts = c->consts;
+
+    // What a call leaves to run: the body of a Function in its bindings,
+    // which are ours, and the flags of the call. body is ours unless
+    // borrowed is set.
+    lval* body;
+    lval* call_env;
+    int call_flags, borrowed, global;
+
+#ifdef VM_THREADED
+    VM_NEXT;
+#else
+    for (;;) switch (*ip++)
+#endif
+    {
+        VM_CASE(OP_CONST)
+            *sp++ = lval_copy(consts[*ip++]);
+            VM_NEXT;
+
+        VM_CASE(OP_VAR)
+            *sp++ = vm_var(consts[*ip++], env);
+            VM_NEXT;
+
+        VM_CASE(OP_ADD) sp = vm_apply(SYM_ADD, sp, (int)*ip++, env); VM_NEXT;
+        VM_CASE(OP_SUB) sp = vm_apply(SYM_SUB, sp, (int)*ip++, env); VM_NEXT;
+        VM_CASE(OP_MUL) sp = vm_apply(SYM_MUL, sp, (int)*ip++, env); VM_NEXT;
+        VM_CASE(OP_DIV) sp = vm_apply(SYM_DIV, sp, (int)*ip++, env); VM_NEXT;
+
+        VM_CASE(OP_FOLD)
+        {
+            int op = (int)*ip++;
+            sp = vm_apply(op, sp, (int)*ip++, env);
+            VM_NEXT;
+        }
+
+        // A Function is called here, without copying it out of the bindings;
+        // anything else goes the tree walker's way
+        VM_CASE(OP_CALL)
+        {
+            lval* name = consts[*ip++];
+            int argc = (int)*ip++;
+            call_flags = (int)*ip++;
+            lval** args = sp - argc;
+            sp = args;
+
+            lval* f = vm_function(name->sym, env, &global);
+            if (f == NULL || (argc == 0 && (call_flags & VM_LINE))) {
+                lval* v = lval_add(lval_sexpr(), lval_copy(name));
+                for (int i = 0; i < argc; i++) { lval_add(v, args[i]); }
+                call_env = NULL;
+                body = lval_eval_sexpr(v, env, &call_env, call_flags & VM_LINE);
+                borrowed = global = 0;
+                if (call_env == NULL) {
+                    *sp++ = body;
+                    VM_NEXT;
+                }
+                goto call;
+            }
+
+            vm_lookup(args, argc, env);
+            lval* err = vm_first_error(args, argc);
+            if (err != NULL) {
+                *sp++ = err;
+                VM_NEXT;
+            }
+
+            lval* formals = f->cell[LVAL_FUN_FORMALS];
+            if (formals->count != argc) {
+                char message[96];
+                snprintf(message, sizeof(message), "Function takes %i arguments, got %i!", formals->count, argc);
+                for (int i = 0; i < argc; i++) { lval_del(args[i]); }
+                *sp++ = lval_err(message);
+                VM_NEXT;
+            }
+
+            call_env = lval_copy(f->cell[LVAL_FUN_ENV]);
+            for (int i = 0; i < argc; i++) { lval_env_put(call_env, lval_sym_id(formals->cell[i]->sym), args[i]); }
+            body = f->cell[LVAL_FUN_BODY];
+            borrowed = 1;
+            goto call;
+        }
+
+        VM_CASE(OP_APPLY)
+        {
+            int n = (int)*ip++;
+            call_flags = (int)*ip++;
+            lval** args = sp - n;
+            sp = args;
+
+            // A lone value is itself unless it is a Function to call
+            if (n == 1) {
+                lval* x = lval_lookup(args[0], env);
+                if (lval_type(x) != LVAL_FUN || (call_flags & VM_LINE)) {
+                    *sp++ = x;
+                    VM_NEXT;
+                }
+                args[0] = x;
+            }
+
+            lval* v = vm_sexpr(args, n);
+            call_env = NULL;
+            body = lval_eval_sexpr(v, env, &call_env, call_flags & VM_LINE);
+            borrowed = global = 0;
+            if (call_env == NULL) {
+                *sp++ = body;
+                VM_NEXT;
+            }
+            goto call;
+        }
+
+        VM_CASE(OP_BRANCH)
+        {
+            lval* cond = *--sp;
+            intptr_t to_else = *ip++, to_end = *ip++;
+            if (lval_type(cond) == LVAL_ERR) {
+                *sp++ = cond;
+                ip = c->code + to_end;
+            } else if (lval_type(cond) > LVAL_MPF) {
+                lval_del(cond);
+                *sp++ = lval_err("if takes a number as its condition!");
+                ip = c->code + to_end;
+            } else {
+                if (lval_sign(cond) == 0) { ip = c->code + to_else; }
+                lval_del(cond);
+            }
+            VM_NEXT;
+        }
+
+        VM_CASE(OP_JUMP)
+            ip = c->code + *ip;
+            VM_NEXT;
+
+        VM_CASE(OP_EVAL)
+            *sp++ = lval_eval_in(lval_copy(consts[*ip++]), env);
+            VM_NEXT;
+
+        VM_CASE(OP_RETURN)
+        {
+            vm_frame* f = &frames[--top];
+            if (f->owns) { lval_del(f->env); }
+            if (top == 0) { return *--sp; }
+
+            f = &frames[top - 1];
+            c = f->chunk;
+            ip = f->ip;
+            env = f->env;
+            consts = c->consts;
+            VM_NEXT;
+        }
+
+    // The body of a Function runs in a frame of its own, or in place of the
+    // caller's for a tail call, once its chunk is found
+    call:
+    {
+        vm_chunk* next = NULL;
+        if (lval_type(body) == LVAL_SEXPR) {
+            next = global ? vm_chunk_for_global(body) : vm_chunk_for(body, 'B');
+        }
+
+        if (next == NULL) {
+            if (borrowed) { body = lval_copy(body); }
+            *sp++ = lval_type(body) == LVAL_SEXPR ? lval_eval_in(body, call_env) : lval_lookup(body, call_env);
+            lval_del(call_env);
+            VM_NEXT;
+        }
+        if (!borrowed) { lval_del(body); }
+
+        if (call_flags & VM_TAIL) {
+            vm_frame* f = &frames[top - 1];
+            if (f->owns) { lval_del(f->env); }
+            f->chunk = next;
+            f->env = call_env;
+            f->owns = 1;
+        } else {
+            frames[top - 1].ip = ip;
+            frames = stack_reserve(frames, top, &frames_capacity, sizeof(vm_frame));
+            frames[top++] = (vm_frame){ next, next->code, call_env, 1 };
+        }
+        c = next;
+        ip = c->code;
+        env = call_env;
+        consts = c->consts;
+        sp = vm_reserve(sp, c->max_depth);
+        VM_NEXT;
+    }
+    }
+#undef VM_CASE
+#undef VM_NEXT
+}
+
+lval* vm_eval(lval* v) {
+    if (lval_type(v) != LVAL_SEXPR) { return v; }
+    if (table_bytes > VM_CACHE_BYTES) { vm_flush(); }
+
+    vm_chunk* c = vm_chunk_for(v, 'L');
+    if (c == NULL) { return lval_eval(v); }
+
+    // The chunk has its own copies of everything it needs from the tree
+    lval_del(v);
+    return vm_run(c, NULL);
+}
@@ -0,0 +1,15 @@
+#ifndef MYCLC_VM_H
+#define MYCLC_VM_H
+
+#include "lval.h"
+
+// Evaluation engines selectable with --engine=
+enum { ENGINE_TREE, ENGINE_VM };
+
+// Runs the read tree v on the stack VM, compiling it to bytecode the first
+// time it is seen; the bodies of Functions it calls are compiled and kept the
+// same way. Trees too large to keep fall back to lval_eval. Consumes v like
+// lval_eval.
+lval* vm_eval(lval* v);
+
+#endif
@@ -0,0 +1,73 @@
+#!/bin/sh
+# Under (precision N) floats must be rounded to N bits and print with the
+# fewest digits that read back at N bits. Each expected value below was
+# checked against the exact result rounded half to even at that precision.
+# Non-integer powers have no multi-precision exp or log behind them and
+# must fail rather than quietly drop to a double.
+#
+# usage: sh tests/bigfloats.sh [path/to/myclc]
+
+MYCLC=${1:-./myclc}
+. "$(dirname "$0")/lib.sh"
+status=0
+
+out=$("$MYCLC" <<'END' | grep '^>> .'
+(precision 100)
+(+ 0.1 0.2)
+(/ 1.0 3)
+(* 1.5 2)
+(- 1.0 1e-25)
+(+ 1.0 (/ 1 3))
+(^ 2.0 100)
+(^ 2.0 -3)
+(^ 1.1 100)
+(% 10.5 3)
+(/ 1.0 0)
+(^ 2.0 0.5)
+(^ 2.0 (/ 1 2))
+(^ 2 1.5)
+(^ 2.0 1.50m)
+(^ 2.0 2.00m)
+(precision 1)
+(precision 65537)
+(precision 53)
+(+ 0.1 0.2)
+(^ 2.0 0.5)
+END
+)
+
+want=$(cat <<'END'
+>> 100
+>> 0.3
+>> 0.3333333333333333333333333333335
+>> 3.0
+>> 0.9999999999999999999999999
+>> 1.333333333333333333333333333334
+>> 1.267650600228229401496703205376e30
+>> 0.125
+>> 13780.61233982227018411833717249
+>> 1.5
+>> Error: Cannot divide by zero!
+>> Error: Non-integer powers need (precision 53)!
+>> Error: Non-integer powers need (precision 53)!
+>> Error: Non-integer powers need (precision 53)!
+>> Error: Non-integer powers need (precision 53)!
+>> 4.0
+>> Error: precision takes a bit count from 2 to 65536!
+>> Error: precision takes a bit count from 2 to 65536!
+>> 53
+>> 0.30000000000000004
+>> 1.4142135623730951
+END
+)
+
+check bigfloats "$out" "$want" || status=1
+
+want=">> 0.1428571428571428571428571428571428571428571428571428571428571"
+if ! echo '(/ 1.0 7)' | "$MYCLC" --precision=200 | grep -qx -- "$want"; then
+    echo "bigfloats: expected '$want' under --precision=200" >&2
+    status=1
+fi
+
+[ $status -eq 0 ] && echo "bigfloats: ok"
+exit $status
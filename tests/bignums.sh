@@ -0,0 +1,63 @@
+#!/bin/sh
+# Integers that overflow int64_t must promote to bignums, print exactly and
+# come back down when they fit again. The identities at the end multiply
+# operands big enough for the Karatsuba and Toom-3 paths and compare the
+# products by another route.
+#
+# usage: sh tests/bignums.sh [path/to/myclc]
+
+MYCLC=${1:-./myclc}
+. "$(dirname "$0")/lib.sh"
+
+out=$("$MYCLC" <<'END' | grep '^>> .'
+(+ 9223372036854775807 1)
+(- -9223372036854775807 2)
+(* 4611686018427387904 2)
+(* -1 -9223372036854775808)
+(- 9223372036854775808 1)
+(== (- 9223372036854775808 1) 9223372036854775807)
+123456789012345678901234567890
+-123456789012345678901234567890
+(* 99999999999 99999999999 99999999999)
+(^ 2 200)
+(fold * 1 (map (\ (x) (+ x 1)) (range 30)))
+(% (^ 10 40) 7)
+(- (^ 2 64) (^ 2 64))
+(sum [9223372036854775807 9223372036854775807])
+(+ 9223372036854775807 9223372036854775807 9223372036854775807 -9223372036854775807)
+(def squares (\ (a b) (== (* (+ a b) (- a b)) (- (* a a) (* b b)))))
+(squares (+ (^ 3 2000) 1) (^ 7 1000))
+(squares (+ (^ 3 20000) 12345) (- (^ 7 9000) 1))
+(== (* (^ 3 50000) (^ 3 50000)) (^ 9 50000))
+(== (* (^ 5 300) (^ 5 40000)) (^ 5 40300))
+(% (* (^ 3 20000) (^ 7 9000)) 1000000007)
+END
+)
+
+want=$(cat <<'END'
+>> 9223372036854775808
+>> -9223372036854775809
+>> 9223372036854775808
+>> 9223372036854775808
+>> 9223372036854775807
+>> 1
+>> 123456789012345678901234567890
+>> -123456789012345678901234567890
+>> 999999999970000000000299999999999
+>> 1606938044258990275541962092341162602522202993782792835301376
+>> 265252859812191058636308480000000
+>> 4
+>> 0
+>> 18446744073709551614
+>> 18446744073709551614
+>> (\ (a b) (== (* (+ a b) (- a b)) (- (* a a) (* b b))))
+>> 1
+>> 1
+>> 1
+>> 1
+>> 81002651
+END
+)
+
+check bignums "$out" "$want" || exit 1
+echo "bignums: ok"
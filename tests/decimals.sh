@@ -0,0 +1,75 @@
+#!/bin/sh
+# Decimals must stay exact to --scale places, and each --round mode must
+# round halves and other remainders its own way, on both signs, in
+# literals, products and quotients.
+#
+# usage: sh tests/decimals.sh [path/to/myclc]
+
+MYCLC=${1:-./myclc}
+status=0
+
+# Prints the results of the lines on stdin on one line, under the given flags
+results() {
+    "$MYCLC" "$@" | grep '^>> .' | sed 's/^>> //' | tr '\n' ' ' | sed 's/ $//'
+}
+
+check() {
+    name=$1
+    want=$2
+    got=$3
+    if [ "$got" != "$want" ]; then
+        echo "decimals: $name: expected '$want'" >&2
+        echo "decimals: $name:      got '$got'" >&2
+        status=1
+    fi
+}
+
+got=$(results <<'END'
+12.50m
+(+ 0.10m 0.20m)
+(- 1.00m 0.01m)
+(- 0.00m 1.25m)
+(* 19.99m 3)
+(* 2.50m 2.50m)
+(/ 5.00m 0)
+(+ 1.50m 1)
+(+ 1.50m 0.25)
+(< 1.50m 1.51m)
+(== 1.50m 1.5m)
+99999999999999999999999999999999.99m
+(* 99999999999999999999999999999999.99m 10)
+(* 99999999999999999999999999999999.99m 100000)
+END
+)
+check exact "12.50 0.30 0.99 -1.25 59.97 6.25 Error: Cannot divide by zero! 2.50 1.75 1 1 \
+99999999999999999999999999999999.99 999999999999999999999999999999999.90 Error: Decimal overflow!" "$got"
+
+# 1.375, 0.115, 10/3, 2/3, -2/3, 0.125, 0.375, -0.375, 1.005 and -0.025
+rounding='(* 1.25m 1.10m)
+(* 1.15m 0.10m)
+(/ 10.00m 3)
+(/ 2.00m 3)
+(/ -2.00m 3)
+(/ 1.00m 8)
+(/ 3.00m 8)
+(/ -3.00m 8)
+(+ 1.005m 0)
+(* -0.05m 0.5m)'
+
+while read -r mode want; do
+    check "--round=$mode" "$want" "$(printf '%s\n' "$rounding" | results --round=$mode)"
+done <<'END'
+half-even 1.38 0.12 3.33 0.67 -0.67 0.12 0.38 -0.38 1.00 -0.02
+half-up 1.38 0.12 3.33 0.67 -0.67 0.13 0.38 -0.38 1.01 -0.03
+half-down 1.37 0.11 3.33 0.67 -0.67 0.12 0.37 -0.37 1.00 -0.02
+down 1.37 0.11 3.33 0.66 -0.66 0.12 0.37 -0.37 1.00 -0.02
+up 1.38 0.12 3.34 0.67 -0.67 0.13 0.38 -0.38 1.01 -0.03
+floor 1.37 0.11 3.33 0.66 -0.67 0.12 0.37 -0.38 1.00 -0.03
+ceiling 1.38 0.12 3.34 0.67 -0.66 0.13 0.38 -0.37 1.01 -0.02
+END
+
+check "--scale=4" "1.3750 0.1150 3.3333 0.6667 -0.6667 0.1250 0.3750 -0.3750 1.0050 -0.0250" \
+    "$(printf '%s\n' "$rounding" | results --scale=4)"
+
+[ $status -eq 0 ] && echo "decimals: ok"
+exit $status
@@ -0,0 +1,102 @@
+#!/bin/sh
+# def binds one or more names in the global environment, returning the last
+# value; names can be rebound but builtins cannot, and a lookup that fails
+# names the symbol. The table is then grown to 20000 names, which must all
+# still resolve to their own values.
+#
+# usage: sh tests/def.sh [path/to/myclc]
+
+MYCLC=${1:-./myclc}
+. "$(dirname "$0")/lib.sh"
+status=0
+
+out=$("$MYCLC" <<'END' | grep '^>> .'
+(def x 5)
+x
+(+ x 1)
+(def x 6)
+x
+(def a 1 b 2 c 3)
+(+ a b c)
+(def p)
+(def 1 2)
+(def q 1 r)
+(def + 2)
+(def def 1)
+undefined
+(+ undefined 1)
+(def s (+ 1 2))
+s
+(def k 1)
+(def k (+ k 1))
+k
+(def f +)
+(f 1 2)
+(def d def)
+(d y 7)
+y
+(def t (def u 9))
+u
+(def v [1 2 3])
+(sum v)
+(def bigv (^ 2 100))
+(- bigv 1)
+(def lst (range 5))
+(sum lst)
+END
+)
+
+want=$(cat <<'END'
+>> 5
+>> 5
+>> 6
+>> 6
+>> 6
+>> 3
+>> 6
+>> Error: def takes pairs of names and values!
+>> Error: def takes pairs of names and values!
+>> Error: def takes pairs of names and values!
+>> Error: Cannot redefine builtin '+'!
+>> Error: Cannot redefine builtin 'def'!
+>> Error: Unbound symbol 'undefined'!
+>> Error: Unbound symbol 'undefined'!
+>> 3
+>> 3
+>> 1
+>> 2
+>> 2
+>> +
+>> 3
+>> def
+>> 7
+>> 7
+>> 9
+>> 9
+>> [1 2 3]
+>> 6
+>> 1267650600228229401496703205376
+>> 1267650600228229401496703205375
+>> [0 1 2 3 4]
+>> 10
+END
+)
+
+check def "$out" "$want" || status=1
+
+# 20000 names, every tenth one then redefined, then some looked up
+out=$(awk 'BEGIN {
+    for (i = 0; i < 20000; i++) { printf "(def c%d %d)\n", i, i }
+    for (i = 0; i < 20000; i += 10) { printf "(def c%d %d)\n", i, -i }
+    print "(+ c0 c1 c9 c10 c12345 c19990 c19999)"
+    print "c20000"
+}' | "$MYCLC" | grep '^>> .' | tail -2)
+
+want=$(printf '%s\n' ">> 12354" ">> Error: Unbound symbol 'c20000'!")
+if [ "$out" != "$want" ]; then
+    echo "def: with 20000 names, expected" "$want" "but got" "$out" >&2
+    status=1
+fi
+
+[ $status -eq 0 ] && echo "def: ok"
+exit $status
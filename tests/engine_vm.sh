@@ -0,0 +1,107 @@
+#!/bin/sh
+# The bytecode VM must print exactly what the tree walker prints, line for
+# line, including the errors, deferred lookups, redefinitions and tail calls
+# below.
+#
+# usage: sh tests/engine_vm.sh [path/to/myclc]
+
+MYCLC=${1:-./myclc}
+. "$(dirname "$0")/lib.sh"
+input=$(cat <<'END'
+(+ 1 2)
++ 1 2
+5
+(5)
+()
+(+)
+(def f (\ (x) (* x 2)))
+(f 4)
+f
+(f)
+((\ (x) x) 3)
+(if 1 2)
+(if 1 2 3)
+(if 0 2 3)
+(if (- 1 1) 2 (+ 3 4))
+(if + 1 2)
+(if q 1 2)
+(def d def)
+(d y 5)
+y
+(def loop (\ (n acc) (if (== n 0) acc (loop (- n 1) (+ acc (* 3 n))))))
+(loop 100000 0)
+(def fib (\ (n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2))))))
+(fib 20)
+(fib 1 2)
+(unbound 1 2)
+(+ 1 unbound)
+(+ x (def x 5))
+(+ x (def x 6))
+(def add +)
+(add 1 2 3)
+(def g (\ (a) (\ (b) (+ a b))))
+((g 1) 2)
+(def h (g 10))
+(h 5)
+(map (\ (x) (* 2 x)) (range 5))
+(sum (map (\ (x) (* x x)) (range 100)))
+(reduce + (range 10))
+(fold (\ (a b) (+ a b)) 0 [1 2 3])
+(pmap (\ (x) (+ x 1)) [1 2 3])
+(/ 7 6)
+(+ 0.1 0.2)
+(* 99999999999 99999999999 99999999999)
+(1 2 3)
+((+ 1 2) 3)
+(def even (\ (n) (if (== n 0) 1 (odd (- n 1)))) odd (\ (n) (if (== n 0) 0 (even (- n 1)))))
+(even 10001)
+(def k 7)
+k
+(k)
+(+ k k)
+(\ (x) x)
+(def id (\ (x) x))
+(id id)
+((id id) 4)
+(id)
+(if (id 0) 1 2)
+(def z (\ () 42))
+(z)
+z
+(def w (\ () z))
+((w))
+(def c (\ (x) (if x (c (- x 1)) (error))))
+(def c (\ (x) (if x (c (- x 1)) x)))
+(c 100000)
+[1 2 3]
+(+ [1 2 3] 1)
+(* [1 2; 3 4] 2)
+(if 1 (def qq 3) 4)
+qq
+(- (def r 2) r)
+(lambda (x y) (+ x y))
+((lambda (x y) (+ x y)) 3 4)
+(def p (\ (x) (+ x undefinedname)))
+(p 1)
+(\ 1 2)
+(if)
+(def)
+(def 1 2)
+(def + 2)
+(precision 100)
+(+ 1.0 2.0)
+(precision 53)
+(% 7 3)
+(^ 2 100)
+(powmod 2 100 7)
+(1.5)
+(- 5)
+(def s (\ (n) (if (> n 0) (+ n (s (- n 1))) 0)))
+(s 1000)
+END
+)
+
+tree=$(printf '%s\n' "$input" | "$MYCLC" --engine=tree)
+vm=$(printf '%s\n' "$input" | "$MYCLC" --engine=vm)
+check engine_vm "$vm" "$tree" "--engine=vm differs from --engine=tree" || exit 1
+echo "engine_vm: ok"
@@ -0,0 +1,106 @@
+#!/bin/sh
+# Lambdas: closures capture their environment, arity is checked, and
+# parameters shadow globals. Self and mutually recursive tail calls must
+# then run three million deep on a 256 KB C stack and 64 MB of address
+# space, under both engines.
+#
+# usage: sh tests/lambda.sh [path/to/myclc]
+
+MYCLC=${1:-./myclc}
+. "$(dirname "$0")/lib.sh"
+status=0
+
+out=$("$MYCLC" <<'END' | grep '^>> .'
+(\ (x) x)
+(lambda (x y) (+ x y))
+((\ (x) (* x x)) 7)
+((lambda (x y) (- x y)) 10 3)
+((\ () 42))
+(def sq (\ (x) (* x x)))
+(sq 12)
+(sq)
+(sq 1 2)
+(\ x x)
+(\ (1) x)
+(\ (x))
+(def adder (\ (a) (\ (b) (+ a b))))
+((adder 3) 4)
+(def add5 (adder 5))
+(add5 10)
+(def a 100)
+((adder 1) 1)
+(def shadow (\ (x) ((\ (x) (* x 10)) (+ x 1))))
+(shadow 1)
+(def apply2 (\ (f x) (f (f x))))
+(apply2 sq 3)
+(apply2 (\ (x) (+ x 1)) 3)
+(def fact (\ (n acc) (if (== n 0) acc (fact (- n 1) (* acc n)))))
+(fact 25 1)
+(def amort (\ (bal rate pay n) (if (== n 0) bal (amort (- (* bal (+ 1 rate)) pay) rate pay (- n 1)))))
+(amort 1000.00m 0.01m 100.00m 3)
+(def fib (\ (n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2))))))
+(fib 20)
+(def nt (\ (n) (if (== n 0) 0 (+ 1 (nt (- n 1))))))
+(nt 10000)
+(if 0 1)
+(if 1 2 3)
+(if 0 2 3)
+END
+)
+
+want=$(cat <<'END'
+>> (\ (x) x)
+>> (\ (x y) (+ x y))
+>> 49
+>> 7
+>> 42
+>> (\ (x) (* x x))
+>> 144
+>> Error: Function takes 1 arguments, got 0!
+>> Error: Function takes 1 arguments, got 2!
+>> Error: lambda takes a list of names and a body!
+>> Error: lambda takes a list of names and a body!
+>> Error: lambda takes a list of names and a body!
+>> (\ (a) (\ (b) (+ a b)))
+>> 7
+>> (\ (b) (+ a b))
+>> 15
+>> 100
+>> 2
+>> (\ (x) ((\ (x) (* x 10)) (+ x 1)))
+>> 20
+>> (\ (f x) (f (f x)))
+>> 81
+>> 5
+>> (\ (n acc) (if (== n 0) acc (fact (- n 1) (* acc n))))
+>> 15511210043330985984000000
+>> (\ (bal rate pay n) (if (== n 0) bal (amort (- (* bal (+ 1 rate)) pay) rate pay (- n 1))))
+>> 727.29
+>> (\ (n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))
+>> 6765
+>> (\ (n) (if (== n 0) 0 (+ 1 (nt (- n 1)))))
+>> 10000
+>> Error: if takes a condition, a then and an else!
+>> 2
+>> 3
+END
+)
+
+check lambda "$out" "$want" || status=1
+
+for engine in tree vm; do
+    out=$( (ulimit -s 256; ulimit -v 65536; "$MYCLC" --engine=$engine) <<'END' | grep '^>> .'
+(def count (\ (n) (if (== n 0) 0 (count (- n 1)))))
+(count 3000000)
+(def even (\ (n) (if (== n 0) 1 (odd (- n 1)))) odd (\ (n) (if (== n 0) 0 (even (- n 1)))))
+(even 3000001)
+END
+)
+    if [ "$(printf '%s\n' "$out" | sed -n '2p;4p' | tr '\n' ' ')" != ">> 0 >> 0 " ]; then
+        echo "lambda: tail calls under --engine=$engine did not run in constant space" >&2
+        status=1
+    fi
+done
+
+[ $status -eq 0 ] && echo "lambda: ok"
+exit $status
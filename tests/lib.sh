@@ -0,0 +1,13 @@
+# Helpers for the test scripts, which source this file after setting MYCLC.
+
+# check NAME GOT WANT [WHAT]: succeeds if GOT is WANT. Otherwise it reports
+# "NAME: WHAT:" (by default, unexpected output) and a diff from WANT to GOT
+# on stderr, and fails.
+check() {
+    [ "$2" = "$3" ] && return 0
+    echo "$1: ${4:-unexpected output}:" >&2
+    printf '%s\n' "$3" > "/tmp/$1.$$"
+    printf '%s\n' "$2" | diff "/tmp/$1.$$" - >&2
+    rm -f "/tmp/$1.$$"
+    return 1
+}
@@ -0,0 +1,92 @@
+#!/bin/sh
+# Integer literals in decimal and with 0x, 0b and 0o prefixes, negated, at
+# the int64 limits and past them into bignums, through every reader. A
+# literal ends at the first character that is not one of its digits, so
+# 0b102 reads as 0b10 followed by 2, and a prefix with no digits after it
+# is a 0 followed by a symbol.
+#
+# usage: sh tests/literals.sh [path/to/myclc]
+
+MYCLC=${1:-./myclc}
+. "$(dirname "$0")/lib.sh"
+status=0
+
+input=$(cat <<'END'
+0xff
+0xDeadBeef
+0b1010
+0o777
+0x0
+-0x10
+-0b11
+-0o17
+(+ 0x10 0b10 0o10 10)
+[0x10 0b11 -0o7]
+9223372036854775807
+9223372036854775808
+-9223372036854775808
+-9223372036854775809
+0x7fffffffffffffff
+0x8000000000000000
+-0x8000000000000000
+-0x8000000000000001
+0b111111111111111111111111111111111111111111111111111111111111111
+0b1111111111111111111111111111111111111111111111111111111111111111
+0o777777777777777777777
+0o1777777777777777777777
+0xffffffffffffffffffffffff
+-0xffffffffffffffffffffffff
+123456789012345678901234567890
+0b102
+[0b102]
+0o78
+0xfg
+0XFF
+0x
+(+ 0b 1)
+END
+)
+
+want=$(cat <<'END'
+>> 255
+>> 3735928559
+>> 10
+>> 511
+>> 0
+>> -16
+>> -3
+>> -15
+>> 36
+>> [16 3 -7]
+>> 9223372036854775807
+>> 9223372036854775808
+>> -9223372036854775808
+>> -9223372036854775809
+>> 9223372036854775807
+>> 9223372036854775808
+>> -9223372036854775808
+>> -9223372036854775809
+>> 9223372036854775807
+>> 18446744073709551615
+>> 9223372036854775807
+>> 18446744073709551615
+>> 79228162514264337593543950335
+>> -79228162514264337593543950335
+>> 123456789012345678901234567890
+>> Error: S-Expression does not begin with a symbol!
+>> [2 2]
+>> Error: S-Expression does not begin with a symbol!
+>> Error: Unbound symbol 'g'!
+>> Error: Unbound symbol 'XFF'!
+>> Error: Unbound symbol 'x'!
+>> Error: Unbound symbol 'b'!
+END
+)
+
+for reader in native fold ast; do
+    out=$(printf '%s\n' "$input" | "$MYCLC" --reader=$reader | grep '^>> .')
+    check literals "$out" "$want" "unexpected output with --reader=$reader" || status=1
+done
+
+[ $status -eq 0 ] && echo "literals: ok"
+exit $status
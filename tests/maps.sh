@@ -0,0 +1,100 @@
+#!/bin/sh
+# map and filter over a Vector give their values packed as pmap packs them:
+# a Vector if they all fit one, and a list otherwise. Over a Sequence they
+# are lazy, and print packed the same way, cut off with "..." after 100000
+# values, so printing a Sequence of 10^10 values neither runs out of memory
+# nor takes long. Sums, least and greatest
+# values of a range mapped through (+ x k), (- x k), (- k x) or (* k x) are
+# closed form even where the mapped range leaves int64, so the sums below of
+# 3e18 values finish at once rather than streaming: they run under a 10
+# second CPU limit.
+#
+# usage: sh tests/maps.sh [path/to/myclc]
+
+MYCLC=${1:-./myclc}
+. "$(dirname "$0")/lib.sh"
+
+out=$( (ulimit -t 10; "$MYCLC") <<'END' | grep '^>> .'
+(map (\ (x) (* 2 x)) [1 2 3])
+(map (\ (x) (/ x 2)) [1 2 3])
+(map (\ (x) (* x 0.5)) [1 2 3])
+(filter (\ (x) (> x 1)) [1.5 0.5 2])
+(filter (\ (x) (> x 9)) [1 2 3])
+(map (\ (x) (+ x 1)) (filter (\ (x) (% x 2)) [1 2 3 4 5]))
+(sum (map (\ (x) (* x x)) [1 2 3]))
+(map (\ (x) (* 2 x)) (range 5))
+(map (\ (x) (* x x)) (range 5))
+(filter (\ (x) (% x 3)) (range 10))
+(map (\ (x) (- 0 x)) (iterate (\ (x) (* 3 x)) 1 4))
+(map (\ (x) (/ x 2)) (range 4))
+(map (\ (x) (range x)) (range 3))
+(map (\ (x) (/ 1 x)) [1 0])
+(map (\ (x) (/ x 0)) (range 3))
+(map (\ (x) (* x 9223372036854775807)) [1 2])
+(map + 1)
+(filter (\ (x) x))
+(sum (map (\ (x) (* 3 x)) (range 3074457345618258603)))
+(sum (map (\ (x) (- 5 x)) (range -9223372036854775807 9223372036854775807)))
+(sum (map (\ (x) (+ x 9223372036854775807)) (range 10)))
+(sum (map (\ (x) (- x 9223372036854775807)) (range -10 0)))
+(min (map (\ (x) (* 3 x)) (range -3074457345618258603 3074457345618258603)))
+(max (map (\ (x) (* -3 x)) (range -3074457345618258603 3074457345618258603)))
+(reduce + (map (\ (x) (* 4 x)) (range 3074457345618258603)))
+(fold + 1 (map (\ (x) (* x 4611686018427387904)) (range 10)))
+(preduce + (map (\ (x) (* 3 x)) (range 3074457345618258603)))
+(prod (map (\ (x) (* x 4611686018427387904)) (range 1 4)))
+(sum (map (\ (x) (* 3 x)) (range 0)))
+END
+)
+
+want=$(cat <<'END'
+>> [2 4 6]
+>> (1/2 1 3/2)
+>> [0.5 1.0 1.5]
+>> [1.5 2.0]
+>> []
+>> [2 4 6]
+>> 14
+>> [0 2 4 6 8]
+>> [0 1 4 9 16]
+>> [1 2 4 5 7 8]
+>> [-1 -3 -9 -27]
+>> (0 1/2 1 3/2)
+>> ([] [0] [0 1])
+>> Error: Cannot divide by zero!
+>> Error: Cannot divide by zero!
+>> (9223372036854775807 18446744073709551614)
+>> Error: map takes a function and a sequence!
+>> Error: filter takes a function and a sequence!
+>> 14178431955039102642770046636847879509
+>> 101457092405402533877
+>> 92233720368547758115
+>> -92233720368547758125
+>> -9223372036854775809
+>> 9223372036854775809
+>> 18904575940052136857026728849130506012
+>> 207525870829232455681
+>> 14178431955039102642770046636847879509
+>> 588478287692501321609605258425718726509595822918503235584
+>> 0
+END
+)
+
+check maps "$out" "$want" || exit 1
+
+out=$( (ulimit -t 10; "$MYCLC") <<'END' | grep '^>> .' | awk '{ print NF - 1, $2, $(NF - 1), $NF }'
+(range 10000000000)
+(map (\ (x) (/ x 2)) (range 10000000000))
+(range 100000)
+(map (\ (x) (if (== x 100000) (/ 1 0) x)) (range 200000))
+END
+)
+want=$(cat <<'END'
+100001 [0 99999 ...]
+100001 (0 99999/2 ...)
+100000 [0 99998 99999]
+100001 [0 99999 ...]
+END
+)
+check maps "$out" "$want" "long sequences printed wrongly" || exit 1
+echo "maps: ok"
@@ -0,0 +1,102 @@
+#!/bin/sh
+# Matrix literals, element-wise arithmetic, transpose and matmul, with
+# their shape errors. The 70 x 90 and 90 x 110 products at the end are big
+# enough for the blocked kernels and leave ragged edges around their tiles;
+# they are reduced between weight vectors and checked against values
+# computed separately, and against (AB)^T = B^T A^T.
+#
+# usage: sh tests/matrices.sh [path/to/myclc]
+
+MYCLC=${1:-./myclc}
+. "$(dirname "$0")/lib.sh"
+
+# Park-Miller generator, exact in awk's doubles; rnd(n) is in [0, n)
+RAND='function rnd(n) { seed = (seed * 16807) % 2147483647; return seed % n }'
+
+# An R x C literal of digits from seed S
+matrix() {
+    awk "$RAND"' BEGIN {
+        seed = '"$3"'
+        printf "["
+        for (i = 0; i < '"$1"'; i++) {
+            for (j = 0; j < '"$2"'; j++) { printf " %d", rnd(10) }
+            printf ";"
+        }
+        printf "]"
+    }'
+}
+
+# A row (with SEP "") or column (with SEP ";") of the weights 1, 2, ..., N
+weights() {
+    awk 'BEGIN {
+        printf "["
+        for (i = 1; i <= '"$2"'; i++) { printf " %d'"$1"'", i }
+        printf "'"$1"'" == "" ? ";]" : "]"
+    }'
+}
+
+A=$(matrix 70 90 21)
+B=$(matrix 90 110 22)
+U=$(weights "" 70)
+V=$(weights ";" 110)
+UT=$(weights "" 110)
+VT=$(weights ";" 70)
+
+input=$(cat <<END
+[1 2; 3 4]
+[1.5 -2; 0 1e3]
+[1 2; 3]
+(matmul [1 2; 3 4] [5 6; 7 8])
+(matmul [1 2 3;] [4; 5; 6])
+(matmul [1 2; 3 4] [1 2; 3 4] [1 0; 0 1])
+(matmul [1 2; 3 4] [1 2 3;])
+(matmul [1 2; 3 4])
+(matmul [1 2; 3 4] [1 2])
+(transpose [1 2 3; 4 5 6])
+(transpose [1 2])
+(+ [1 2; 3 4] 1)
+(- 10 [1 2; 3 4])
+(* [1 2; 3 4] [1 2; 3 4])
+(/ [1 2; 3 4] 2)
+(/ [1 2; 3 4] 0)
+(+ [1 2; 3 4] [1 2 3; 4 5 6])
+(+ [1 2; 3 4] [1 2])
+(matmul $U (matmul $A $B) $V)
+(matmul $UT (transpose (matmul $A $B)) $VT)
+(matmul $UT (transpose $B) (transpose $A) $VT)
+END
+)
+
+want=$(cat <<'END'
+>> [1.0 2.0; 3.0 4.0]
+>> [1.5 -2.0; 0.0 1000.0]
+>> Error: Matrix rows differ in length!
+>> [19.0 22.0; 43.0 50.0]
+>> [32.0;]
+>> [7.0 10.0; 15.0 22.0]
+>> Error: Inner matrix dimensions differ!
+>> Error: matmul takes two or more matrices!
+>> Error: matmul takes two or more matrices!
+>> [1.0 4.0; 2.0 5.0; 3.0 6.0]
+>> Error: transpose takes one matrix!
+>> [2.0 3.0; 4.0 5.0]
+>> [9.0 8.0; 7.0 6.0]
+>> [1.0 4.0; 9.0 16.0]
+>> [0.5 1.0; 1.5 2.0]
+>> Error: Cannot divide by zero!
+>> Error: Matrix shapes differ!
+>> Error: Cannot mix vectors and matrices!
+>> [27562507368.0;]
+>> [27562507368.0;]
+>> [27562507368.0;]
+END
+)
+
+# Once as it comes, and once spread over four workers
+status=0
+for threads in "" --threads=4; do
+    out=$(printf '%s\n' "$input" | "$MYCLC" $threads | grep '^>> .')
+    check matrices "$out" "$want" "unexpected output ${threads:-by default}" || status=1
+done
+[ $status -eq 0 ] && echo "matrices: ok"
+exit $status
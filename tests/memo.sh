@@ -0,0 +1,58 @@
+#!/bin/sh
+# --memo=N caches the results of pure S-Expressions. The counters it prints
+# to stderr at exit must show the hits, misses and CLOCK evictions below,
+# and cached answers must be the ones evaluation gives.
+#
+# usage: sh tests/memo.sh [path/to/myclc]
+
+MYCLC=${1:-./myclc}
+. "$(dirname "$0")/lib.sh"
+status=0
+
+# Two entries. A hit marks (+ 1 2), so when (+ 1 4) needs room CLOCK passes
+# over it and evicts (+ 1 3) instead: the second (+ 1 2) hits and the second
+# (+ 1 3) misses. Plain FIFO would have evicted (+ 1 2).
+out=$(printf '%s\n' '(+ 1 2)' '(+ 1 3)' '(+ 1 2)' '(+ 1 4)' '(+ 1 2)' '(+ 1 3)' | "$MYCLC" --memo=2 2>&1 >/dev/null)
+check memo "$out" "memo: 2 hits, 4 misses, 2 evictions, 2/2 entries" "CLOCK counters" || status=1
+
+# Bignum results are not kept, so both lookups miss; the inner (+ 1 2) is
+# cached on its own and hits the second time; names make a line impure, so
+# it is never looked up at all
+out=$("$MYCLC" --memo=8 2>&1 <<'END' | grep '^>> .\|^memo:'
+(* 99999999999 99999999999)
+(* 99999999999 99999999999)
+(* (+ 1 2) (+ 1 2))
+(def x 5)
+(+ x 1)
+(+ x 1)
+END
+)
+want=$(cat <<'END'
+>> 9999999999800000000001
+>> 9999999999800000000001
+>> 9
+>> 5
+>> 6
+>> 6
+memo: 1 hits, 4 misses, 0 evictions, 2/8 entries
+END
+)
+check memo "$out" "$want" "what is cached" || status=1
+
+# Results with a small cache, constantly evicting, and a large one must be
+# those without the cache
+input=$(awk 'BEGIN {
+    split("+ - * / %", ops, " ")
+    for (l = 0; l < 3000; l++) {
+        k = l % 97
+        printf "(%s (* %d %d) (- %d %d))\n", ops[k % 5 + 1], k, k + 3, 100 - k, k % 7
+    }
+}')
+plain=$(printf '%s\n' "$input" | "$MYCLC" 2>/dev/null)
+for size in 16 4096; do
+    out=$(printf '%s\n' "$input" | "$MYCLC" --memo=$size 2>/dev/null)
+    check memo "$out" "$plain" "results differ with --memo=$size" || status=1
+done
+
+[ $status -eq 0 ] && echo "memo: ok"
+exit $status
@@ -0,0 +1,51 @@
+#!/bin/sh
+# Output is buffered. With --flush=line each result reaches the pipe as
+# soon as it is printed; with --flush=block only when the buffer fills or
+# at exit. Either way the bytes must be the same: 20000 short lines, which
+# fill the buffer several times, and a 84510-digit bignum between short
+# lines, which is too big for the buffer and goes out with writev together
+# with what the buffer holds.
+#
+# usage: sh tests/output.sh [path/to/myclc]
+
+MYCLC=${1:-./myclc}
+. "$(dirname "$0")/lib.sh"
+status=0
+
+# A result is visible before the end of input only when flushed per line
+for mode in line block; do
+    ( printf '(+ 1 2)\n'; sleep 2 ) | "$MYCLC" --flush=$mode > /tmp/output.$$ &
+    sleep 1
+    early=$(grep -c '^>> 3$' /tmp/output.$$)
+    wait
+    late=$(grep -c '^>> 3$' /tmp/output.$$)
+    want=$([ $mode = line ] && echo "1 1" || echo "0 1")
+    check output "$early $late" "$want" "--flush=$mode, results seen before and after exit" || status=1
+done
+rm -f /tmp/output.$$
+
+input=$(awk 'BEGIN {
+    for (i = 0; i < 20000; i++) { printf "(* %d %d)\n", i, i % 13 }
+    print "(+ 1 1)"
+    print "(^ 7 100000)"
+    print "(+ 2 2)"
+    print "(% (^ 7 100000) 1000000000000)"
+}')
+want=$(awk 'BEGIN {
+    for (i = 0; i < 20000; i++) { printf ">> %d\n", i * (i % 13) }
+    print ">> 2"
+    x = 100000 * log(7) / log(10)
+    printf ">> %d %d 128060000001\n", int(x) + 1, 10 ^ (x - int(x) + 7)
+    print ">> 4"
+    print ">> 128060000001"
+}')
+
+# The bignum is cut down to its length and its first and last digits
+for mode in line block; do
+    out=$(printf '%s\n' "$input" | "$MYCLC" --flush=$mode | grep '^>> .' |
+          awk 'length($2) > 1000 { $0 = ">> " length($2) " " substr($2, 1, 8) " " substr($2, length($2) - 11) } { print }')
+    check output "$out" "$want" "unexpected output with --flush=$mode" || status=1
+done
+
+[ $status -eq 0 ] && echo "output: ok"
+exit $status
@@ -0,0 +1,78 @@
+#!/bin/sh
+# pmap and preduce must give what map and reduce would, in order, however
+# the pool splits the work: the cases run once with a thread per CPU and
+# once with four threads. Taking the first or last of two values is
+# associative but not commutative, so preduce with either shows whether the
+# partial results are folded back in order, and the first error in order is
+# the one reported. Results that do not all fit a Vector, such as bignums
+# and rationals, come back as a list.
+#
+# usage: sh tests/pmap.sh [path/to/myclc]
+
+MYCLC=${1:-./myclc}
+. "$(dirname "$0")/lib.sh"
+status=0
+
+input=$(cat <<'END'
+(pmap (\ (x) (* x x)) [1 2 3 4])
+(pmap (\ (x) (* x 0.5)) (range 4))
+(pmap (\ (x) (+ x 1)) (range 0))
+(pmap - (iterate (\ (x) (* 2 x)) 1 5))
+(pmap (\ (x) (* x 10)) (filter (\ (x) (% x 2)) (range 10)))
+(sum (pmap (\ (x) (* x x)) (range 100000)))
+(preduce (\ (a b) b) (pmap (\ (x) (- 0 x)) (range 100000)))
+(pmap (\ (x) (if (== x 5000) (/ 1 0) (if (== x 90000) (x 1) x))) (range 100000))
+(pmap (\ (x) (* x 9223372036854775807)) [1 2])
+(pmap (\ (x) (/ x 2)) (range 4))
+(pmap (\ (x) (* x 1.5m)) [1 2])
+(pmap (\ (x) x))
+(pmap 1 [1 2])
+(preduce + (range 1 101))
+(preduce * (range 1 21))
+(preduce + (map (\ (x) (* 3 x)) (range 3074457345618258603)))
+(preduce (\ (a b) a) (range 7 100000))
+(preduce (\ (a b) b) (range 7 100000))
+(preduce (\ (a b) (+ a b)) (map (\ (x) (* x x)) (range 1000)))
+(preduce (\ (a b) (if (> a b) a b)) [3 9 2 7])
+(preduce + [1.5 2.5])
+(preduce + (range 0))
+(preduce (\ (a b) (/ a 0)) (range 10))
+(preduce +)
+END
+)
+
+want=$(cat <<'END'
+>> [1 4 9 16]
+>> [0.0 0.5 1.0 1.5]
+>> []
+>> [-1 -2 -4 -8 -16]
+>> [10 30 50 70 90]
+>> 333328333350000
+>> -99999
+>> Error: Cannot divide by zero!
+>> (9223372036854775807 18446744073709551614)
+>> (0 1/2 1 3/2)
+>> (1.50 3.00)
+>> Error: pmap takes a function and a sequence!
+>> Error: pmap takes a function and a sequence!
+>> 5050
+>> 2432902008176640000
+>> 14178431955039102642770046636847879509
+>> 7
+>> 99999
+>> 332833500
+>> 9
+>> 4.0
+>> Error: preduce of an empty sequence!
+>> Error: Cannot divide by zero!
+>> Error: preduce takes a function and a sequence!
+END
+)
+
+for flags in "" --threads=4; do
+    out=$(printf '%s\n' "$input" | "$MYCLC" $flags | grep '^>> .')
+    check pmap "$out" "$want" "unexpected output with '$flags'" || status=1
+done
+
+[ $status -eq 0 ] && echo "pmap: ok"
+exit $status
@@ -0,0 +1,80 @@
+#!/bin/sh
+# % truncates like C's, ^ and pow square their way up and promote to
+# bignums at the int64_t limit, and powmod must agree with exact modular
+# arithmetic for moduli up to 64 bits and bignum bases.
+#
+# usage: sh tests/powers.sh [path/to/myclc]
+
+MYCLC=${1:-./myclc}
+. "$(dirname "$0")/lib.sh"
+
+out=$("$MYCLC" <<'END' | grep '^>> .'
+(% 10 3)
+(% -10 3)
+(% 10 -3)
+(% 10 0)
+(% 7.5 2)
+(% -9223372036854775808 -1)
+(^ 2 10)
+(pow 2 10)
+(^ 2 62)
+(^ 2 63)
+(^ -2 63)
+(^ -3 3)
+(^ 0 0)
+(^ 5 0)
+(^ 2 -1)
+(^ 0 -1)
+(^ 1 -5)
+(^ -1 -5)
+(^ 10 30)
+(^ 2.0 10)
+(^ 2 0.5)
+(powmod 2 100 7)
+(powmod 3 200 1000000007)
+(powmod 2 10 1)
+(powmod 2 -1 7)
+(powmod 2 10 0)
+(powmod -2 3 5)
+(powmod 123456789 987654321 18446744073709551557)
+(powmod 12345678901234567 98765 9223372036854775783)
+(powmod (^ 10 30) 5 1000000007)
+END
+)
+
+want=$(cat <<'END'
+>> 1
+>> -1
+>> 1
+>> Error: Cannot divide by zero!
+>> 1.5
+>> 0
+>> 1024
+>> 1024
+>> 4611686018427387904
+>> 9223372036854775808
+>> -9223372036854775808
+>> -27
+>> 1
+>> 1
+>> 1/2
+>> Error: Cannot divide by zero!
+>> 1
+>> -1
+>> 1000000000000000000000000000000
+>> 1024.0
+>> 1.4142135623730951
+>> 2
+>> 136318165
+>> 0
+>> Error: powmod takes a non-negative exponent!
+>> Error: Cannot divide by zero!
+>> 2
+>> 13340410239862665191
+>> 1031180576214028554
+>> 970487648
+END
+)
+
+check powers "$out" "$want" || exit 1
+echo "powers: ok"
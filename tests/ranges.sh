@@ -0,0 +1,87 @@
+#!/bin/sh
+# Ranges and iterate are lazy: they are only made to print them, and
+# reductions over them either take a closed form or stream the values. The
+# streaming cases at the end run a million values each in 64 MB of address
+# space, which a million materialised lvals would not fit.
+#
+# usage: sh tests/ranges.sh [path/to/myclc]
+
+MYCLC=${1:-./myclc}
+. "$(dirname "$0")/lib.sh"
+status=0
+
+out=$("$MYCLC" <<'END' | grep '^>> .'
+(range 5)
+(range 2 5)
+(range 10 0 -3)
+(range 0)
+(range 5 2)
+(range 1 2 0)
+(range 1.5)
+(range 1 2 3 4)
+(iterate (\ (x) (* 2 x)) 1 5)
+(sum (range 1 1000000001))
+(sum (range 1000000000))
+(sum (range 10 0 -3))
+(sum (range 0))
+(sum (range -9223372036854775807 9223372036854775807))
+(sum (range 9223372036854775800 9223372036854775807))
+(prod (range 1 21))
+(prod (range 1 31))
+(min (range 5 100 7))
+(max (range 5 100 7))
+(max (range 0))
+(reduce + (range 101))
+(reduce + (range 0))
+(fold + 0 (range 101))
+(fold (\ (a x) (+ a (* x x))) 0 (range 1000001))
+(sum (iterate (\ (x) (* 2 x)) 1 64))
+END
+)
+
+want=$(cat <<'END'
+>> [0 1 2 3 4]
+>> [2 3 4]
+>> [10 7 4 1]
+>> []
+>> []
+>> Error: range takes a non-zero step!
+>> Error: range takes integers!
+>> Error: range takes integers!
+>> [1 2 4 8 16]
+>> 500000000500000000
+>> 499999999500000000
+>> 22
+>> 0
+>> -9223372036854775807
+>> 64563604257983430621
+>> 2432902008176640000
+>> 265252859812191058636308480000000
+>> 5
+>> 96
+>> Error: max of an empty sequence!
+>> 5050
+>> Error: reduce of an empty sequence!
+>> 5050
+>> 333333833333500000
+>> 18446744073709551615
+END
+)
+
+check ranges "$out" "$want" || status=1
+
+out=$( (ulimit -v 65536; "$MYCLC") <<'END' | grep '^>> .' | tr '\n' ' '
+(reduce + (range 1000000))
+(fold (\ (a x) (+ a x)) 0 (range 1000000))
+(reduce + (iterate (\ (x) (+ x 1)) 0 1000000))
+(sum (filter (\ (x) (< x 10)) (range 1000000)))
+END
+)
+want=">> 499999500000 >> 499999500000 >> 499999500000 >> 45 "
+if [ "$out" != "$want" ]; then
+    echo "ranges: streaming in 64 MB, expected '$want' but got '$out'" >&2
+    status=1
+fi
+
+[ $status -eq 0 ] && echo "ranges: ok"
+exit $status
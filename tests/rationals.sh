@@ -0,0 +1,68 @@
+#!/bin/sh
+# Inexact integer division must give an exact fraction in lowest terms with
+# a positive denominator, exact divisions must stay integers, and fractions
+# that reduce to whole numbers must come back as integers.
+#
+# usage: sh tests/rationals.sh [path/to/myclc]
+
+MYCLC=${1:-./myclc}
+. "$(dirname "$0")/lib.sh"
+
+out=$("$MYCLC" <<'END' | grep '^>> .'
+(/ 7 6)
+(/ 6 3)
+(/ -6 4)
+(/ 6 -4)
+(/ 0 5)
+(/ 1 0)
+(/ 10 4 5)
+(/ 1 2 0)
+(+ (/ 1 3) (/ 1 6))
+(* (/ 2 3) (/ 3 2))
+(- (/ 1 2) (/ 1 2))
+(/ (/ 1 3) 3)
+(+ (/ 1 3) 1)
+(+ (/ 1 2) 0.25)
+(< (/ 1 3) (/ 1 2))
+(== (/ 2 4) (/ 1 2))
+(% (/ 7 2) 2)
+(^ (/ 2 3) 3)
+(^ (/ 2 3) -2)
+(/ (^ 2 100) (^ 6 50))
+(/ 9223372036854775807 -9223372036854775808)
+(/ -9223372036854775808 -1)
+(+ (/ 1 9223372036854775807) (/ 1 9223372036854775806))
+(sum (map (\ (x) (/ 1 (+ x 1))) (range 10)))
+END
+)
+
+want=$(cat <<'END'
+>> 7/6
+>> 2
+>> -3/2
+>> -3/2
+>> 0
+>> Error: Cannot divide by zero!
+>> 1/2
+>> Error: Cannot divide by zero!
+>> 1/2
+>> 1
+>> 0
+>> 1/9
+>> 4/3
+>> 0.75
+>> 1
+>> 1
+>> 3/2
+>> 8/27
+>> 9/4
+>> 1125899906842624/717897987691852588770249
+>> -9223372036854775807/9223372036854775808
+>> 9223372036854775808
+>> 18446744073709551613/85070591730234615838173535747377725442
+>> 7381/2520
+END
+)
+
+check rationals "$out" "$want" || exit 1
+echo "rationals: ok"
@@ -0,0 +1,71 @@
+#!/bin/sh
+# The native reader must report every malformed line exactly as the two mpc
+# readers do, with the same position and list of expected tokens, and read
+# every well-formed one the same way. The fixed cases below are followed by
+# 3000 fixed-seed random lines of tokens and fragments, most of them bad.
+#
+# usage: sh tests/readers.sh [path/to/myclc]
+
+MYCLC=${1:-./myclc}
+. "$(dirname "$0")/lib.sh"
+
+# Park-Miller generator, exact in awk's doubles; rnd(n) is in [0, n)
+RAND='function rnd(n) { seed = (seed * 16807) % 2147483647; return seed % n }'
+
+input=$(cat <<'END'
+(+ 1 2
+(+ 1 2))
+)
+(
+[1 2
+[1 2; 3
+[1 (+ 1 2)]
+[a]
+(+ 1 #)
+1.
+1e
+1e+
+-
+--1
+- 1
+(- -)
+1.5m
+1.5mm
+(+ 1 2) (+ 3 4)
+(\ (x) x
+"abc"
+;
+[]
+[;]
+[1 2;;]
+(+ 1 [1 2)
+((((
+))))
+0x
+1.2.3
+(+ 1 2)extra
+   (+ 1 2)   
+(+	1	2)
+(+ 1 2 ; comment
+END
+)
+input=$(printf '%s\n' "$input"; awk "$RAND"' BEGIN {
+    seed = 17
+    n = split("( ) [ ] ; - . 0 1 9 e m x b o + * / a (+ (- [1 0x 0b1 1.5 2e3 1m", t, " ")
+    for (l = 0; l < 3000; l++) {
+        s = ""
+        k = rnd(12) + 1
+        for (i = 0; i < k; i++) { s = s t[rnd(n) + 1] (rnd(3) ? "" : " ") }
+        print s
+    }
+}')
+
+native=$(printf '%s\n' "$input" | "$MYCLC" --reader=native 2>&1)
+status=0
+for reader in ast fold; do
+    out=$(printf '%s\n' "$input" | "$MYCLC" --reader=$reader 2>&1)
+    check readers "$native" "$out" "--reader=native differs from --reader=$reader" || status=1
+done
+
+[ $status -eq 0 ] && echo "readers: ok"
+exit $status
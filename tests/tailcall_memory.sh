@@ -0,0 +1,29 @@
+#!/bin/sh
+# Tail calls must run in constant memory even when their arguments are too
+# big for the arena's size classes. Each loop below replaces a 160 KB Vector
+# or a 37 KB bignum 20000 times, which needs gigabytes if the old argument
+# is not freed, so it is run with its address space capped well short of
+# that.
+#
+# usage: sh tests/tailcall_memory.sh [path/to/myclc]
+
+MYCLC=${1:-./myclc}
+LIMIT_KB=262144
+
+out=$( (ulimit -v $LIMIT_KB; "$MYCLC" --threads=1) <<'END'
+(def vl (\ (n v) (if (== n 0) (sum v) (vl (- n 1) (+ v 1)))))
+(vl 20000 (pmap (\ (x) x) (range 20000)))
+(def bl (\ (n b) (if (== n 0) (% b 7) (bl (- n 1) (+ b 1)))))
+(bl 20000 (^ 2 300000))
+END
+)
+
+status=0
+for want in ">> 599990000" ">> 2"; do
+    if ! printf '%s\n' "$out" | grep -qx -- "$want"; then
+        echo "tailcall_memory: expected '$want' within $LIMIT_KB KB" >&2
+        status=1
+    fi
+done
+[ $status -eq 0 ] && echo "tailcall_memory: ok"
+exit $status
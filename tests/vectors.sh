@@ -0,0 +1,109 @@
+#!/bin/sh
+# Element-wise arithmetic on Vectors must broadcast scalars, keep integers
+# exact and report any lane that overflows int64_t, including a bignum
+# scalar, which fits no lane; inexact integer division and float operands
+# give float Vectors. The 1000-element cases run the SIMD kernels.
+#
+# usage: sh tests/vectors.sh [path/to/myclc]
+
+MYCLC=${1:-./myclc}
+. "$(dirname "$0")/lib.sh"
+
+out=$("$MYCLC" <<'END' | grep '^>> .'
+[1 2 3]
+[]
+[1.5 2 3]
+(+ [1 2 3] [10 20 30])
+(- [1 2 3] 1)
+(- 10 [1 2 3])
+(* [1 2 3] [4 5 6])
+(+ [1 2 3] [1 2 3] [1 2 3])
+(/ [2 4 6] 2)
+(/ [1 2 3] 2)
+(/ [1 2 3] 0)
+(/ [1 2 3] [1 0 1])
+(+ [1 2 3] 0.5)
+(* [1.5 2.5] [2 4])
+(+ [1 2] (/ 1 2))
+(+ [1 2] [1 2 3])
+(+ [9223372036854775807 1] 1)
+(* [4611686018427387904 1] 2)
+(- [-9223372036854775807 0] 2)
+(+ [1 2] 99999999999999999999)
+(* 99999999999999999999 [1 2])
+(/ [1 2] 99999999999999999999)
+(+ [1.5 2] 99999999999999999999)
+(sum [1 2 3])
+(sum [])
+(sum [0.1 0.2])
+(prod [1 2 3 4])
+(prod [4294967296 4294967296])
+(min [3 1 2])
+(max [1.5 -2 3.25])
+(== [1 2] [1 2])
+(def big (\ () (pmap (\ (x) (- (* 7 x) 500)) (range 1000))))
+(sum (+ (big) 1))
+(sum (* (big) (big)))
+(sum (- (big) (big)))
+(max (big))
+(min (big))
+(sum (/ (* (big) 2) 2))
+(sum (/ (big) 2.0))
+(max (* (big) 0.5))
+(+ (pmap (\ (x) (if (== x 77) 9223372036854775807 x)) (range 100)) 1)
+(* (pmap (\ (x) (if (== x 93) 4294967296 x)) (range 100)) (pmap (\ (x) (if (== x 93) 4294967296 1)) (range 100)))
+(prod (pmap (\ (x) (if (< x 62) 2 1)) (range 100)))
+(prod (pmap (\ (x) (if (< x 63) 2 1)) (range 100)))
+END
+)
+
+want=$(cat <<'END'
+>> [1 2 3]
+>> []
+>> [1.5 2.0 3.0]
+>> [11 22 33]
+>> [0 1 2]
+>> [9 8 7]
+>> [4 10 18]
+>> [3 6 9]
+>> [1 2 3]
+>> [0.5 1.0 1.5]
+>> Error: Cannot divide by zero!
+>> Error: Cannot divide by zero!
+>> [1.5 2.5 3.5]
+>> [3.0 10.0]
+>> [1.5 2.5]
+>> Error: Vector lengths differ!
+>> Error: Integer overflow in vector!
+>> Error: Integer overflow in vector!
+>> Error: Integer overflow in vector!
+>> Error: Integer overflow in vector!
+>> Error: Integer overflow in vector!
+>> Error: Integer overflow in vector!
+>> [100000000000000000000.0 100000000000000000000.0]
+>> 6
+>> 0
+>> 0.30000000000000004
+>> 24
+>> 18446744073709551616
+>> 1
+>> 3.25
+>> Error: Cannot compare vectors or matrices!
+>> (\ () (pmap (\ (x) (- (* 7 x) 500)) (range 1000)))
+>> 2997500
+>> 13062341500
+>> 0
+>> 6493
+>> -500
+>> 2996500
+>> 1498250.0
+>> 3246.5
+>> Error: Integer overflow in vector!
+>> Error: Integer overflow in vector!
+>> 4611686018427387904
+>> 9223372036854775808
+END
+)
+
+check vectors "$out" "$want" || exit 1
+echo "vectors: ok"